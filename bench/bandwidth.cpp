@@ -0,0 +1,131 @@
+#include "bench.h"
+
+// Transfers caused by accessors of each mode.
+// A single work item touches the buffer, so the time is dominated by
+// copying the buffer to the device before the kernel (host to device)
+// and to the host for a host accessor afterwards (device to host).
+// Only read and read_write upload the buffer. The write and discard modes
+// don't transfer anything to the device,
+// so they only report the time of the submission as kernel_only.
+
+namespace bench {
+
+using cl::sycl::access::mode;
+
+static const char* mode_name(mode m) {
+  switch (m) {
+    case mode::read:
+      return "read";
+    case mode::write:
+      return "write";
+    case mode::read_write:
+      return "read_write";
+    case mode::discard_write:
+      return "discard_write";
+    case mode::discard_read_write:
+      return "discard_read_write";
+    default:
+      return "other";
+  }
+}
+
+static double gb_per_s(size_t bytes, double us) {
+  return us > 0 ? bytes / us / 1000.0 : 0;
+}
+
+template <mode m>
+static void touch(cl::sycl::queue& q, cl::sycl::buffer<float>& data,
+                  cl::sycl::buffer<float>& out) {
+  using namespace cl::sycl;
+  q.submit([&](handler& cgh) {
+    auto d = data.get_access<m>(cgh);
+    auto o = out.get_access<access::mode::discard_write>(cgh);
+    cgh.single_task<class touch_kernel>([=]() {
+      d[0] = 1;
+      o[0] = 0;
+    });
+  });
+}
+
+template <>
+void touch<mode::read>(cl::sycl::queue& q, cl::sycl::buffer<float>& data,
+                       cl::sycl::buffer<float>& out) {
+  using namespace cl::sycl;
+  q.submit([&](handler& cgh) {
+    auto d = data.get_access<access::mode::read>(cgh);
+    auto o = out.get_access<access::mode::discard_write>(cgh);
+    cgh.single_task<class read_kernel>([=]() { o[0] = d[0]; });
+  });
+}
+
+template <mode m>
+static json_object measure(cl::sycl::queue& q, size_t count, int iterations) {
+  using namespace cl::sycl;
+
+  buffer<float> data(count);
+  buffer<float> out(1);
+  auto bytes = count * sizeof(float);
+  bool writes = (m != mode::read);
+  bool uploads = (m == mode::read || m == mode::read_write);
+
+  // Compiles the kernel
+  touch<m>(q, data, out);
+  q.wait();
+
+  samples to_device;
+  samples to_host;
+  for (int i = 0; i < iterations; ++i) {
+    {
+      // Makes the host data newer than the device data without a transfer
+      auto h = data.get_access<access::mode::discard_write,
+                               access::target::host_buffer>();
+      h[0] = 0;
+    }
+
+    auto start = clock::now();
+    touch<m>(q, data, out);
+    q.wait();
+    to_device.add(clock::now() - start);
+
+    if (writes) {
+      start = clock::now();
+      auto h = data.get_access<access::mode::read,
+                               access::target::host_buffer>();
+      to_host.add(clock::now() - start);
+    }
+  }
+
+  json_object r;
+  r.add("mode", mode_name(m)).add("bytes", bytes).add("iterations", iterations);
+  if (uploads) {
+    r.add("host_to_device", to_device)
+        .add("host_to_device_gb_per_s", gb_per_s(bytes, to_device.median()));
+  } else {
+    r.add("kernel_only", to_device);
+  }
+  if (writes) {
+    r.add("device_to_host", to_host)
+        .add("device_to_host_gb_per_s", gb_per_s(bytes, to_host.median()));
+  }
+  return r;
+}
+
+results bandwidth(cl::sycl::queue& q, const options& opt) {
+  int iterations = opt.quick ? 3 : 10;
+  std::vector<size_t> sizes = {1 << 18, 1 << 22};  // Floats
+  if (!opt.quick) {
+    sizes.push_back(1 << 24);
+  }
+
+  results r;
+  for (auto count : sizes) {
+    r.push_back(measure<mode::read>(q, count, iterations));
+    r.push_back(measure<mode::write>(q, count, iterations));
+    r.push_back(measure<mode::read_write>(q, count, iterations));
+    r.push_back(measure<mode::discard_write>(q, count, iterations));
+    r.push_back(measure<mode::discard_read_write>(q, count, iterations));
+  }
+  return r;
+}
+
+}  // namespace bench
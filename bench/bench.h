@@ -0,0 +1,116 @@
+#pragma once
+
+// Micro-benchmarks of the runtime's own costs
+
+#include <CL/sycl.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+using clock = std::chrono::steady_clock;
+
+inline double to_us(clock::duration d) {
+  return std::chrono::duration<double, std::micro>(d).count();
+}
+
+/** Repeated measurements of the same thing, in microseconds */
+class samples {
+ private:
+  std::vector<double> values;
+
+ public:
+  void add(double us) {
+    values.push_back(us);
+  }
+  void add(clock::duration d) {
+    add(to_us(d));
+  }
+
+  double mean() const {
+    double sum = 0;
+    for (auto v : values) {
+      sum += v;
+    }
+    return values.empty() ? 0 : sum / values.size();
+  }
+  double median() const {
+    if (values.empty()) {
+      return 0;
+    }
+    auto sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+    return sorted[sorted.size() / 2];
+  }
+  double min() const {
+    return values.empty() ? 0 : *std::min_element(values.begin(), values.end());
+  }
+};
+
+/** Flat JSON object, values are stored already encoded */
+class json_object {
+ private:
+  std::vector<std::pair<std::string, std::string>> fields;
+
+ public:
+  json_object& add(const std::string& key, double value) {
+    std::ostringstream os;
+    os << value;
+    fields.emplace_back(key, os.str());
+    return *this;
+  }
+  json_object& add(const std::string& key, const std::string& value) {
+    std::string quoted = "\"";
+    for (auto c : value) {
+      if (c == '"' || c == '\\') {
+        quoted += '\\';
+      }
+      quoted += c;
+    }
+    fields.emplace_back(key, quoted + '"');
+    return *this;
+  }
+  json_object& add(const std::string& key, const char* value) {
+    return add(key, std::string(value));
+  }
+  json_object& add(const std::string& key, const samples& s) {
+    json_object stats;
+    stats.add("mean_us", s.mean())
+        .add("median_us", s.median())
+        .add("min_us", s.min());
+    fields.emplace_back(key, stats.str());
+    return *this;
+  }
+
+  std::string str() const {
+    std::string s = "{";
+    for (auto& f : fields) {
+      if (s.size() > 1) {
+        s += ", ";
+      }
+      s += '"' + f.first + "\": " + f.second;
+    }
+    return s + '}';
+  }
+};
+
+struct options {
+  /** Fewer iterations and smaller sizes */
+  bool quick = false;
+};
+
+using results = std::vector<json_object>;
+using benchmark_f = results (*)(cl::sycl::queue& q, const options& opt);
+
+results submit_latency(cl::sycl::queue& q, const options& opt);
+results trace_codegen(cl::sycl::queue& q, const options& opt);
+results bandwidth(cl::sycl::queue& q, const options& opt);
+results dependency_tracking(cl::sycl::queue& q, const options& opt);
+results sort(cl::sycl::queue& q, const options& opt);
+
+}  // namespace bench
@@ -0,0 +1,51 @@
+#include "bench.h"
+
+// Submission cost depending on how many other buffers are alive,
+// all of them known to the task graph because a kernel has used them
+
+namespace bench {
+
+results dependency_tracking(cl::sycl::queue& q, const options& opt) {
+  using namespace cl::sycl;
+
+  int iterations = opt.quick ? 50 : 200;
+  std::vector<size_t> live_counts = {0, 16, 128};
+  if (!opt.quick) {
+    live_counts.push_back(1024);
+  }
+
+  results r;
+  for (auto live : live_counts) {
+    std::vector<buffer<int>> others;
+    others.reserve(live);
+    for (size_t i = 0; i < live; ++i) {
+      others.emplace_back(range<1>(1));
+      auto& other = others.back();
+      q.submit([&](handler& cgh) {
+        auto o = other.get_access<access::mode::discard_write>(cgh);
+        cgh.single_task<class register_buffer>([=]() { o[0] = 0; });
+      });
+    }
+    q.wait();
+
+    buffer<int> data(1);
+    samples submit;
+    for (int i = 0; i < iterations; ++i) {
+      auto start = clock::now();
+      q.submit([&](handler& cgh) {
+        auto d = data.get_access<access::mode::read_write>(cgh);
+        cgh.single_task<class tracked_kernel>([=]() { d[0] += 1; });
+      });
+      submit.add(clock::now() - start);
+    }
+    q.wait();
+
+    r.push_back(json_object()
+                    .add("live_buffers", live)
+                    .add("iterations", iterations)
+                    .add("submit", submit));
+  }
+  return r;
+}
+
+}  // namespace bench
@@ -0,0 +1,76 @@
+#include "bench.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Usage: sycl-gtx-bench [--cpu] [--quick] [output.json]
+// Results go to the standard output if no file is given.
+
+int main(int argc, char* argv[]) {
+  using namespace cl::sycl;
+
+  bench::options opt;
+  bool cpu = false;
+  const char* output = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--cpu") == 0) {
+      cpu = true;
+    } else if (std::strcmp(argv[i], "--quick") == 0) {
+      opt.quick = true;
+    } else {
+      output = argv[i];
+    }
+  }
+
+  static const std::pair<const char*, bench::benchmark_f> benchmarks[] = {
+      {"submit_latency", bench::submit_latency},
+      {"trace_codegen", bench::trace_codegen},
+      {"bandwidth", bench::bandwidth},
+      {"dependency_tracking", bench::dependency_tracking},
+      {"sort", bench::sort}};
+
+  std::ostringstream json;
+  try {
+    // A CPU implementation such as PoCL works on machines without a GPU
+    std::unique_ptr<queue> q(cpu ? new queue(cpu_selector()) : new queue());
+    auto dev = q->get_device();
+
+    json << "{\n  \"device\": "
+         << bench::json_object()
+                .add("name", dev.get_info<info::device::name>())
+                .add("version", dev.get_info<info::device::device_version>())
+                .str()
+         << ",\n  \"benchmarks\": {";
+
+    bool first = true;
+    for (auto& b : benchmarks) {
+      std::cerr << "Running " << b.first << std::endl;
+      json << (first ? "\n" : ",\n") << "    \"" << b.first << "\": [";
+      first = false;
+
+      bool first_result = true;
+      for (auto& r : b.second(*q, opt)) {
+        json << (first_result ? "\n" : ",\n") << "      " << r.str();
+        first_result = false;
+      }
+      json << "\n    ]";
+    }
+    json << "\n  }\n}\n";
+  } catch (cl::sycl::exception& e) {
+    std::cerr << "SYCL error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  if (output == nullptr) {
+    std::cout << json.str();
+    return 0;
+  }
+  std::ofstream file(output);
+  file << json.str();
+  if (!file) {
+    std::cerr << "Cannot write " << output << std::endl;
+    return 1;
+  }
+  return 0;
+}
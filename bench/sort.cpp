@@ -0,0 +1,91 @@
+#include "bench.h"
+
+#include <SYCL/algorithm/sort.h>
+
+#include <random>
+#include <type_traits>
+
+// Radix sort on the device against std::sort on the host.
+// The device time includes the kernels and scans of all passes
+// but not the transfers, the keys are on the device before it starts.
+// The host sorts a copy of the same keys each time.
+
+namespace bench {
+
+template <typename K>
+static std::vector<K> random_keys(size_t count) {
+  using distribution =
+      typename std::conditional<std::is_floating_point<K>::value,
+                                std::uniform_real_distribution<K>,
+                                std::uniform_int_distribution<K>>::type;
+  std::mt19937_64 generator(count);
+  distribution values;
+  std::vector<K> keys(count);
+  for (auto& k : keys) {
+    k = values(generator);
+  }
+  return keys;
+}
+
+template <typename K>
+static json_object measure(cl::sycl::queue& q, const char* type,
+                           size_t count, int iterations) {
+  using namespace cl::sycl;
+
+  auto keys = random_keys<K>(count);
+  samples device;
+  samples host;
+  for (int i = 0; i < iterations; ++i) {
+    buffer<K> data(count);
+    {
+      auto d = data.template get_access<access::mode::discard_write,
+                                        access::target::host_buffer>();
+      for (size_t j = 0; j < count; ++j) {
+        d[j] = keys[j];
+      }
+    }
+    // Moves the keys to the device
+    q.submit([&](handler& cgh) {
+      auto d = data.template get_access<access::mode::read_write>(cgh);
+      cgh.single_task<class sort_touch>([=]() { d[0] = d[0]; });
+    });
+    q.wait();
+
+    auto start = clock::now();
+    cl::sycl::sort(q, data);
+    device.add(clock::now() - start);
+
+    auto copy = keys;
+    start = clock::now();
+    std::sort(copy.begin(), copy.end());
+    host.add(clock::now() - start);
+  }
+
+  json_object r;
+  r.add("type", type)
+      .add("count", count)
+      .add("iterations", iterations)
+      .add("device", device)
+      .add("host_std_sort", host)
+      .add("speedup", device.median() > 0 ? host.median() / device.median()
+                                          : 0);
+  return r;
+}
+
+results sort(cl::sycl::queue& q, const options& opt) {
+  int iterations = opt.quick ? 2 : 5;
+  std::vector<size_t> sizes = {1 << 16, 1 << 20};
+  if (!opt.quick) {
+    sizes.push_back(1 << 23);
+  }
+
+  results r;
+  for (auto count : sizes) {
+    r.push_back(measure<::cl_uint>(q, "uint", count, iterations));
+    r.push_back(measure<float>(q, "float", count, iterations));
+    r.push_back(measure<::cl_long>(q, "long", count, iterations));
+  }
+  return r;
+}
+
+}  // namespace bench
@@ -0,0 +1,45 @@
+#include "bench.h"
+
+// Cost of submitting a kernel that does next to nothing,
+// once the kernel is in the kernel cache
+
+namespace bench {
+
+results submit_latency(cl::sycl::queue& q, const options& opt) {
+  using namespace cl::sycl;
+
+  int iterations = opt.quick ? 100 : 1000;
+  buffer<int> data(1);
+
+  auto submit = [&]() {
+    q.submit([&](handler& cgh) {
+      auto d = data.get_access<access::mode::discard_write>(cgh);
+      cgh.single_task<class empty_kernel>([=]() { d[0] = 0; });
+    });
+  };
+
+  // Compiles the kernel
+  submit();
+  q.wait();
+
+  samples submit_only;
+  samples round_trip;
+  for (int i = 0; i < iterations; ++i) {
+    auto start = clock::now();
+    submit();
+    auto submitted = clock::now();
+    q.wait();
+    auto done = clock::now();
+    submit_only.add(submitted - start);
+    round_trip.add(done - start);
+  }
+
+  results r;
+  r.push_back(json_object()
+                  .add("iterations", iterations)
+                  .add("submit", submit_only)
+                  .add("submit_and_wait", round_trip));
+  return r;
+}
+
+}  // namespace bench
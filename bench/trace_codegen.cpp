@@ -0,0 +1,54 @@
+#include "bench.h"
+
+// Host time of tracing a kernel and generating its OpenCL C code,
+// depending on the number of statements in the kernel.
+// The loop runs while tracing, so each iteration becomes a statement.
+
+namespace bench {
+
+results trace_codegen(cl::sycl::queue& q, const options& opt) {
+  using namespace cl::sycl;
+
+  int iterations = opt.quick ? 5 : 20;
+  std::vector<int> sizes = {1, 16, 64, 256};
+  if (!opt.quick) {
+    sizes.push_back(1024);
+  }
+
+  results r;
+  for (auto statements : sizes) {
+    // A queue of its own keeps the statistics of each size apart
+    queue sized(q.get_context(), q.get_device());
+    buffer<int> data(1);
+
+    for (int i = 0; i < iterations; ++i) {
+      sized.submit([&](handler& cgh) {
+        auto d = data.get_access<access::mode::read_write>(cgh);
+        cgh.single_task<class sized_kernel>([=]() {
+          for (int k = 0; k < statements; ++k) {
+            d[0] = d[0] * 3 + 1;
+          }
+        });
+      });
+    }
+    sized.wait();
+
+    auto stats = sized.get_runtime_stats();
+    auto trace = stats.total(runtime_phase::trace);
+    auto codegen = stats.total(runtime_phase::codegen);
+    auto compile = stats.total(runtime_phase::compile);
+    auto per_submit = [iterations](const runtime_phase_stats& p) {
+      return p.total.count() / 1000.0 / iterations;
+    };
+
+    r.push_back(json_object()
+                    .add("statements", statements)
+                    .add("iterations", iterations)
+                    .add("trace_us", per_submit(trace))
+                    .add("codegen_us", per_submit(codegen))
+                    .add("compile_total_us", compile.total.count() / 1000.0));
+  }
+  return r;
+}
+
+}  // namespace bench
@@ -5,7 +5,9 @@
 
 #include "SYCL/accessors/buffer.h"
 #include "SYCL/accessors/local.h"
+#include "SYCL/atomic.h"
 #include "SYCL/buffer.h"
+#include "SYCL/command_graph.h"
 #include "SYCL/command_group.h"
 #include "SYCL/context.h"
 #include "SYCL/device.h"
@@ -13,10 +15,17 @@
 #include "SYCL/handler.h"
 #include "SYCL/info.h"
 #include "SYCL/kernel.h"
+#include "SYCL/kernel_optimizer.h"
+#include "SYCL/memory_pool.h"
+#include "SYCL/out_of_core.h"
 #include "SYCL/platform.h"
+#include "SYCL/profiler.h"
 #include "SYCL/program.h"
+#include "SYCL/program_cache.h"
 #include "SYCL/queue.h"
 #include "SYCL/ranges.h"
+#include "SYCL/reduction.h"
+#include "SYCL/runtime_stats.h"
 #include "SYCL/vectors/swizzled_vec.h"
 #include "SYCL/vectors/vec.h"
 #include "SYCL/workitem_functions.h"
@@ -44,6 +44,9 @@ enum class target {
 };
 
 static debug& operator<<(debug& d, mode m) {
+  if (!d.active()) {
+    return d;
+  }
   std::string str("mode::");
   switch (m) {
     case mode::read:
@@ -70,6 +73,9 @@ static debug& operator<<(debug& d, mode m) {
 }
 
 static debug& operator<<(debug& d, target t) {
+  if (!d.active()) {
+    return d;
+  }
   std::string str("target::");
   switch (t) {
     case target::global_buffer:
@@ -3,6 +3,7 @@
 // 3.4.6 Accessors
 
 #include "SYCL/access.h"
+#include "SYCL/buffer_base.h"
 #include "SYCL/detail/common.h"
 
 namespace cl {
@@ -52,6 +53,11 @@ class accessor_core : public accessor_base {
   virtual ::size_t argument_size() const {
     return 0;
   }
+
+  /** Part of the buffer the accessor can reach */
+  virtual buffer_region access_region() const {
+    return {};
+  }
 };
 
 template <bool>
@@ -73,6 +73,9 @@ SYCL_ADD_ACC_BUFFERS(access::mode::read_write)
 SYCL_ADD_ACC_BUFFERS(access::mode::discard_write)
 SYCL_ADD_ACC_BUFFERS(access::mode::discard_read_write)
 
+/** Atomics are only available on the device */
+SYCL_ADD_ACCESSOR_BUFFER(access::mode::atomic, access::target::global_buffer)
+
 /** Can only be read */
 SYCL_ADD_ACCESSOR_BUFFER(access::mode::read, access::target::constant_buffer)
 
@@ -25,6 +25,11 @@ class accessor_buffer {
   handler* commandGroupHandler;
   range<dimensions> offset;
   range<dimensions> rang;
+  /**
+   * The offset as plain values,
+   * which kernels capturing the accessor receive as arguments
+   */
+  ::size_t offset_values[dimensions];
 
  public:
   accessor_buffer(buffer<DataType, dimensions>& bufferRef,
@@ -33,15 +38,46 @@ class accessor_buffer {
       : buf(&bufferRef),
         commandGroupHandler(commandGroupHandler),
         offset(offset),
-        rang(range) {}
+        rang(range) {
+    for (int i = 0; i < dimensions; ++i) {
+      offset_values[i] = offset.get(i);
+    }
+  }
 
  protected:
   cl_mem get_buffer_object() const {
-    return buf->device_data.get();
+    return buf->get_device_data();
   }
   ::size_t access_buffer_range(int n) const {
     return buf->rang.get(n);
   }
+  /** Differs from the buffer range for sub-buffers */
+  ::size_t access_host_range(int n) const {
+    return buf->storage_range.get(n);
+  }
+  /** Added to each index, relative to the start of the buffer */
+  ::size_t access_offset(int n) const {
+    return offset.get(n);
+  }
+  /**
+   * The offset in the kernel code, a kernel argument,
+   * so that moving the accessed window doesn't compile the kernel again
+   */
+  ir::expr access_offset_name(int n) const {
+    return data_ref::get_name(offset_values[n]);
+  }
+  buffer_region get_region() const {
+    ::size_t byte_offset[3] = {0, 0, 0};
+    ::size_t byte_size[3] = {1, 1, 1};
+    for (int i = 0; i < dimensions; ++i) {
+      byte_offset[i] = offset.get(i);
+      byte_size[i] = rang.get(i);
+    }
+    auto element_size = data_size<DataType>::get();
+    byte_offset[0] *= element_size;
+    byte_size[0] *= element_size;
+    return buf->region.sub_region(byte_offset, byte_size);
+  }
   typename base_host_data<DataType>::type* access_host_data() const {
     return buf->host_data.get();
   }
@@ -26,7 +26,7 @@ SYCL_ACCESSOR_CLASS(target == access::target::constant_buffer ||
   template <int, typename, int, access::mode, access::target>
   friend class accessor_device_ref;
 
-  using return_t = typename acc_device_return<DataType>::type;
+  using return_t = typename acc_device_return<DataType, mode>::type;
   using base_acc_buffer = accessor_buffer<DataType, dimensions>;
   using base_acc_device_ref =
       accessor_device_ref<dimensions, DataType, dimensions, mode, target>;
@@ -71,7 +71,26 @@ SYCL_ACCESSOR_CLASS(target == access::target::constant_buffer ||
 
   return_t operator[](id<dimensions> index) const {
     auto resource_name = kernel_ns::register_resource(*this);
-    return return_t(resource_name + "[" + data_ref::get_name(index) + "]");
+    if (!has_offset()) {
+      return return_t(
+          ir::expr::subscript(resource_name, data_ref::get_name(index)));
+    }
+
+    // The linear index is only known per dimension
+    ir::expr ind;
+    ::size_t multiplier = 1;
+    for (int i = 0; i < dimensions; ++i) {
+      if (i > 0) {
+        ind += " + ";
+      }
+      ind += "(" + data_ref::get_name(index.get(i)) + " + " +
+             base_acc_buffer::access_offset_name(i) + ")";
+      if (i > 0) {
+        ind += " * " + get_string<::size_t>::get(multiplier);
+      }
+      multiplier *= base_acc_buffer::access_buffer_range(i);
+    }
+    return return_t(ir::expr::subscript(resource_name, ind));
   }
 
  private:
@@ -90,6 +109,20 @@ SYCL_ACCESSOR_CLASS(target == access::target::constant_buffer ||
   ::size_t argument_size() const final {
     return sizeof(cl_mem);
   }
+
+  buffer_region access_region() const final {
+    return base_acc_buffer::get_region();
+  }
+
+ private:
+  bool has_offset() const {
+    for (int i = 0; i < dimensions; ++i) {
+      if (base_acc_buffer::access_offset(i) != 0) {
+        return true;
+      }
+    }
+    return false;
+  }
 };
 
 }  // namespace detail
@@ -58,8 +58,9 @@ class accessor_host_ref<1, DataType, dimensions, mode> {
     index = 0;
     int multiplier = 1;
     for (int i = 0; i < dimensions; ++i) {
-      index += static_cast<int>(rang[i] * multiplier);
-      multiplier *= static_cast<int>(parent->access_buffer_range(i));
+      index +=
+          static_cast<int>((rang[i] + parent->access_offset(i)) * multiplier);
+      multiplier *= static_cast<int>(parent->access_host_range(i));
     }
     return parent->access_host_data()[index];
   }
@@ -80,23 +81,24 @@ SYCL_ACCESSOR_CLASS(target == access::target::host_buffer)
                   range<dimensions> offset, range<dimensions> range)
       : base_acc_buffer(bufferRef, nullptr, offset, range),
         base_acc_host_ref(this, std::array<::size_t, 3>{0, 0, 0}) {
-    synchronizer::add(this, base_acc_buffer::buf);
+    synchronizer::add(this, base_acc_buffer::buf, mode,
+                      base_acc_buffer::get_region());
   }
   accessor_detail(buffer<DataType, dimensions> & bufferRef)
       : accessor_detail(bufferRef, detail::empty_range<dimensions>(),
-                        bufferRef.get_range()) {
-    synchronizer::add(this, base_acc_buffer::buf);
-  }
+                        bufferRef.get_range()) {}
   accessor_detail(const accessor_detail& copy)
       : base_acc_buffer(static_cast<const base_acc_buffer&>(copy)),
         base_acc_host_ref(this, copy) {
-    synchronizer::add(this, base_acc_buffer::buf);
+    synchronizer::add(this, base_acc_buffer::buf, mode,
+                      base_acc_buffer::get_region());
   }
   accessor_detail(accessor_detail && move) noexcept
       : base_acc_buffer(std::move(static_cast<base_acc_buffer&&>(move))),
         base_acc_host_ref(this,
                           std::move(static_cast<base_acc_host_ref&&>(move))) {
-    synchronizer::add(this, base_acc_buffer::buf);
+    synchronizer::add(this, base_acc_buffer::buf, mode,
+                      base_acc_buffer::get_region());
   }
 
   accessor_detail& operator=(const accessor_detail& copy) {
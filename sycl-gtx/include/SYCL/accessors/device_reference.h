@@ -9,6 +9,11 @@
 
 namespace cl {
 namespace sycl {
+
+// Forward declaration
+template <typename>
+class atomic;
+
 namespace detail {
 
 // Forward declaration
@@ -16,10 +21,14 @@ template <int level, typename DataType, int dimensions, access::mode mode,
           access::target target>
 class accessor_device_ref;
 
-template <typename DataType>
+template <typename DataType, access::mode mode>
 struct acc_device_return {
   using type = data_ref;
 };
+template <typename DataType>
+struct acc_device_return<DataType, access::mode::atomic> {
+  using type = atomic<DataType>;
+};
 
 template <int level, typename DataType, int dimensions, access::mode mode,
           access::target target>
@@ -30,7 +39,7 @@ struct subscript_helper {
 template <typename DataType, int dimensions, access::mode mode,
           access::target target>
 struct subscript_helper<1, DataType, dimensions, mode, target> {
-  using type = typename acc_device_return<DataType>::type;
+  using type = typename acc_device_return<DataType, mode>::type;
 };
 
 #define SYCL_ACCESSOR_DEVICE_REF_CONSTRUCTOR()                                \
@@ -39,8 +48,8 @@ struct subscript_helper<1, DataType, dimensions, mode, target> {
   template <int, typename, int, access::mode, access::target>                 \
   friend class accessor_device_ref;                                           \
   const acc_t* parent;                                                        \
-  vector_class<string_class> rang;                                            \
-  accessor_device_ref(const acc_t* parent, vector_class<string_class> range)  \
+  vector_class<ir::expr> rang;                                                \
+  accessor_device_ref(const acc_t* parent, vector_class<ir::expr> range)      \
       : parent(parent), rang(range) {                                         \
     rang.resize(3);                                                           \
   }                                                                           \
@@ -85,7 +94,7 @@ template <typename DataType, int dimensions, access::mode mode,
           access::target target>
 class accessor_device_ref<1, DataType, dimensions, mode, target> {
  protected:
-  using subscript_return_t = typename acc_device_return<DataType>::type;
+  using subscript_return_t = typename acc_device_return<DataType, mode>::type;
   SYCL_ACCESSOR_DEVICE_REF_CONSTRUCTOR();
 
   template <class T>
@@ -94,15 +103,21 @@ class accessor_device_ref<1, DataType, dimensions, mode, target> {
     // strings
     auto rang_copy = rang;
     rang_copy[dimensions - 1] = data_ref::get_name(index);
-    string_class ind(std::move(rang_copy[0]));
+    for (int i = 0; i < dimensions; ++i) {
+      if (parent->access_offset(i) != 0) {
+        rang_copy[i] =
+            "(" + rang_copy[i] + " + " + parent->access_offset_name(i) + ")";
+      }
+    }
+    ir::expr ind(std::move(rang_copy[0]));
     auto multiplier = parent->access_buffer_range(0);
     for (int i = 1; i < dimensions; ++i) {
-      ind += string_class(" + ") + std::move(rang_copy[i]) + " * " +
+      ind += " + " + rang_copy[i] + " * " +
              get_string<decltype(multiplier)>::get(multiplier);
       multiplier *= parent->access_buffer_range(i);
     }
     auto resource_name = kernel_ns::register_resource(*parent);
-    return subscript_return_t(resource_name + "[" + ind + "]");
+    return subscript_return_t(ir::expr::subscript(resource_name, ind));
   }
 
  public:
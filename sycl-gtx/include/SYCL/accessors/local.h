@@ -33,6 +33,13 @@ SYCL_ACCESSOR_CLASS(target == access::target::local)
   ::size_t access_buffer_range(int n) const {
     return allocationSize.get(n);
   }
+  ::size_t access_offset(int n) const {
+    return 0;
+  }
+  /** Never used, there is no offset */
+  ir::expr access_offset_name(int n) const {
+    return ir::expr();
+  }
 
   void* resource() const final {
     return reinterpret_cast<void*>(this->get_count_id());  // NOLINT
@@ -88,6 +95,7 @@ SYCL_ACCESSOR_CLASS(target == access::target::local)
 SYCL_ADD_ACCESSOR_LOCAL(access::mode::read)
 SYCL_ADD_ACCESSOR_LOCAL(access::mode::write)
 SYCL_ADD_ACCESSOR_LOCAL(access::mode::read_write)
+SYCL_ADD_ACCESSOR_LOCAL(access::mode::atomic)
 
 }  // namespace sycl
 }  // namespace cl
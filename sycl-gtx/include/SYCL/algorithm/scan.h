@@ -0,0 +1,555 @@
+#pragma once
+
+// Scans, stream compaction and partitioning (sycl-gtx extension)
+
+#include "SYCL/access.h"
+#include "SYCL/accessors/buffer.h"
+#include "SYCL/accessors/local.h"
+#include "SYCL/buffer.h"
+#include "SYCL/detail/common.h"
+#include "SYCL/detail/data_ref.h"
+#include "SYCL/detail/flow_control.h"
+#include "SYCL/detail/group_size.h"
+#include "SYCL/handler.h"
+#include "SYCL/info.h"
+#include "SYCL/queue.h"
+#include "SYCL/ranges.h"
+#include "SYCL/reduction.h"
+#include "SYCL/vectors/vec.h"
+#include <memory>
+#include <type_traits>
+
+namespace cl {
+namespace sycl {
+
+namespace detail {
+namespace algorithm {
+
+/** Nonzero for the first element of a segment */
+using head_t = ::cl_int;
+
+template <typename T, access::mode mode>
+using global_acc = accessor<T, 1, mode, access::target::global_buffer>;
+template <typename T>
+using local_acc =
+    accessor<T, 1, access::mode::read_write, access::target::local>;
+
+template <typename T, access::mode mode>
+static shared_ptr_class<global_acc<T, mode>> optional_access(
+    handler& cgh, buffer<T, 1>* buf) {
+  if (buf == nullptr) {
+    return nullptr;
+  }
+  return std::make_shared<global_acc<T, mode>>(
+      buf->template get_access<mode>(cgh));
+}
+
+/**
+ * Inclusive scan of each work-group in local memory,
+ * also writes the total of each group.
+ * Segmented scans restart at each head,
+ * their heads are scanned along with the values.
+ */
+template <typename T, class BinaryOperation>
+struct scan_block {
+ protected:
+  global_acc<T, access::mode::read> input;
+  global_acc<T, access::mode::discard_write> output;
+  global_acc<T, access::mode::discard_write> sums;
+  local_acc<T> values;
+
+  // Only for segmented scans
+  shared_ptr_class<global_acc<head_t, access::mode::read>> heads;
+  /** Whether a segment starts in the group up to the element */
+  shared_ptr_class<global_acc<head_t, access::mode::discard_write>>
+      block_heads;
+  shared_ptr_class<global_acc<head_t, access::mode::discard_write>> sum_heads;
+  shared_ptr_class<local_acc<head_t>> flags;
+
+  BinaryOperation op;
+  T identity;
+  ::cl_uint n;
+  ::size_t local_size;
+
+  template <class Id>
+  void step(nd_item<1>& index, const Id& lid, ::size_t d) {
+    vec<T, 1> value = values[lid];
+    SYCL_IF(lid >= d) {
+      value = op(values[lid - d], value);
+    }
+    SYCL_END;
+    index.barrier(access::fence_space::local_space);
+    values[lid] = value;
+  }
+
+  template <class Id>
+  void step_segmented(nd_item<1>& index, const Id& lid, ::size_t d) {
+    auto& f = *flags;
+    vec<T, 1> value = values[lid];
+    vec<head_t, 1> flag = f[lid];
+    SYCL_IF(lid >= d) {
+      SYCL_IF(flag == 0) {
+        value = op(values[lid - d], value);
+      }
+      SYCL_END;
+      flag = flag | f[lid - d];
+    }
+    SYCL_END;
+    index.barrier(access::fence_space::local_space);
+    values[lid] = value;
+    f[lid] = flag;
+  }
+
+ public:
+  scan_block(handler& cgh, buffer<T, 1>& input, buffer<T, 1>& output,
+             buffer<T, 1>& sums, buffer<head_t, 1>* heads,
+             buffer<head_t, 1>* block_heads, buffer<head_t, 1>* sum_heads,
+             BinaryOperation op, T identity, ::size_t local_size)
+      : input(input.template get_access<access::mode::read>(cgh)),
+        output(output.template get_access<access::mode::discard_write>(cgh)),
+        sums(sums.template get_access<access::mode::discard_write>(cgh)),
+        values(local_size, cgh),
+        heads(optional_access<head_t, access::mode::read>(cgh, heads)),
+        block_heads(optional_access<head_t, access::mode::discard_write>(
+            cgh, block_heads)),
+        sum_heads(optional_access<head_t, access::mode::discard_write>(
+            cgh, sum_heads)),
+        op(op),
+        identity(identity),
+        n(static_cast<::cl_uint>(input.get_count())),
+        local_size(local_size) {
+    if (heads != nullptr) {
+      flags = std::make_shared<local_acc<head_t>>(local_size, cgh);
+    }
+  }
+
+  void operator()(nd_item<1> index) {
+    auto lid = index.get_local(0);
+    auto gid = index.get_global(0);
+
+    SYCL_IF(gid < n) {
+      values[lid] = input[gid];
+    }
+    SYCL_ELSE {
+      values[lid] = identity;
+    }
+    SYCL_END;
+    if (heads) {
+      SYCL_IF(gid < n) {
+        (*flags)[lid] = (*heads)[gid] != 0;
+      }
+      SYCL_ELSE {
+        (*flags)[lid] = 0;
+      }
+      SYCL_END;
+    }
+    index.barrier(access::fence_space::local_space);
+
+    // The steps are unrolled, the size of the work-groups is known
+    for (::size_t d = 1; d < local_size; d *= 2) {
+      if (heads) {
+        step_segmented(index, lid, d);
+      } else {
+        step(index, lid, d);
+      }
+      index.barrier(access::fence_space::local_space);
+    }
+
+    SYCL_IF(gid < n) {
+      output[gid] = values[lid];
+      if (heads) {
+        (*block_heads)[gid] = (*flags)[lid];
+      }
+    }
+    SYCL_END;
+    SYCL_IF(lid == local_size - 1) {
+      sums[gid / local_size] = values[lid];
+      if (heads) {
+        (*sum_heads)[gid / local_size] = (*flags)[lid];
+      }
+    }
+    SYCL_END;
+  }
+};
+
+/** Combines each element with the scanned totals of the previous groups */
+template <typename T, class BinaryOperation>
+struct scan_carry {
+ protected:
+  global_acc<T, access::mode::read_write> output;
+  global_acc<T, access::mode::read> scanned;
+  shared_ptr_class<global_acc<head_t, access::mode::read>> block_heads;
+  BinaryOperation op;
+  ::cl_uint n;
+  ::size_t local_size;
+
+ public:
+  scan_carry(handler& cgh, buffer<T, 1>& output, buffer<T, 1>& scanned,
+             buffer<head_t, 1>* block_heads, BinaryOperation op,
+             ::size_t local_size)
+      : output(output.template get_access<access::mode::read_write>(cgh)),
+        scanned(scanned.template get_access<access::mode::read>(cgh)),
+        block_heads(
+            optional_access<head_t, access::mode::read>(cgh, block_heads)),
+        op(op),
+        n(static_cast<::cl_uint>(output.get_count())),
+        local_size(local_size) {}
+
+  void operator()(item<1> index) {
+    auto gid = index.get(0);
+    uint1 group = gid / local_size;
+
+    // A segment starting earlier in the group doesn't need the carry
+    auto carried = block_heads
+                       ? group > 0 && gid < n && (*block_heads)[gid] == 0
+                       : group > 0 && gid < n;
+    SYCL_IF(carried) {
+      output[gid] = op(scanned[group - 1], output[gid]);
+    }
+    SYCL_END;
+  }
+};
+
+/** Turns an inclusive scan into an exclusive one */
+template <typename T>
+struct scan_shift {
+ protected:
+  global_acc<T, access::mode::read> inclusive;
+  global_acc<T, access::mode::discard_write> output;
+  shared_ptr_class<global_acc<head_t, access::mode::read>> heads;
+  T identity;
+  ::cl_uint n;
+
+ public:
+  scan_shift(handler& cgh, buffer<T, 1>& inclusive, buffer<T, 1>& output,
+             buffer<head_t, 1>* heads, T identity)
+      : inclusive(inclusive.template get_access<access::mode::read>(cgh)),
+        output(output.template get_access<access::mode::discard_write>(cgh)),
+        heads(optional_access<head_t, access::mode::read>(cgh, heads)),
+        identity(identity),
+        n(static_cast<::cl_uint>(output.get_count())) {}
+
+  void operator()(item<1> index) {
+    auto i = index.get(0);
+    auto first = heads ? i == 0 || (*heads)[i] != 0 : i == 0;
+    SYCL_IF(i < n) {
+      SYCL_IF(first) {
+        output[i] = identity;
+      }
+      SYCL_ELSE {
+        output[i] = inclusive[i - 1];
+      }
+      SYCL_END;
+    }
+    SYCL_END;
+  }
+};
+
+/**
+ * Scans one level of groups into output,
+ * the totals of the groups are scanned recursively.
+ * Returns once the temporary buffers are no longer used.
+ */
+template <typename T, class BinaryOperation>
+void scan_levels(queue& q, buffer<T, 1>& input, buffer<head_t, 1>* heads,
+                 buffer<T, 1>& output, const BinaryOperation& op,
+                 const T& identity, ::size_t local_size) {
+  auto n = input.get_count();
+  auto groups = (n + local_size - 1) / local_size;
+  auto global = nd_range<1>(groups * local_size, local_size);
+
+  buffer<T, 1> sums(groups);
+  unique_ptr_class<buffer<head_t, 1>> block_heads;
+  unique_ptr_class<buffer<head_t, 1>> sum_heads;
+  if (heads != nullptr) {
+    block_heads.reset(new buffer<head_t, 1>(n));
+    sum_heads.reset(new buffer<head_t, 1>(groups));
+  }
+
+  q.submit([&](handler& cgh) {
+    cgh.parallel_for(global, scan_block<T, BinaryOperation>(
+                                 cgh, input, output, sums, heads,
+                                 block_heads.get(), sum_heads.get(), op,
+                                 identity, local_size));
+  });
+  if (groups == 1) {
+    return;
+  }
+
+  buffer<T, 1> scanned(groups);
+  scan_levels(q, sums, sum_heads.get(), scanned, op, identity, local_size);
+  q.submit([&](handler& cgh) {
+    cgh.parallel_for(range<1>(n),
+                     scan_carry<T, BinaryOperation>(cgh, output, scanned,
+                                                    block_heads.get(), op,
+                                                    local_size));
+  });
+}
+
+/**
+ * Work-group size of the scans of T, limited by scan_block.
+ * Segmented scans also keep the heads in local memory.
+ */
+template <typename T, class BinaryOperation>
+::size_t scan_group_size(queue& q, const BinaryOperation& op,
+                         const T& identity, bool segmented) {
+  using block = scan_block<T, BinaryOperation>;
+  auto bytes_per_item = sizeof(T) + (segmented ? sizeof(head_t) : 0);
+  return fitted_group_size<block>(q, bytes_per_item, 0, [&](::size_t size) {
+    buffer<T, 1> input(1);
+    buffer<T, 1> output(1);
+    buffer<T, 1> sums(1);
+    buffer<head_t, 1> heads(1);
+    buffer<head_t, 1> block_heads(1);
+    buffer<head_t, 1> sum_heads(1);
+    ::size_t allowed = size;
+    q.submit([&](handler& cgh) {
+      allowed = cgh.get_work_group_size<block>(
+          block(cgh, input, output, sums, segmented ? &heads : nullptr,
+                segmented ? &block_heads : nullptr,
+                segmented ? &sum_heads : nullptr, op, identity, size));
+    });
+    return allowed;
+  });
+}
+
+template <typename T, class BinaryOperation>
+void inclusive_scan(queue& q, buffer<T, 1>& input, buffer<head_t, 1>* heads,
+                    buffer<T, 1>& output, const BinaryOperation& op,
+                    const T& identity) {
+  if (input.get_count() == 0) {
+    return;
+  }
+  scan_levels(q, input, heads, output, op, identity,
+              scan_group_size(q, op, identity, heads != nullptr));
+}
+
+template <typename T, class BinaryOperation>
+void exclusive_scan(queue& q, buffer<T, 1>& input, buffer<head_t, 1>* heads,
+                    buffer<T, 1>& output, const BinaryOperation& op,
+                    const T& identity) {
+  auto n = input.get_count();
+  if (n == 0) {
+    return;
+  }
+  buffer<T, 1> inclusive(n);
+  scan_levels(q, input, heads, inclusive, op, identity,
+              scan_group_size(q, op, identity, heads != nullptr));
+
+  q.submit([&](handler& cgh) {
+    cgh.parallel_for(range<1>(n),
+                     scan_shift<T>(cgh, inclusive, output, heads, identity));
+  });
+}
+
+/** Marks the elements satisfying the predicate with 1 */
+template <typename T, class Predicate>
+struct compact_mark {
+ protected:
+  global_acc<T, access::mode::read> input;
+  global_acc<::cl_uint, access::mode::discard_write> marks;
+  Predicate pred;
+  ::cl_uint n;
+
+ public:
+  compact_mark(handler& cgh, buffer<T, 1>& input, buffer<::cl_uint, 1>& marks,
+               Predicate pred)
+      : input(input.template get_access<access::mode::read>(cgh)),
+        marks(marks.template get_access<access::mode::discard_write>(cgh)),
+        pred(pred),
+        n(static_cast<::cl_uint>(input.get_count())) {}
+
+  void operator()(item<1> index) {
+    auto i = index.get(0);
+    SYCL_IF(i < n) {
+      SYCL_IF(pred(input[i])) {
+        marks[i] = 1;
+      }
+      SYCL_ELSE {
+        marks[i] = 0;
+      }
+      SYCL_END;
+    }
+    SYCL_END;
+  }
+};
+
+/**
+ * Moves the marked elements to their scanned positions.
+ * A partition moves the other elements behind them, in order.
+ */
+template <typename T, access::mode mode>
+struct compact_scatter {
+ protected:
+  global_acc<T, access::mode::read> input;
+  global_acc<::cl_uint, access::mode::read> marks;
+  global_acc<::cl_uint, access::mode::read> positions;
+  global_acc<T, mode> output;
+  global_acc<::cl_uint, access::mode::discard_write> count;
+  ::cl_uint n;
+
+ public:
+  compact_scatter(handler& cgh, buffer<T, 1>& input,
+                  buffer<::cl_uint, 1>& marks,
+                  buffer<::cl_uint, 1>& positions, buffer<T, 1>& output,
+                  buffer<::cl_uint, 1>& count)
+      : input(input.template get_access<access::mode::read>(cgh)),
+        marks(marks.template get_access<access::mode::read>(cgh)),
+        positions(positions.template get_access<access::mode::read>(cgh)),
+        output(output.template get_access<mode>(cgh)),
+        count(count.template get_access<access::mode::discard_write>(cgh)),
+        n(static_cast<::cl_uint>(input.get_count())) {}
+
+  void operator()(item<1> index) {
+    auto i = index.get(0);
+    SYCL_IF(i < n) {
+      data_ref last = data_ref(n) - 1;
+      uint1 total = positions[last] + marks[last];
+      SYCL_IF(marks[i] != 0) {
+        output[positions[i]] = input[i];
+      }
+      SYCL_END;
+      if (mode == access::mode::discard_write) {
+        SYCL_IF(marks[i] == 0) {
+          output[total + i - positions[i]] = input[i];
+        }
+        SYCL_END;
+      }
+      SYCL_IF(i == last) {
+        count[0] = total;
+      }
+      SYCL_END;
+    }
+    SYCL_END;
+  }
+};
+
+/** Returns the number of elements satisfying the predicate */
+template <access::mode mode, typename T, class Predicate>
+::size_t compact(queue& q, buffer<T, 1>& input, buffer<T, 1>& output,
+                 Predicate pred) {
+  auto n = input.get_count();
+  if (n == 0) {
+    return 0;
+  }
+  buffer<::cl_uint, 1> count(1);
+  {
+    buffer<::cl_uint, 1> marks(n);
+    buffer<::cl_uint, 1> positions(n);
+    q.submit([&](handler& cgh) {
+      cgh.parallel_for(range<1>(n),
+                       compact_mark<T, Predicate>(cgh, input, marks, pred));
+    });
+    exclusive_scan(q, marks, nullptr, positions, plus(), ::cl_uint(0));
+    q.submit([&](handler& cgh) {
+      cgh.parallel_for(range<1>(n), compact_scatter<T, mode>(
+                                        cgh, input, marks, positions, output,
+                                        count));
+    });
+  }
+
+  auto c = count.get_access<access::mode::read, access::target::host_buffer>();
+  return c[0];
+}
+
+}  // namespace algorithm
+}  // namespace detail
+
+/**
+ * output[i] = op(input[0], ..., input[i]).
+ * Arbitrary lengths are scanned in levels of work-groups,
+ * the input and output have to be different buffers.
+ * Returns once the scan has completed.
+ */
+template <typename T, class BinaryOperation>
+void inclusive_scan(queue& q, buffer<T, 1>& input, buffer<T, 1>& output,
+                    BinaryOperation op,
+                    typename std::remove_reference<T>::type identity) {
+  detail::algorithm::inclusive_scan(q, input, nullptr, output, op, identity);
+}
+template <typename T, class BinaryOperation = plus>
+void inclusive_scan(queue& q, buffer<T, 1>& input, buffer<T, 1>& output,
+                    BinaryOperation op = BinaryOperation()) {
+  inclusive_scan(q, input, output, op,
+                 BinaryOperation::template identity<T>());
+}
+
+/** output[0] = identity, output[i] = op(input[0], ..., input[i - 1]) */
+template <typename T, class BinaryOperation>
+void exclusive_scan(queue& q, buffer<T, 1>& input, buffer<T, 1>& output,
+                    BinaryOperation op,
+                    typename std::remove_reference<T>::type identity) {
+  detail::algorithm::exclusive_scan(q, input, nullptr, output, op, identity);
+}
+template <typename T, class BinaryOperation = plus>
+void exclusive_scan(queue& q, buffer<T, 1>& input, buffer<T, 1>& output,
+                    BinaryOperation op = BinaryOperation()) {
+  exclusive_scan(q, input, output, op,
+                 BinaryOperation::template identity<T>());
+}
+
+/**
+ * Inclusive scan restarting at each element with a nonzero head,
+ * the first element always starts a segment
+ */
+template <typename T, class BinaryOperation>
+void inclusive_segmented_scan(
+    queue& q, buffer<T, 1>& input, buffer<::cl_int, 1>& heads,
+    buffer<T, 1>& output, BinaryOperation op,
+    typename std::remove_reference<T>::type identity) {
+  detail::algorithm::inclusive_scan(q, input, &heads, output, op, identity);
+}
+template <typename T, class BinaryOperation = plus>
+void inclusive_segmented_scan(queue& q, buffer<T, 1>& input,
+                              buffer<::cl_int, 1>& heads,
+                              buffer<T, 1>& output,
+                              BinaryOperation op = BinaryOperation()) {
+  inclusive_segmented_scan(q, input, heads, output, op,
+                           BinaryOperation::template identity<T>());
+}
+
+/** Exclusive scan restarting at each element with a nonzero head */
+template <typename T, class BinaryOperation>
+void exclusive_segmented_scan(
+    queue& q, buffer<T, 1>& input, buffer<::cl_int, 1>& heads,
+    buffer<T, 1>& output, BinaryOperation op,
+    typename std::remove_reference<T>::type identity) {
+  detail::algorithm::exclusive_scan(q, input, &heads, output, op, identity);
+}
+template <typename T, class BinaryOperation = plus>
+void exclusive_segmented_scan(queue& q, buffer<T, 1>& input,
+                              buffer<::cl_int, 1>& heads,
+                              buffer<T, 1>& output,
+                              BinaryOperation op = BinaryOperation()) {
+  exclusive_segmented_scan(q, input, heads, output, op,
+                           BinaryOperation::template identity<T>());
+}
+
+/**
+ * Stream compaction: copies the elements satisfying the predicate
+ * to the front of the output, keeping their order.
+ * The rest of the output is left as it was.
+ * @param pred is traced into the kernel, it receives a single element
+ * @return the number of copied elements
+ */
+template <typename T, class Predicate>
+::size_t copy_if(queue& q, buffer<T, 1>& input, buffer<T, 1>& output,
+                 Predicate pred) {
+  return detail::algorithm::compact<access::mode::write>(q, input, output,
+                                                         pred);
+}
+
+/**
+ * Stable partition: the elements satisfying the predicate come first,
+ * followed by the others, both in their original order.
+ * @return the number of elements satisfying the predicate
+ */
+template <typename T, class Predicate>
+::size_t partition(queue& q, buffer<T, 1>& input, buffer<T, 1>& output,
+                   Predicate pred) {
+  return detail::algorithm::compact<access::mode::discard_write>(
+      q, input, output, pred);
+}
+
+}  // namespace sycl
+}  // namespace cl
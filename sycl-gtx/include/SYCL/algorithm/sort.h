@@ -0,0 +1,442 @@
+#pragma once
+
+// Radix sort of keys and key-value pairs (sycl-gtx extension)
+
+#include "SYCL/access.h"
+#include "SYCL/accessors/buffer.h"
+#include "SYCL/accessors/local.h"
+#include "SYCL/algorithm/scan.h"
+#include "SYCL/atomic.h"
+#include "SYCL/buffer.h"
+#include "SYCL/detail/common.h"
+#include "SYCL/detail/data_ref.h"
+#include "SYCL/detail/flow_control.h"
+#include "SYCL/handler.h"
+#include "SYCL/queue.h"
+#include "SYCL/ranges.h"
+#include "SYCL/reduction.h"
+#include "SYCL/vectors/vec.h"
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+
+namespace cl {
+namespace sycl {
+
+namespace detail {
+namespace algorithm {
+
+/** Bits sorted in each pass */
+static const ::cl_uint radix_bits = 4;
+static const ::cl_uint radix = 1 << radix_bits;
+
+/**
+ * Maps keys to unsigned integers with the same order and back.
+ * Signed integers flip the sign bit,
+ * negative floating point numbers flip all bits, others only the sign.
+ */
+template <typename K>
+struct radix_key {
+  using bits_t =
+      typename std::conditional<sizeof(K) == 4, ::cl_uint, ::cl_ulong>::type;
+
+  static const bool is_float = std::is_floating_point<K>::value;
+  static const bool is_signed = std::is_signed<K>::value;
+
+  static const char* as_bits() {
+    return sizeof(K) == 4 ? "as_uint" : "as_ulong";
+  }
+  static const char* as_key() {
+    if (is_float) {
+      return sizeof(K) == 4 ? "as_float" : "as_double";
+    }
+    if (is_signed) {
+      return sizeof(K) == 4 ? "as_int" : "as_long";
+    }
+    return sizeof(K) == 4 ? "as_uint" : "as_ulong";
+  }
+
+  static data_ref sign() {
+    return sizeof(K) == 4 ? "0x80000000u" : "0x8000000000000000ul";
+  }
+  /** Also pads the last work-group, sorted behind all keys */
+  static data_ref all_ones() {
+    return sizeof(K) == 4 ? "0xffffffffu" : "0xfffffffffffffffful";
+  }
+  static data_ref top_bit(const data_ref& bits) {
+    return bits >> (sizeof(K) * 8 - 1);
+  }
+
+  static data_ref encode(const data_ref& key) {
+    data_ref bits = ir::expr::call(as_bits(), {key.name});
+    if (is_float) {
+      return bits ^ ((data_ref("0") - top_bit(bits)) | sign());
+    }
+    return is_signed ? bits ^ sign() : bits;
+  }
+  static data_ref decode(const data_ref& bits) {
+    if (is_float) {
+      return ir::expr::call(as_key(),
+                            {(bits ^ ((top_bit(bits) - 1) | sign())).name});
+    }
+    return ir::expr::call(as_key(),
+                          {is_signed ? (bits ^ sign()).name : bits.name});
+  }
+};
+
+/** Converts between keys and their ordered bits */
+template <typename K, bool to_bits>
+struct radix_convert {
+ protected:
+  using bits_t = typename radix_key<K>::bits_t;
+  using from_t = typename std::conditional<to_bits, K, bits_t>::type;
+  using to_t = typename std::conditional<to_bits, bits_t, K>::type;
+
+  global_acc<from_t, access::mode::read> input;
+  global_acc<to_t, access::mode::discard_write> output;
+  ::cl_uint n;
+
+ public:
+  radix_convert(handler& cgh, buffer<from_t, 1>& input,
+                buffer<to_t, 1>& output)
+      : input(input.template get_access<access::mode::read>(cgh)),
+        output(output.template get_access<access::mode::discard_write>(cgh)),
+        n(static_cast<::cl_uint>(input.get_count())) {}
+
+  void operator()(item<1> index) {
+    if (std::is_same<K, double>::value) {
+      kernel_enable_extension("cl_khr_fp64");
+    }
+    auto i = index.get(0);
+    SYCL_IF(i < n) {
+      if (to_bits) {
+        output[i] = radix_key<K>::encode(input[i]);
+      } else {
+        output[i] = radix_key<K>::decode(input[i]);
+      }
+    }
+    SYCL_END;
+  }
+};
+
+/**
+ * Sorts each work-group by the digit at the shift in local memory,
+ * with one stable split per bit of the digit.
+ * The digits of each group are counted in a local histogram,
+ * stored digit-major so that a scan yields the position of each group.
+ * Groups smaller than the radix handle several digits per work item.
+ */
+template <typename B, typename V>
+struct radix_block {
+ protected:
+  global_acc<B, access::mode::read> bits;
+  global_acc<B, access::mode::discard_write> sorted_bits;
+  global_acc<::cl_uint, access::mode::discard_write> counts;
+  local_acc<B> keys;
+  local_acc<::cl_uint> ranks;
+  accessor<::cl_uint, 1, access::mode::atomic, access::target::local> hist;
+
+  // Only when sorting by key
+  shared_ptr_class<global_acc<V, access::mode::read>> values;
+  shared_ptr_class<global_acc<V, access::mode::discard_write>> sorted_values;
+  shared_ptr_class<local_acc<V>> local_values;
+
+  data_ref all_ones;
+  ::cl_uint n;
+  ::cl_uint groups;
+  ::cl_uint shift;
+  ::size_t local_size;
+
+  template <class Id>
+  void split(nd_item<1>& index, const Id& lid, ::cl_uint bit) {
+    vec<B, 1> key = keys[lid];
+    uint1 zero = 1 - ((key >> (data_ref(shift) + bit)) & 1);
+    ranks[lid] = zero;
+    index.barrier(access::fence_space::local_space);
+
+    // Inclusive scan of the zeros, unrolled like scan_block
+    for (::size_t d = 1; d < local_size; d *= 2) {
+      uint1 rank = ranks[lid];
+      SYCL_IF(lid >= d) {
+        rank = rank + ranks[lid - d];
+      }
+      SYCL_END;
+      index.barrier(access::fence_space::local_space);
+      ranks[lid] = rank;
+      index.barrier(access::fence_space::local_space);
+    }
+
+    uint1 rank = ranks[lid];
+    uint1 position = rank - 1;
+    SYCL_IF(zero == 0) {
+      position = ranks[local_size - 1] + lid - rank;
+    }
+    SYCL_END;
+    keys[position] = key;
+    if (values) {
+      vec<V, 1> value = (*local_values)[lid];
+      index.barrier(access::fence_space::local_space);
+      (*local_values)[position] = value;
+    }
+    index.barrier(access::fence_space::local_space);
+  }
+
+ public:
+  radix_block(handler& cgh, buffer<B, 1>& bits, buffer<B, 1>& sorted_bits,
+              buffer<::cl_uint, 1>& counts, buffer<V, 1>* values,
+              buffer<V, 1>* sorted_values, data_ref all_ones, ::cl_uint shift,
+              ::size_t local_size)
+      : bits(bits.template get_access<access::mode::read>(cgh)),
+        sorted_bits(
+            sorted_bits.template get_access<access::mode::discard_write>(cgh)),
+        counts(counts.template get_access<access::mode::discard_write>(cgh)),
+        keys(local_size, cgh),
+        ranks(local_size, cgh),
+        hist(radix, cgh),
+        values(optional_access<V, access::mode::read>(cgh, values)),
+        sorted_values(optional_access<V, access::mode::discard_write>(
+            cgh, sorted_values)),
+        all_ones(std::move(all_ones)),
+        n(static_cast<::cl_uint>(bits.get_count())),
+        groups(static_cast<::cl_uint>((n + local_size - 1) / local_size)),
+        shift(shift),
+        local_size(local_size) {
+    if (values != nullptr) {
+      local_values = std::make_shared<local_acc<V>>(local_size, cgh);
+    }
+  }
+
+  void operator()(nd_item<1> index) {
+    if (values && std::is_same<V, double>::value) {
+      kernel_enable_extension("cl_khr_fp64");
+    }
+    auto lid = index.get_local(0);
+    auto gid = index.get_global(0);
+    uint1 group = gid / local_size;
+
+    for (::size_t first = 0; first < radix; first += local_size) {
+      uint1 digit = lid + first;
+      SYCL_IF(digit < radix) {
+        hist[digit].store(0);
+      }
+      SYCL_END;
+    }
+    SYCL_IF(gid < n) {
+      keys[lid] = bits[gid];
+      if (values) {
+        (*local_values)[lid] = (*values)[gid];
+      }
+    }
+    SYCL_ELSE {
+      keys[lid] = all_ones;
+    }
+    SYCL_END;
+    index.barrier(access::fence_space::local_space);
+
+    SYCL_IF(gid < n) {
+      hist[(keys[lid] >> data_ref(shift)) & (radix - 1)].fetch_add(1);
+    }
+    SYCL_END;
+
+    for (::cl_uint bit = 0; bit < radix_bits; ++bit) {
+      split(index, lid, bit);
+    }
+
+    // The padding sorts behind the keys of the last group
+    SYCL_IF(gid < n) {
+      sorted_bits[gid] = keys[lid];
+      if (values) {
+        (*sorted_values)[gid] = (*local_values)[lid];
+      }
+    }
+    SYCL_END;
+    for (::size_t first = 0; first < radix; first += local_size) {
+      uint1 digit = lid + first;
+      SYCL_IF(digit < radix) {
+        counts[data_ref(groups) * digit + group] = hist[digit].load();
+      }
+      SYCL_END;
+    }
+  }
+};
+
+/**
+ * Moves the block-sorted elements to their place in the pass:
+ * the scanned count of the digit in the previous groups
+ * plus the rank of the element among the digits of its group.
+ */
+template <typename B, typename V>
+struct radix_scatter {
+ protected:
+  global_acc<B, access::mode::read> sorted_bits;
+  global_acc<::cl_uint, access::mode::read> counts;
+  global_acc<::cl_uint, access::mode::read> offsets;
+  global_acc<B, access::mode::discard_write> bits;
+  local_acc<::cl_uint> starts;
+
+  // Only when sorting by key
+  shared_ptr_class<global_acc<V, access::mode::read>> sorted_values;
+  shared_ptr_class<global_acc<V, access::mode::discard_write>> values;
+
+  ::cl_uint n;
+  ::cl_uint groups;
+  ::cl_uint shift;
+  ::size_t local_size;
+
+ public:
+  radix_scatter(handler& cgh, buffer<B, 1>& sorted_bits,
+                buffer<::cl_uint, 1>& counts, buffer<::cl_uint, 1>& offsets,
+                buffer<B, 1>& bits, buffer<V, 1>* sorted_values,
+                buffer<V, 1>* values, ::cl_uint shift, ::size_t local_size)
+      : sorted_bits(sorted_bits.template get_access<access::mode::read>(cgh)),
+        counts(counts.template get_access<access::mode::read>(cgh)),
+        offsets(offsets.template get_access<access::mode::read>(cgh)),
+        bits(bits.template get_access<access::mode::discard_write>(cgh)),
+        starts(radix, cgh),
+        sorted_values(
+            optional_access<V, access::mode::read>(cgh, sorted_values)),
+        values(optional_access<V, access::mode::discard_write>(cgh, values)),
+        n(static_cast<::cl_uint>(bits.get_count())),
+        groups(static_cast<::cl_uint>((n + local_size - 1) / local_size)),
+        shift(shift),
+        local_size(local_size) {}
+
+  void operator()(nd_item<1> index) {
+    if (values && std::is_same<V, double>::value) {
+      kernel_enable_extension("cl_khr_fp64");
+    }
+    auto lid = index.get_local(0);
+    auto gid = index.get_global(0);
+    uint1 group = gid / local_size;
+
+    // Where each digit starts in the block-sorted group
+    SYCL_IF(lid == 0) {
+      uint1 start = 0;
+      for (::cl_uint d = 0; d < radix; ++d) {
+        starts[d] = start;
+        start = start + counts[data_ref(groups) * d + group];
+      }
+    }
+    SYCL_END;
+    index.barrier(access::fence_space::local_space);
+
+    SYCL_IF(gid < n) {
+      vec<B, 1> key = sorted_bits[gid];
+      uint1 digit = (key >> data_ref(shift)) & (radix - 1);
+      uint1 position =
+          offsets[data_ref(groups) * digit + group] + lid - starts[digit];
+      bits[position] = key;
+      if (values) {
+        (*values)[position] = (*sorted_values)[gid];
+      }
+    }
+    SYCL_END;
+  }
+};
+
+/**
+ * Least significant digit radix sort, the values follow their keys.
+ * Returns once the sort has completed.
+ */
+template <typename K, typename V>
+void radix_sort(queue& q, buffer<K, 1>& keys, buffer<V, 1>* values) {
+  static_assert(std::is_arithmetic<K>::value &&
+                    (sizeof(K) == 4 || sizeof(K) == 8),
+                "Radix sort requires 32-bit or 64-bit keys");
+  using key_t = radix_key<K>;
+  using bits_t = typename key_t::bits_t;
+
+  auto n = keys.get_count();
+  if (n < 2) {
+    return;
+  }
+  // Local memory of radix_block: a key, a rank and a value per work item
+  // and the histogram
+  using block = radix_block<bits_t, V>;
+  using scatter = radix_scatter<bits_t, V>;
+  auto bytes_per_item =
+      sizeof(bits_t) + sizeof(::cl_uint) + (values != nullptr ? sizeof(V) : 0);
+  auto local_size = fitted_group_size<block>(
+      q, bytes_per_item, radix * sizeof(::cl_uint), [&](::size_t size) {
+        buffer<bits_t, 1> probe_bits(1);
+        buffer<bits_t, 1> probe_sorted_bits(1);
+        buffer<::cl_uint, 1> probe_counts(radix);
+        buffer<::cl_uint, 1> probe_offsets(radix);
+        buffer<V, 1> probe_values(1);
+        buffer<V, 1> probe_sorted_values(1);
+        auto v = values != nullptr ? &probe_values : nullptr;
+        auto sv = values != nullptr ? &probe_sorted_values : nullptr;
+        ::size_t allowed = size;
+        q.submit([&](handler& cgh) {
+          allowed = std::min(
+              cgh.get_work_group_size<block>(
+                  block(cgh, probe_bits, probe_sorted_bits, probe_counts, v,
+                        sv, key_t::all_ones(), 0, size)),
+              cgh.get_work_group_size<scatter>(
+                  scatter(cgh, probe_sorted_bits, probe_counts, probe_offsets,
+                          probe_bits, sv, v, 0, size)));
+        });
+        return allowed;
+      });
+  auto groups = (n + local_size - 1) / local_size;
+  auto global = nd_range<1>(groups * local_size, local_size);
+
+  buffer<bits_t, 1> bits(n);
+  buffer<bits_t, 1> sorted_bits(n);
+  buffer<::cl_uint, 1> counts(groups * radix);
+  buffer<::cl_uint, 1> offsets(groups * radix);
+  unique_ptr_class<buffer<V, 1>> sorted_values;
+  if (values != nullptr) {
+    sorted_values.reset(new buffer<V, 1>(n));
+  }
+
+  q.submit([&](handler& cgh) {
+    cgh.parallel_for(range<1>(n), radix_convert<K, true>(cgh, keys, bits));
+  });
+  // The shift is a kernel argument, each kernel is only compiled once
+  for (::cl_uint shift = 0; shift < sizeof(K) * 8; shift += radix_bits) {
+    q.submit([&](handler& cgh) {
+      cgh.parallel_for(global, radix_block<bits_t, V>(
+                                   cgh, bits, sorted_bits, counts, values,
+                                   sorted_values.get(), key_t::all_ones(),
+                                   shift, local_size));
+    });
+    exclusive_scan(q, counts, nullptr, offsets, plus(), ::cl_uint(0));
+    q.submit([&](handler& cgh) {
+      cgh.parallel_for(global, radix_scatter<bits_t, V>(
+                                   cgh, sorted_bits, counts, offsets, bits,
+                                   sorted_values.get(), values, shift,
+                                   local_size));
+    });
+  }
+  q.submit([&](handler& cgh) {
+    cgh.parallel_for(range<1>(n), radix_convert<K, false>(cgh, bits, keys));
+  });
+}
+
+}  // namespace algorithm
+}  // namespace detail
+
+/**
+ * Sorts 32-bit or 64-bit integer and floating point keys in ascending order.
+ * Negative zero sorts before zero, NaNs with the sign bit set come first
+ * and the others last.
+ * Returns once the sort has completed.
+ */
+template <typename K>
+void sort(queue& q, buffer<K, 1>& keys) {
+  detail::algorithm::radix_sort<K, K>(q, keys, nullptr);
+}
+
+/**
+ * Sorts the keys like sort and moves the values along with them,
+ * there have to be at least as many values as keys.
+ * The sort is stable, the values of equal keys keep their order.
+ */
+template <typename K, typename V>
+void sort_by_key(queue& q, buffer<K, 1>& keys, buffer<V, 1>& values) {
+  detail::algorithm::radix_sort(q, keys, &values);
+}
+
+}  // namespace sycl
+}  // namespace cl
@@ -1,46 +1,164 @@
 #pragma once
 
-// 3.4 Synchronization
+// 3.8 Synchronization and atomics
 
+#include "SYCL/access.h"
+#include "SYCL/accessor.h"
+#include "SYCL/detail/common.h"
+#include "SYCL/detail/data_ref.h"
+#include "SYCL/vectors/vec.h"
 #include <atomic>
+#include <type_traits>
 
 namespace cl {
 namespace sycl {
 
+namespace detail {
+
+// Forward declaration
+template <int level, typename DataType, int dimensions, access::mode mode,
+          access::target target>
+class accessor_device_ref;
+
+}  // namespace detail
+
+/**
+ * Atomic reference to an element of a buffer or of local memory,
+ * returned by the subscript operator of access::mode::atomic accessors.
+ *
+ * Each operation is traced to one of the OpenCL atomic functions.
+ * Its result is stored in a new variable,
+ * so that the operation runs exactly once even if the result is never used.
+ * 64-bit types use the atom_ functions, which enable
+ * cl_khr_int64_base_atomics or cl_khr_int64_extended_atomics in the kernel.
+ * Floats only support load, store and exchange.
+ *
+ * Only memory_order_relaxed is supported in SYCL 1.2,
+ * the memory order arguments have no effect.
+ */
 template <typename T>
-class atomic<T> {
+class atomic {
+  static_assert(sizeof(T) == 4 || sizeof(T) == 8,
+                "Atomics require 32-bit or 64-bit types");
+  static_assert(std::is_integral<T>::value || sizeof(T) == 4,
+                "Atomics only support floats, not doubles");
+
+ private:
+  template <typename, int, access::mode, access::target, typename>
+  friend class detail::accessor_detail;
+  template <int, typename, int, access::mode, access::target>
+  friend class detail::accessor_device_ref;
+
+  using data_ref = detail::data_ref;
+  using value_t = vec<T, 1>;
+  using expr = detail::ir::expr;
+
+  static const bool is_64 = (sizeof(T) == 8);
+
+  /** Address of the element */
+  expr pointer;
+
+  explicit atomic(const expr& element)
+      : pointer(expr::prefix("&", element)) {}
+
+  /** Extended functions are min, max, and, or and xor */
+  static const char* function(const char* name, const char* name_64,
+                              bool extended = false) {
+    if (!is_64) {
+      return name;
+    }
+    detail::kernel_enable_extension(extended ? "cl_khr_int64_extended_atomics"
+                                             : "cl_khr_int64_base_atomics");
+    return name_64;
+  }
+
+  value_t apply(const char* name, const char* name_64, const data_ref& operand,
+                bool extended = false) const {
+    static_assert(std::is_integral<T>::value,
+                  "Atomic arithmetic requires an integral type");
+    return value_t(data_ref(
+        expr::call(function(name, name_64, extended), {pointer, operand.name},
+                   detail::ir::node::side_effects)));
+  }
+
  public:
-  // Constructors
   atomic() = delete;
 
-  // Methods
-  // Only memory_order_relaxed is supported in SYCL 1.2
-  void store(T, std::memory_order);
-  void store(T, std::memory_order) volatile;
-  T load(std::memory_order) const;
-  T load(std::memory_order) const volatile;
-  T exchange(T, std::memory_order);
-  T exchange(T, std::memory_order) volatile;
-  T compare_exchange_strong(T*, T, std::memory_order success,
-                            std::memory_order fail);
-  T compare_exchange_strong(T*, T, std::memory_order success,
-                            std::memory_order fail) volatile;
-  T fetch_add(T, std::memory_order);
-  T fetch_add(T, std::memory_order) volatile;
-  T fetch_sub(T, std::memory_order);
-  T fetch_sub(T, std::memory_order) volatile;
-  T fetch_and(T, std::memory_order);
-  T fetch_and(T, std::memory_order) volatile;
-  T fetch_or(T, std::memory_order);
-  T fetch_or(T, std::memory_order) volatile;
-  T fetch_xor(T, std::memory_order);
-  T fetch_xor(T, std::memory_order) volatile;
+  void store(const data_ref& operand,
+             std::memory_order = std::memory_order_relaxed) const {
+    detail::kernel_add(
+        expr::call(function("atomic_xchg", "atom_xchg"),
+                   {pointer, operand.name}, detail::ir::node::side_effects));
+  }
+
+  value_t load(std::memory_order = std::memory_order_relaxed) const {
+    if (!std::is_integral<T>::value) {
+      // Aligned 32-bit reads are atomic
+      return value_t(data_ref(expr::prefix("*", pointer)));
+    }
+    // OpenCL 1.2 has no atomic load, so the value is read by adding zero
+    return value_t(data_ref(expr::call(function("atomic_add", "atom_add"),
+                                       {pointer, expr("0")},
+                                       detail::ir::node::side_effects)));
+  }
+
+  value_t exchange(const data_ref& operand,
+                   std::memory_order = std::memory_order_relaxed) const {
+    return value_t(data_ref(
+        expr::call(function("atomic_xchg", "atom_xchg"),
+                   {pointer, operand.name}, detail::ir::node::side_effects)));
+  }
+
+  /**
+   * If the element equals expected, it is replaced with desired.
+   * Otherwise expected is set to the value of the element.
+   * Returns whether the element was replaced.
+   */
+  vec<int, 1> compare_exchange_strong(
+      data_ref& expected, const data_ref& desired,
+      std::memory_order success = std::memory_order_relaxed,
+      std::memory_order fail = std::memory_order_relaxed) const {
+    static_assert(std::is_integral<T>::value,
+                  "Atomic compare and exchange requires an integral type");
+    value_t old(data_ref(expr::call(
+        function("atomic_cmpxchg", "atom_cmpxchg"),
+        {pointer, expected.name, desired.name},
+        detail::ir::node::side_effects)));
+    vec<int, 1> replaced(old == expected);
+    expected = old;
+    return replaced;
+  }
+
+  value_t fetch_add(const data_ref& operand,
+                    std::memory_order = std::memory_order_relaxed) const {
+    return apply("atomic_add", "atom_add", operand);
+  }
+  value_t fetch_sub(const data_ref& operand,
+                    std::memory_order = std::memory_order_relaxed) const {
+    return apply("atomic_sub", "atom_sub", operand);
+  }
+  value_t fetch_and(const data_ref& operand,
+                    std::memory_order = std::memory_order_relaxed) const {
+    return apply("atomic_and", "atom_and", operand, true);
+  }
+  value_t fetch_or(const data_ref& operand,
+                   std::memory_order = std::memory_order_relaxed) const {
+    return apply("atomic_or", "atom_or", operand, true);
+  }
+  value_t fetch_xor(const data_ref& operand,
+                    std::memory_order = std::memory_order_relaxed) const {
+    return apply("atomic_xor", "atom_xor", operand, true);
+  }
 
   // Additional functionality provided beyond that of C++11
-  T fetch_min(T, std::memory_order);
-  T fetch_min(T, std::memory_order) volatile;
-  T fetch_max(T, std::memory_order);
-  T fetch_max(T, std::memory_order) volatile;
+  value_t fetch_min(const data_ref& operand,
+                    std::memory_order = std::memory_order_relaxed) const {
+    return apply("atomic_min", "atom_min", operand, true);
+  }
+  value_t fetch_max(const data_ref& operand,
+                    std::memory_order = std::memory_order_relaxed) const {
+    return apply("atomic_max", "atom_max", operand, true);
+  }
 };
 
 typedef atomic<int> atomic_int;
@@ -48,55 +166,74 @@ typedef atomic<unsigned int> atomic_uint;
 typedef atomic<float> atomic_float;
 
 template <class T>
-T atomic_load_explicit(atomic<T>*, std::memory_order);
-template <class T>
-T atomic_load_explicit(volatile atomic<T>*, std::memory_order);
-template <class T>
-void atomic_store_explicit(atomic<T>*, T, std::memory_order);
-template <class T>
-void atomic_store_explicit(volatile atomic<T>*, T, std::memory_order);
-template <class T>
-T atomic_exchange_explicit(atomic<T>*, T, std::memory_order);
-template <class T>
-T atomic_exchange_explicit(volatile atomic<T>*, T, std::memory_order);
-template <class T>
-bool atomic_compare_exchange_strong_explicit(atomic<T>*, T*, T,
-                                             std::memory_order success,
-                                             std::memory_order fail);
-template <class T>
-bool atomic_compare_exchange_strong_explicit(volatile atomic<T>*, T*, T,
-                                             std::memory_order success,
-                                             std::memory_order fail);
-template <class T>
-T atomic_fetch_add_explicit(atomic<T>*, T, std::memory_order);
-template <class T>
-T atomic_fetch_add_explicit(volatile atomic<T>*, T, std::memory_order);
-template <class T>
-T atomic_fetch_sub_explicit(atomic<T>*, T, std::memory_order);
-template <class T>
-T atomic_fetch_sub_explicit(volatile atomic<T>*, T, std::memory_order);
-template <class T>
-T atomic_fetch_and_explicit(atomic<T>*, T, std::memory_order);
-template <class T>
-T atomic_fetch_and_explicit(volatile atomic<T>*, T, std::memory_order);
-template <class T>
-T atomic_fetch_or_explicit(atomic<T>*, T, std::memory_order);
-template <class T>
-T atomic_fetch_or_explicit(volatile atomic<T>*, T, std::memory_order);
-template <class T>
-T atomic_fetch_xor_explicit(atomic<T>*, T, std::memory_order);
-template <class T>
-T atomic_fetch_xor_explicit(volatile atomic<T>*, T, std::memory_order);
+vec<T, 1> atomic_load_explicit(
+    atomic<T>* object, std::memory_order order = std::memory_order_relaxed) {
+  return object->load(order);
+}
+template <class T>
+void atomic_store_explicit(
+    atomic<T>* object, const detail::data_ref& operand,
+    std::memory_order order = std::memory_order_relaxed) {
+  object->store(operand, order);
+}
+template <class T>
+vec<T, 1> atomic_exchange_explicit(
+    atomic<T>* object, const detail::data_ref& operand,
+    std::memory_order order = std::memory_order_relaxed) {
+  return object->exchange(operand, order);
+}
+template <class T>
+vec<int, 1> atomic_compare_exchange_strong_explicit(
+    atomic<T>* object, detail::data_ref& expected,
+    const detail::data_ref& desired,
+    std::memory_order success = std::memory_order_relaxed,
+    std::memory_order fail = std::memory_order_relaxed) {
+  return object->compare_exchange_strong(expected, desired, success, fail);
+}
+template <class T>
+vec<T, 1> atomic_fetch_add_explicit(
+    atomic<T>* object, const detail::data_ref& operand,
+    std::memory_order order = std::memory_order_relaxed) {
+  return object->fetch_add(operand, order);
+}
+template <class T>
+vec<T, 1> atomic_fetch_sub_explicit(
+    atomic<T>* object, const detail::data_ref& operand,
+    std::memory_order order = std::memory_order_relaxed) {
+  return object->fetch_sub(operand, order);
+}
+template <class T>
+vec<T, 1> atomic_fetch_and_explicit(
+    atomic<T>* object, const detail::data_ref& operand,
+    std::memory_order order = std::memory_order_relaxed) {
+  return object->fetch_and(operand, order);
+}
+template <class T>
+vec<T, 1> atomic_fetch_or_explicit(
+    atomic<T>* object, const detail::data_ref& operand,
+    std::memory_order order = std::memory_order_relaxed) {
+  return object->fetch_or(operand, order);
+}
+template <class T>
+vec<T, 1> atomic_fetch_xor_explicit(
+    atomic<T>* object, const detail::data_ref& operand,
+    std::memory_order order = std::memory_order_relaxed) {
+  return object->fetch_xor(operand, order);
+}
 
 // Additional functionality beyond that provided by C++11
 template <class T>
-T atomic_fetch_min_explicit(atomic<T>*, T, std::memory_order);
-template <class T>
-T atomic_fetch_min_explicit(volatile atomic<T>*, T, std::memory_order);
-template <class T>
-T atomic_fetch_max_explicit(atomic<T>*, T, std::memory_order);
-template <class T>
-T atomic_fetch_max_explicit(volatile atomic<T>*, T, std::memory_order);
+vec<T, 1> atomic_fetch_min_explicit(
+    atomic<T>* object, const detail::data_ref& operand,
+    std::memory_order order = std::memory_order_relaxed) {
+  return object->fetch_min(operand, order);
+}
+template <class T>
+vec<T, 1> atomic_fetch_max_explicit(
+    atomic<T>* object, const detail::data_ref& operand,
+    std::memory_order order = std::memory_order_relaxed) {
+  return object->fetch_max(operand, order);
+}
 
 }  // namespace sycl
 }  // namespace cl
@@ -7,7 +7,9 @@
 #include "SYCL/command_group.h"
 #include "SYCL/detail/common.h"
 #include "SYCL/detail/debug.h"
+#include "SYCL/detail/host_allocation.h"
 #include "SYCL/detail/synchronizer.h"
+#include "SYCL/detail/task_graph.h"
 #include "SYCL/error_handler.h"
 #include "SYCL/event.h"
 #include "SYCL/info.h"
@@ -15,6 +17,7 @@
 #include "SYCL/ranges.h"
 #include "SYCL/refc.h"
 #include <algorithm>
+#include <array>
 
 namespace cl {
 namespace sycl {
@@ -24,6 +27,7 @@ template <typename, int, access::mode, access::target>
 class accessor;
 template <typename, int = 1>
 struct buffer;
+class command_graph;
 class handler;
 class queue;
 
@@ -50,23 +54,31 @@ class buffer_detail : public buffer_base {
   using ptr_t = shared_ptr_class<DataType>;
 
   range<dimensions> rang;
+  /**
+   * Range of the host memory the data is laid out in,
+   * the range of the root buffer for sub-buffers
+   */
+  range<dimensions> storage_range;
   ptr_t host_data;
 
   bool is_read_only = false;
   bool is_blocking = true;
-  bool is_initialized = false;
 
   friend class accessor_base;
   friend class accessor_buffer<DataType_t, dimensions>;
   friend class kernel_ns::source;
+  friend class ::cl::sycl::command_graph;
 
   /** Associated host memory. */
   buffer_detail(value_type* host_data, range<dimensions> range,
                 bool is_read_only, bool is_blocking = true)
       : host_data(ptr_t(host_data, [](value_type* ptr) {})),
         rang(range),
+        storage_range(range),
         is_read_only(is_read_only),
-        is_blocking(is_blocking) {}
+        is_blocking(is_blocking) {
+    init_root(data_size<DataType_t>::get(), extend(range).data());
+  }
 
   buffer_detail(std::nullptr_t host_data, range<dimensions> range)
       : buffer_detail(nullptr, range, false) {}
@@ -105,7 +117,9 @@ class buffer_detail : public buffer_base {
 
   /**
    * Create a new buffer of the given size with storage managed by the SYCL
-  // runtime.
+   * runtime.
+   * The storage is page aligned, so that devices sharing memory with the host
+   * can use it without copying.
    * The default behavior is to use the default host buffer allocator,
    * in order to allow for host accesses.
    * If the type of the buffer has the const qualifier,
@@ -114,10 +128,13 @@ class buffer_detail : public buffer_base {
    * @param range<dimensions> defines the size.
    */
   buffer_detail(const range<dimensions>& range)
-      : host_data(ptr_t(new DataType[range.size()])),
+      : host_data(allocate_host<DataType>(range.size())),
         rang(range),
+        storage_range(range),
         is_read_only(false),
-        is_blocking(false) {}
+        is_blocking(false) {
+    init_root(data_size<DataType_t>::get(), extend(range).data());
+  }
 
   /**
    * Create a new buffer with associated memory, using the data in hostData.
@@ -141,10 +158,13 @@ class buffer_detail : public buffer_base {
   buffer_detail(unique_ptr_class<void>&& hostData,
                 const range<dimensions>& bufferRange);
 
-  // TODO(progtx):
   /**
    * Create a new sub-buffer without allocation to have separate accessors
    * later.
+   * Contiguous regions alias the device memory of the buffer b,
+   * other regions are copied to and from it around each command group.
+   * Command groups using disjoint sub-buffers don't depend on each other.
+   * The buffer b has to outlive the sub-buffer.
    * @param b is the buffer with the real data.
    * @param baseIndex specifies the origin of the sub-buffer inside the buffer
    * b.
@@ -153,21 +173,16 @@ class buffer_detail : public buffer_base {
   buffer_detail(buffer_detail& b, const id<dimensions>& baseIndex,
                 const range<dimensions>& subRange)
       : rang(subRange),
+        storage_range(b.storage_range),
         is_read_only(b.is_read_only),
         is_blocking(b.is_blocking) {
-    DataType* start = b.host_data.get();
-
-    if (dimensions == 1) {
-      start += static_cast<::size_t>(baseIndex.get(0));
-    } else if (dimensions == 2) {
-      start += static_cast<::size_t>(baseIndex.get(1)) *
-                   static_cast<::size_t>(rang.get(0)) +
-               static_cast<::size_t>(baseIndex.get(0));
-    } else if (dimensions == 3) {
-      // TODO(progtx):
-    }
-
+    auto element_size = data_size<DataType_t>::get();
+    init_sub_buffer(b, element_size, extend(baseIndex, 0).data(),
+                    extend(subRange).data());
+    DataType* start =
+        b.host_data.get() + (region.origin - b.region.origin) / element_size;
     host_data = ptr_t(start, [](DataType* ptr) {});
+    task_graph::add_sub_buffer(this);
   }
 
   /**
@@ -187,7 +202,10 @@ class buffer_detail : public buffer_base {
   buffer_detail& operator=(buffer_detail&&) = default;  // NOLINT
 
   ~buffer_detail() {
-    event::wait_and_throw(events);
+    task_graph::remove(this);
+    if (needs_write_back()) {
+      update_host();
+    }
   }
 
   /**
@@ -214,23 +232,49 @@ class buffer_detail : public buffer_base {
   }
 
  private:
+  /** Extends an index or range to three dimensions */
+  template <class T>
+  static std::array<::size_t, 3> extend(const T& r, ::size_t fill = 1) {
+    std::array<::size_t, 3> extended = {{fill, fill, fill}};
+    for (int i = 0; i < dimensions; ++i) {
+      extended[i] = static_cast<::size_t>(r.get(i));
+    }
+    return extended;
+  }
+
+  void* host_pointer() final {
+    return host_data.get();
+  }
+
   static void create(queue* q, const vector_class<cl_event>& wait_events,
-                     buffer_detail* buffer) {
-    ::cl_int error_code;
-    const cl_mem_flags all_flags =
-        ((buffer->host_data == nullptr) ? 0 : CL_MEM_USE_HOST_PTR) |
-        (buffer->is_read_only ? CL_MEM_READ_ONLY : CL_MEM_READ_WRITE);
-    buffer->device_data = buffer_base::cl_create_buffer(
-        q, all_flags, buffer->get_size(), buffer->host_data.get(), error_code);
-    detail::error::report(error_code);
-    buffer->device_data.release_one();
+                     event* evnt, buffer_detail* buffer) {
+    buffer->create_device_data(q);
   }
 
-  void init() {
-    if (!is_initialized) {
-      command::group_detail::add_buffer_init(create, __func__, this);
-      is_initialized = true;
+  void create_device_data(queue* q) {
+    if (get_device_data() != nullptr) {
+      // Replayed from a command graph, created through another copy,
+      // or the root of a sub-buffer
+      return;
+    }
+    const cl_mem_flags access_flags =
+        is_read_only ? CL_MEM_READ_ONLY : CL_MEM_READ_WRITE;
+
+    if (root != this) {
+      if (needs_root_device_data()) {
+        static_cast<buffer_detail*>(root)->create_device_data(q);
+      }
+      create_sub_buffer(q, access_flags);
+      return;
     }
+
+    create_root_buffer(q, access_flags, get_size(), host_data.get());
+  }
+
+  // Every group creates the device data if it doesn't exist yet,
+  // groups traced concurrently can be dispatched in either order
+  void init() {
+    command::group_detail::add_buffer_init(create, __func__, this);
   }
 
   void check_read_only() {
@@ -243,7 +287,9 @@ class buffer_detail : public buffer_base {
   using acc_return_t = accessor<DataType_t, dimensions, mode, target>;
 
   template <access::mode mode, access::target target>
-  acc_return_t<mode, target> get_access_device(handler& cgh) {
+  acc_return_t<mode, target> get_access_device(handler& cgh,
+                                               range<dimensions> offset,
+                                               range<dimensions> range) {
     command::group_detail::check_scope();
     if (mode != access::mode::read) {
       check_read_only();
@@ -252,53 +298,69 @@ class buffer_detail : public buffer_base {
     command::group_detail::add_buffer_access(buffer_access{this, mode, target},
                                              __func__);
     return acc_return_t<mode, target>(
-        *(static_cast<cl::sycl::buffer<DataType_t, dimensions>*>(this)), cgh);
+        *(static_cast<cl::sycl::buffer<DataType_t, dimensions>*>(this)), cgh,
+        offset, range);
   }
 
   template <access::mode mode, access::target target>
-  acc_return_t<mode, target> get_access_host() {
+  acc_return_t<mode, target> get_access_host(range<dimensions> offset,
+                                             range<dimensions> range) {
     if (mode != access::mode::read) {
       check_read_only();
     }
     return acc_return_t<mode, target>(
-        *(static_cast<cl::sycl::buffer<DataType_t, dimensions>*>(this)));
+        *(static_cast<cl::sycl::buffer<DataType_t, dimensions>*>(this)),
+        offset, range);
   }
 
  public:
   template <access::mode mode,
             access::target target = access::target::global_buffer>
   accessor<DataType_t, dimensions, mode, target> get_access(handler& cgh) {
-    return get_access_device<mode, target>(cgh);
+    return get_access_device<mode, target>(
+        cgh, detail::empty_range<dimensions>(), rang);
+  }
+
+  /**
+   * Only the elements from offset up to offset + range
+   * are transferred for the kernel,
+   * indices inside the kernel are relative to the offset
+   */
+  template <access::mode mode,
+            access::target target = access::target::global_buffer>
+  accessor<DataType_t, dimensions, mode, target> get_access(
+      handler& cgh, range<dimensions> offset, range<dimensions> range) {
+    return get_access_device<mode, target>(cgh, offset, range);
   }
 
   template <access::mode mode, access::target target>
   accessor<DataType_t, dimensions, mode, target> get_access() {
-    return get_access_host<mode, target>();
+    return get_access_host<mode, target>(detail::empty_range<dimensions>(),
+                                         rang);
   }
 
- private:
-  // TODO(progtx):
-  void enqueue(queue* q, const vector_class<cl_event>& wait_events,
-               clEnqueueBuffer_f clEnqueueBuffer) final {
-    cl_event evnt;
-    auto error_code = this->cl_enqueue_buffer(
-        q, get_size(), host_data.get(), wait_events, evnt, clEnqueueBuffer);
-    detail::error::report(error_code);
-    events.emplace_back(evnt);
+  template <access::mode mode, access::target target>
+  accessor<DataType_t, dimensions, mode, target> get_access(
+      range<dimensions> offset, range<dimensions> range) {
+    return get_access_host<mode, target>(offset, range);
   }
 
  protected:
   template <info::detail::buffer param>
   param_traits_t<info::detail::buffer, param> get_info() const {
     return detail::non_vector_traits<info::detail::buffer, param, 1>::get(
-        device_data.get());
+        get_device_data());
   }
 
  public:
   void set_final_data(weak_ptr_class<DataType_t>& finalData);
 
-  // TODO(progtx): nullptr indicates not to copy back
-  void set_final_data(std::nullptr_t) {}
+  /** nullptr indicates not to copy back */
+  void set_final_data(std::nullptr_t) {
+    if (root == this) {
+      shared->write_back = false;
+    }
+  }
 };
 
 }  // namespace detail
@@ -343,7 +405,7 @@ struct buffer<DataType_t, 1> : public detail::buffer_detail<DataType_t, 1> {
   template <class InputIterator>
   buffer(InputIterator first, InputIterator last)
       : Base(nullptr, last - first) {
-    this->host_data = this->ptr_t(new DataType[last - first]);
+    this->host_data = detail::allocate_host<DataType>(last - first);
     std::copy(first, last, this->host_data.get());
   }
 
@@ -1,55 +1,274 @@
 #pragma once
 
+#include "SYCL/access.h"
 #include "SYCL/detail/common.h"
 #include "SYCL/detail/debug.h"
+#include "SYCL/detail/interval_set.h"
 #include "SYCL/event.h"
+#include <mutex>
 
 namespace cl {
 namespace sycl {
 
-// Forward declaration
+// Forward declarations
 class queue;
+template <int>
+class out_of_core_chunk;
 
 namespace detail {
 
 // Forward declarations
 class issue_command;
+class synchronizer;
+class task_graph;
 namespace command {
 class group_detail;
 }
 
+/**
+ * Part of a buffer in bytes,
+ * described the same way as in clEnqueueReadBufferRect.
+ * Rows are separated by row_pitch and slices by slice_pitch.
+ */
+struct buffer_region {
+  ::size_t origin = 0;
+  ::size_t row_size = 0;
+  ::size_t rows = 1;
+  ::size_t slices = 1;
+  ::size_t row_pitch = 0;
+  ::size_t slice_pitch = 0;
+
+  /** Number of bytes inside the region */
+  ::size_t size() const {
+    return row_size * rows * slices;
+  }
+  /** One past the last byte inside the region */
+  ::size_t end() const {
+    return origin + (slices - 1) * slice_pitch + (rows - 1) * row_pitch +
+           row_size;
+  }
+  /** Origin as the byte inside its row, the row and the slice */
+  void get_coordinates(::size_t coordinates[3]) const;
+  bool is_contiguous() const;
+  bool overlaps(const buffer_region& other) const;
+
+  /** Splits the region into as few contiguous byte intervals as possible */
+  vector_class<interval_set::interval> pieces() const;
+
+  /**
+   * The region of a sub-buffer,
+   * offsets and sizes are given in bytes for the first dimension
+   * and in rows and slices for the others
+   */
+  buffer_region sub_region(const ::size_t offset[3],
+                           const ::size_t size[3]) const;
+};
+
 class buffer_base {
  public:
-  virtual ~buffer_base() = default;
+  buffer_base() = default;
+  /**
+   * Copies of a root buffer are root buffers themselves,
+   * sharing the device data and the coherence state with the original
+   */
+  buffer_base(const buffer_base& copy);
+  buffer_base(buffer_base&& move) noexcept;
+  buffer_base& operator=(const buffer_base& copy);
+  buffer_base& operator=(buffer_base&& move) noexcept;
+  /** Returns pooled device memory to the pool once the last copy is gone */
+  virtual ~buffer_base();
 
  protected:
   friend class issue_command;
   friend class ::cl::sycl::queue;
   friend class command::group_detail;
+  friend class synchronizer;
+  friend class task_graph;
+  template <int>
+  friend class ::cl::sycl::out_of_core_chunk;
 
+  /**
+   * Device data of a sub-buffer,
+   * either a cl_mem created by clCreateSubBuffer
+   * or a separate copy of the region, see device_copy.
+   * A root buffer keeps its device data in the shared state.
+   */
   detail::refc<cl_mem, clRetainMemObject, clReleaseMemObject> device_data;
-  vector_class<event> events;
+
+  /** Buffer owning the memory, the buffer itself unless it's a sub-buffer */
+  buffer_base* root = this;
+  /** Location inside the root buffer */
+  buffer_region region;
+  /**
+   * Set for sub-buffers that cannot alias the memory of the root buffer,
+   * because they aren't contiguous or not aligned as the device requires.
+   * The region is then copied between both before and after kernels.
+   */
+  bool device_copy = false;
+  /** Whether the device data of a sub-buffer came from the memory pool */
+  bool pooled = false;
+  /**
+   * Set on a sub-buffer of an out-of-core buffer,
+   * its device memory holds only its region
+   * and is transferred directly to and from the host
+   */
+  bool detached = false;
+
+  /**
+   * State of a root buffer shared with all of its copies,
+   * which refer to the same data and count as the same buffer
+   * for dependencies.
+   * Sub-buffers use the state of their root buffer.
+   */
+  struct shared_state {
+    detail::refc<cl_mem, clRetainMemObject, clReleaseMemObject> device_data;
+    /**
+     * Set when the device shares memory with the host,
+     * the host then maps the device data instead of copying it
+     */
+    bool zero_copy = false;
+    /** Whether the device data came from the memory pool */
+    bool pooled = false;
+    /**
+     * Set on a root buffer processed in chunks by out_of_core,
+     * its sub-buffers then get device memory of their own
+     * instead of sharing that of the root buffer
+     */
+    bool out_of_core = false;
+
+    // Coherence state, data is only transferred when the other side needs it.
+    // It covers all sub-buffers of the root buffer,
+    // in bytes relative to the start of the root buffer.
+    // There is a single cl_mem per buffer, so the device side is per context,
+    // OpenCL itself migrates the data between devices of the same context.
+    /** Where the device data is newer than the host data */
+    interval_set host_stale;
+    /** Where the host data is newer than the device data */
+    interval_set device_stale;
+    /** Whether the data is copied back to the host on destruction */
+    bool write_back = true;
+    /** Queue of the last command using the device data */
+    detail::refc<cl_command_queue, clRetainCommandQueue, clReleaseCommandQueue>
+        last_queue;
+    /**
+     * Guards the coherence state,
+     * host accessors update it outside of the task graph lock.
+     * Recursive because host accesses update the host data on the way.
+     */
+    std::recursive_mutex coherence_lock;
+  };
+  /** Only set on root buffers */
+  shared_ptr_class<shared_state> shared;
+
+  /** The device data of the root buffer for a root buffer */
+  cl_mem get_device_data() const {
+    return root == this ? shared->device_data.get() : device_data.get();
+  }
+  /**
+   * Identifies the buffer in the task graph and the synchronizer,
+   * copies of a root buffer share it
+   */
+  const void* identity() const {
+    if (root == this) {
+      return shared.get();
+    }
+    return this;
+  }
+  /** Whether no other copy of the buffer refers to the same data */
+  bool is_last_copy() const {
+    return root != this || shared.use_count() == 1;
+  }
+  /** Whether destroying the buffer copies its data back to the host */
+  bool needs_write_back() const {
+    return root == this && shared.use_count() == 1 && shared->write_back;
+  }
 
   void create_accessor_command();
 
-  using clEnqueueBuffer_f = decltype(&clEnqueueWriteBuffer);
-  virtual void enqueue(queue* q, const vector_class<cl_event>& wait_events,
-                       clEnqueueBuffer_f clEnqueueBuffer) {
+  /** Host memory of a root buffer */
+  virtual void* host_pointer() {
     DSELF() << "not implemented";
+    return nullptr;
   }
-  static void enqueue_command(queue* q,
-                              const vector_class<cl_event>& wait_events,
-                              buffer_base* buffer,
-                              clEnqueueBuffer_f clEnqueueBuffer) {
-    buffer->enqueue(q, wait_events, clEnqueueBuffer);
+
+  /** Sets up the region and coherence state of a root buffer */
+  void init_root(::size_t element_size, const ::size_t range[3]);
+  /** Sets up the region of a sub-buffer relative to its parent */
+  void init_sub_buffer(buffer_base& parent, ::size_t element_size,
+                       const ::size_t offset[3], const ::size_t range[3]);
+
+  /**
+   * Copies the accessed host data to the device
+   * unless the device already has it
+   */
+  static void update_device_command(queue* q,
+                                    const vector_class<cl_event>& wait_events,
+                                    event* evnt, buffer_base* buffer,
+                                    buffer_region accessed);
+  /** Records that a kernel has modified the accessed device data */
+  static void device_written_command(queue* q,
+                                     const vector_class<cl_event>& wait_events,
+                                     event* evnt, buffer_base* buffer,
+                                     buffer_region accessed);
+
+  /**
+   * Blocks until the host data is up to date,
+   * the command groups writing the buffer have to be complete
+   */
+  void update_host() {
+    update_host(region);
   }
-  ::cl_int cl_enqueue_buffer(queue* q, ::size_t size, void* host_ptr,
-                             const vector_class<cl_event>& wait_events,
-                             cl_event& evnt, clEnqueueBuffer_f clEnqueueBuffer);
+  void update_host(const buffer_region& accessed);
+  /**
+   * Prepares the accessed host data for a host accessor.
+   * Returns the mapped pointer if the region had to be mapped.
+   */
+  void* acquire_host(access::mode mode, const buffer_region& accessed);
+  /** Unmaps the region mapped for a host accessor */
+  void release_host(void* mapped);
+  /** Maps the accessed region, blocking until it is available */
+  void* map(const buffer_region& accessed, cl_map_flags flags);
+
+  /**
+   * Transfers the stale parts of the accessed region
+   * between the host and the root buffer,
+   * using a single rectangular transfer if the whole region is stale
+   */
+  event transfer(cl_command_queue q, const vector_class<cl_event>& wait_events,
+                 const buffer_region& accessed, bool to_device);
+  /** Transfers the region between the host and a detached sub-buffer */
+  event transfer_detached(cl_command_queue q,
+                          const vector_class<cl_event>& wait_events,
+                          bool to_device);
+  /** Copies the region between the root buffer and a separate copy */
+  event copy_region(cl_command_queue q,
+                    const vector_class<cl_event>& wait_events, bool to_copy);
 
   static cl_mem cl_create_buffer(queue* q, const cl_mem_flags& flags,
                                  ::size_t size, void* host_ptr,
                                  ::cl_int& error_code);
+  /**
+   * Creates the device data of a root buffer,
+   * using the host memory if the device shares it with the host
+   * and the memory pool otherwise
+   */
+  void create_root_buffer(queue* q, cl_mem_flags flags, ::size_t size,
+                          void* host_ptr);
+  /**
+   * Creates the device data of a sub-buffer,
+   * the device data of the root buffer has to exist already
+   * unless the root buffer is out-of-core
+   */
+  void create_sub_buffer(queue* q, cl_mem_flags flags);
+  bool needs_root_device_data() const {
+    return !root->shared->out_of_core;
+  }
+
+  /**
+   * Brings the host data up to date and makes sub-buffers created from now on
+   * detached, blocks until all command groups using the buffer have completed
+   */
+  void make_out_of_core();
 };
 
 }  // namespace detail
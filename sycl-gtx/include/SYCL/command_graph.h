@@ -0,0 +1,108 @@
+#pragma once
+
+// Record once, replay many times (sycl-gtx extension)
+
+#include "SYCL/buffer.h"
+#include "SYCL/command_group.h"
+#include "SYCL/detail/common.h"
+#include "SYCL/error_handler.h"
+#include "SYCL/handler_event.h"
+#include <map>
+
+namespace cl {
+namespace sycl {
+
+// Forward declaration
+class queue;
+
+/**
+ * A sequence of command groups recorded once and replayed many times.
+ *
+ * Recording runs the command group functor and traces its kernels as usual,
+ * but nothing is executed.
+ * Only the device data of buffers used for the first time is created,
+ * so regular submissions can use them before the first replay.
+ * Replaying submits the recorded commands with their kernels already built,
+ * so the functors, kernel tracing and command optimization are all skipped.
+ * Dependencies are derived again on each replay,
+ * the same way as for regular submissions.
+ *
+ * Replays use the buffers and captured scalar values seen while recording,
+ * unless they are bound to others with set_arg and rebind,
+ * e.g. for a time step that changes or buffers swapped between steps.
+ * The commands themselves can't change.
+ * The queue and all buffers used must outlive the graph.
+ */
+class command_graph {
+ private:
+  queue* q;
+  vector_class<detail::command_group> groups;
+  /** Recorded buffers and the buffers replays use instead */
+  std::map<detail::buffer_base*, detail::buffer_base*> replacements;
+
+ public:
+  explicit command_graph(queue& q);
+
+  /** Records the command group instead of submitting it */
+  template <typename T>
+  void submit(T cgf) {
+    groups.emplace_back(*q, cgf);
+    groups.back().init_buffers();
+    groups.back().optimize();
+    groups.back().record_args();
+  }
+
+  /**
+   * Sets a scalar captured by the kernel of a recorded command group
+   * for the following replays.
+   * @param group index of the command group in order of recording
+   * @param index of the scalar in order of first use in the kernel
+   */
+  template <typename T>
+  void set_arg(::size_t group, ::size_t index, const T& value) {
+    if (group >= groups.size()) {
+      detail::error::report(CL_INVALID_VALUE);
+    }
+    auto bytes = reinterpret_cast<const char*>(&value);
+    groups[group].set_arg(index, vector_class<char>(bytes, bytes + sizeof(T)));
+  }
+
+  /**
+   * The following replays use the replacement
+   * wherever the graph was recorded with the other buffer.
+   * Both have to be root buffers of the same size.
+   * Rebinding a recorded buffer to itself restores it.
+   */
+  template <typename DataType, int dimensions>
+  void rebind(buffer<DataType, dimensions>& recorded,
+              buffer<DataType, dimensions>& replacement) {
+    if (recorded.root != &recorded || replacement.root != &replacement) {
+      detail::error::report(CL_INVALID_MEM_OBJECT);
+    }
+    if (recorded.get_size() != replacement.get_size()) {
+      detail::error::report(CL_INVALID_BUFFER_SIZE);
+    }
+    if (&recorded == &replacement) {
+      replacements.erase(&recorded);
+      return;
+    }
+    // Recording only created the device data of the recorded buffers
+    replacement.create_device_data(q);
+    replacements[&recorded] = &replacement;
+  }
+
+  /**
+   * Submits all recorded command groups in the order they were recorded.
+   * @return the events of the last command group
+   */
+  handler_event replay();
+
+  /** Number of recorded command groups */
+  ::size_t size() const;
+
+  /** Forgets all recorded command groups and rebound buffers */
+  void clear();
+};
+
+}  // namespace sycl
+}  // namespace cl
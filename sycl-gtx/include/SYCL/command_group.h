@@ -6,7 +6,9 @@
 #include "SYCL/buffer_base.h"
 #include "SYCL/detail/common.h"
 #include "SYCL/detail/debug.h"
+#include "SYCL/event.h"
 #include "SYCL/ranges.h"
+#include <map>
 #include <set>
 
 namespace cl {
@@ -30,11 +32,23 @@ namespace command {
 // Forward declaration
 class group_detail;
 
-enum class type_t { unspecified, get_accessor, copy_data, kernel };
+enum class type_t {
+  unspecified,
+  init_buffer,
+  get_accessor,
+  copy_data,
+  kernel
+};
 
 static debug& operator<<(debug& d, type_t t) {
+  if (!d.active()) {
+    return d;
+  }
   string_class str("command::type::");
   switch (t) {
+    case type_t::init_buffer:
+      str += "init_buffer";
+      break;
     case type_t::get_accessor:
       str += "get_accessor";
       break;
@@ -56,6 +70,10 @@ static debug& operator<<(debug& d, type_t t) {
 struct buffer_copy {
   buffer_access buf;
   access::mode mode;
+  /** Command function and region, to bind the copy to another buffer */
+  void (*transfer)(queue*, const vector_class<cl_event>&, event*, buffer_base*,
+                   buffer_region);
+  buffer_region region;
 };
 
 union metadata {
@@ -68,19 +86,31 @@ union metadata {
   metadata(buffer_copy buf_copy) : buf_copy(buf_copy) {}
 };
 
+/**
+ * Commands receive the events they have to wait on
+ * and store the event of the enqueued OpenCL command, if there is one
+ */
 struct info {
-  using command_f = function_class<void(queue*, const vector_class<cl_event>&)>;
+  using command_f =
+      function_class<void(queue*, const vector_class<cl_event>&, event*)>;
 
   string_class name;  // Only for debugging
   command_f function;
   type_t type;
   metadata data;
 
-  static void do_nothing(queue* q, const vector_class<cl_event>&) {}
+  static void do_nothing(queue* q, const vector_class<cl_event>&, event*) {}
 };
 
 }  // namespace command
 
+/** Captured scalars and buffers a recorded kernel is enqueued with */
+struct kernel_args {
+  vector_class<vector_class<char>> scalars;
+  /** Buffers of the accessors, in order of the kernel arguments */
+  vector_class<buffer_base*> buffers;
+};
+
 /**
  * A command group in SYCL as it is defined in 2.3.1
  * includes a kernel to be enqueued along with all the commands
@@ -91,7 +121,7 @@ class command_group {
  private:
   friend class kernel;
   friend class command::group_detail;
-  friend class ::cl::sycl::queue;
+  friend class task_graph;
   using command_t = command::info;
   using command_f = command_t::command_f;
 
@@ -99,6 +129,19 @@ class command_group {
   std::set<buffer_base*> read_buffers;
   std::set<buffer_base*> write_buffers;
   queue* q;
+  bool optimized = false;
+  /** Last kernel invoked, names the runtime statistics of the group */
+  string_class kernel_name;
+  /** Event of the last kernel command, known after flushing */
+  event kernel_event;
+  /** Kernels invoked by the group, in order */
+  vector_class<shared_ptr_class<kernel>> kernels;
+  /**
+   * Arguments of the kernels of a group recorded by a command graph.
+   * The replayed copies of the group share the kernels,
+   * so each copy sets its arguments right before enqueueing a kernel.
+   */
+  vector_class<kernel_args> bound_args;
 
   void enter();
   void exit();
@@ -140,8 +183,24 @@ class command_group {
   template <typename functorT>
   command_group(queue& primaryQueue, queue& secondaryQueue, functorT lambda);
 
+  /**
+   * Creates the device data of the buffers the group uses for the first time,
+   * which the buffers expect to exist for every later command group
+   */
+  void init_buffers();
+  /** Only does the work once, so a recorded group can be replayed cheaply */
   void optimize();
-  void flush(vector_class<cl_event> wait_events);
+  /** Keeps the current arguments of the kernels with the group */
+  void record_args();
+  /**
+   * Sets a captured scalar of the last kernel of a recorded group,
+   * the index counts the scalars in order of first use in the kernel
+   */
+  void set_arg(::size_t index, vector_class<char> value);
+  /** Uses the mapped buffers instead of those the group was recorded with */
+  void rebind(const std::map<buffer_base*, buffer_base*>& replacements);
+  /** Returns an event that completes together with all commands */
+  event flush(vector_class<cl_event> wait_events);
 };
 
 namespace command {
@@ -150,60 +209,69 @@ class group_detail {
  private:
   friend class ::cl::sycl::detail::command_group;
 
-  // TODO(progtx): Need to deal better with threads
+  /**
+   * Command group currently being recorded by this thread.
+   * A command group has to be recorded on the thread that submits it.
+   */
   SYCL_THREAD_LOCAL static command_group* last;
 
   template <class... Args>
-  using fn = void (*)(queue*, const vector_class<cl_event>&, Args...);
+  using fn = void (*)(queue*, const vector_class<cl_event>&, event*, Args...);
 
   template <class... Args>
-  using kern_fn = fn<shared_ptr_class<kernel>, event*, Args...>;
+  using kern_fn = fn<shared_ptr_class<kernel>, Args...>;
 
   template <type_t type = type_t::unspecified, class F, class... Args>
   static void add_command(F function, string_class name, Args... params) {
-    last->commands.push_back({name,
-                              std::bind(function, std::placeholders::_1,
-                                        std::placeholders::_2, params...),
-                              type});
+    last->commands.push_back(
+        {name,
+         std::bind(function, std::placeholders::_1, std::placeholders::_2,
+                   std::placeholders::_3, params...),
+         type});
   }
 
  public:
   static void add_kernel_enqueue_task(kern_fn<> function, string_class name,
-                                      shared_ptr_class<kernel> kern,
-                                      event* evnt) {
-    add_command(function, name, kern, evnt);
+                                      shared_ptr_class<kernel> kern) {
+    last->kernels.push_back(kern);
+    add_command<type_t::kernel>(function, name, kern);
   }
 
   template <int dimensions>
   static void add_kernel_enqueue_range(
       kern_fn<range<dimensions>, id<dimensions>> function, string_class name,
-      shared_ptr_class<kernel> kern, event* evnt,
-      range<dimensions> num_work_items, id<dimensions> offset) {
-    add_command(function, name, kern, evnt, num_work_items, offset);
+      shared_ptr_class<kernel> kern, range<dimensions> num_work_items,
+      id<dimensions> offset) {
+    last->kernels.push_back(kern);
+    add_command<type_t::kernel>(function, name, kern, num_work_items,
+                                offset);
   }
 
   template <int dimensions>
   static void add_kernel_enqueue_nd_range(
       kern_fn<nd_range<dimensions>> function, string_class name,
-      shared_ptr_class<kernel> kern, event* evnt,
-      nd_range<dimensions> execution_range) {
-    add_command(function, name, kern, evnt, execution_range);
+      shared_ptr_class<kernel> kern, nd_range<dimensions> execution_range) {
+    last->kernels.push_back(kern);
+    add_command<type_t::kernel>(function, name, kern, execution_range);
   }
 
   template <typename DataType, int dimensions>
   static void add_buffer_init(fn<buffer_detail<DataType, dimensions>*> function,
                               string_class name,
                               buffer_detail<DataType, dimensions>* buff) {
-    add_command(function, name, buff);
+    add_command<type_t::init_buffer>(function, name, buff);
   }
 
   static void add_buffer_access(buffer_access buf_acc, string_class name);
 
-  static void add_buffer_copy(
-      buffer_access buf_acc, access::mode copy_mode,
-      fn<buffer_base*, buffer_base::clEnqueueBuffer_f> function,
-      string_class name, buffer_base* buffer,
-      buffer_base::clEnqueueBuffer_f enqueue_function);
+  static void add_buffer_copy(buffer_access buf_acc, access::mode copy_mode,
+                              fn<buffer_base*, buffer_region> function,
+                              string_class name, buffer_base* buffer,
+                              const buffer_region& accessed);
+
+  static void set_kernel_name(string_class name) {
+    last->kernel_name = std::move(name);
+  }
 
   static bool in_scope();
   static void check_scope();
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "SYCL/detail/common.h"
+#include <atomic>
+#include <map>
+#include <set>
+
+namespace cl {
+namespace sycl {
+
+// Forward declaration
+class device;
+
+namespace detail {
+
+/**
+ * Persistent cache of program binaries shared between application runs.
+ *
+ * The cache directory is read from the SYCL_GTX_CACHE_DIR environment variable
+ * and has to exist beforehand; the cache is disabled if the variable is unset.
+ * Each entry is stored in its own file, written atomically,
+ * so multiple processes can share the same directory.
+ * Within a process, the in-memory state is guarded by a lock.
+ */
+class binary_cache {
+ public:
+  struct entry {
+    /** Name of the kernel function inside the binaries */
+    string_class kernel_name;
+    /** One binary per device, in the order the devices were given */
+    vector_class<vector_class<unsigned char>> binaries;
+  };
+
+  static const char* const environment_variable;
+
+ private:
+  static bool directory_set;
+  static string_class directory;
+  /** Entries imported while no cache directory was set */
+  static std::map<string_class, entry> imported;
+  /** Keys of all entries loaded or stored by this process */
+  static std::set<string_class> used_keys;
+  static mutex_class lock;
+  /** Makes temporary file names unique within the process */
+  static std::atomic<unsigned int> temp_counter;
+  static std::atomic<::size_t> disk_loads;
+
+  static string_class get_file_name(const string_class& key);
+  static bool read_file(const string_class& file_name, const string_class& key,
+                        entry& e);
+  static bool write_file(const string_class& file_name, const string_class& key,
+                         const entry& e);
+
+ public:
+  /** Overrides the environment variable, an empty string disables the cache */
+  static void set_directory(string_class dir);
+  static string_class get_directory();
+  static bool is_enabled();
+
+  /**
+   * The key consists of the device names and driver versions,
+   * the build options and the normalized kernel source
+   */
+  static string_class get_key(const vector_class<device>& devices,
+                              const string_class& options,
+                              const string_class& code);
+
+  static bool load(const string_class& key, entry& e);
+  static void store(const string_class& key, const entry& e);
+
+  /** Number of entries this process has read from the cache directory */
+  static ::size_t get_disk_loads();
+
+  // Exposed as program_cache
+  static void export_bundle(const string_class& file_name);
+  static void import_bundle(const string_class& file_name);
+};
+
+}  // namespace detail
+
+}  // namespace sycl
+}  // namespace cl
@@ -192,13 +192,32 @@ struct get_string {
     return s.str();
   }
 };
-// TODO(progtx): Should be more efficient
+
+// Integers are written often while tracing kernels, avoid the stream
+#define SYCL_GET_INTEGER_STRING(type) \
+  template <>                         \
+  struct get_string<type> {           \
+    static string_class get(type t) { \
+      return std::to_string(t);       \
+    }                                 \
+  };
+
+SYCL_GET_INTEGER_STRING(int)
+SYCL_GET_INTEGER_STRING(unsigned int)
+SYCL_GET_INTEGER_STRING(long)
+SYCL_GET_INTEGER_STRING(unsigned long)
+SYCL_GET_INTEGER_STRING(long long)
+SYCL_GET_INTEGER_STRING(unsigned long long)
+
+#undef SYCL_GET_INTEGER_STRING
+
 template <>
 struct get_string<float> {
   static string_class get(float t) {
-    std::stringstream s;
-    s << t;
-    auto str = s.str();
+    // Same format as writing to a stream
+    char buffer[32];
+    std::sprintf(buffer, "%g", t);
+    string_class str(buffer);
     if (str.find('e') == string_class::npos &&
         str.find('.') == string_class::npos) {
       str += ".f";
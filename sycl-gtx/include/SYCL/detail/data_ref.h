@@ -2,6 +2,7 @@
 
 #include "SYCL/detail/common.h"
 #include "SYCL/detail/debug.h"
+#include "SYCL/detail/kernel_ir.h"
 #include <type_traits>
 
 namespace cl {
@@ -13,8 +14,43 @@ struct id;
 
 namespace detail {
 
-// Forward declaration
-void kernel_add(string_class line);
+// Forward declarations
+void kernel_add(const ir::expr& line);
+void kernel_assign(const ir::expr& target, const char* op,
+                   const ir::expr& value);
+void kernel_declare(const ir::expr& type, const ir::expr& target,
+                    const ir::expr& value = ir::expr());
+string_class kernel_add_argument(const void* address, ::size_t size,
+                                 const char* type_name);
+void kernel_enable_extension(const char* name);
+
+/**
+ * OpenCL name of a scalar type that can be passed as a kernel argument.
+ * bool is not allowed as an argument
+ * and double would require cl_khr_fp64, so these remain literals.
+ */
+template <typename T>
+const char* argument_type_name() {
+  if (std::is_same<T, bool>::value) {
+    return nullptr;
+  }
+  if (std::is_floating_point<T>::value) {
+    return sizeof(T) == sizeof(::cl_float) ? "float" : nullptr;
+  }
+  auto is_signed = std::is_signed<T>::value;
+  switch (sizeof(T)) {
+    case 1:
+      return is_signed ? "char" : "uchar";
+    case 2:
+      return is_signed ? "short" : "ushort";
+    case 4:
+      return is_signed ? "int" : "uint";
+    case 8:
+      return is_signed ? "long" : "ulong";
+    default:
+      return nullptr;
+  }
+}
 
 /**
  * Data reference wrappers
@@ -28,30 +64,40 @@ class data_ref {
     id_local,
     range_global,
     range_local,
+    id_group,
+    range_group,
     expression,
   };
 
   static const string_class open_parenthesis;
-  string_class name;
+  /** Code of the reference, stored in the IR of the traced kernel */
+  ir::expr name;
   type_t type;
 
-  static string_class get_name(const data_ref& dref) {
+  static const ir::expr& get_name(const data_ref& dref) {
     return dref.name;
   }
 
+  /**
+   * Scalars captured by the kernel functor become kernel arguments,
+   * so that changing their value doesn't require recompiling the kernel
+   */
   template <typename T, typename std::enable_if<
                             std::is_arithmetic<T>::value>::type* = nullptr>
-  static string_class get_name(const T& n) {
-    return get_string<T>::get(n);
+  static ir::expr get_name(const T& n) {
+    auto arg = kernel_add_argument(&n, sizeof(T), argument_type_name<T>());
+    return arg.empty() ? get_string<T>::get(n) : arg;
   }
 
   template <typename T,
             typename std::enable_if<std::is_enum<T>::value>::type* = nullptr>
-  static string_class get_name(const T& n) {
+  static ir::expr get_name(const T& n) {
     auto value = static_cast<typename std::underlying_type<T>::type>(n);
     return get_string<decltype(value)>::get(value);
   }
 
+  data_ref(ir::expr name) : name(std::move(name)) {}
+
   data_ref(string_class name) : name(name) {}
 
   data_ref(char* name) : name(name) {}
@@ -76,36 +122,34 @@ class data_ref {
 
   // We need to generate a new line, no matter whether moving or copying
   data_ref& operator=(const data_ref& dref) {
-    kernel_add(name + " = " + dref.name);
+    kernel_assign(name, "=", dref.name);
     return *this;
   }
   data_ref& operator=(data_ref&& dref) noexcept {
-    kernel_add(name + " = " + dref.name);
+    kernel_assign(name, "=", dref.name);
     return *this;
   }
 
   // TODO(progtx):
   // https://www.khronos.org/registry/cl/sdk/1.2/docs/man/xhtml/operators.html
 
-#define SYCL_ASSIGNMENT_OPERATOR(op)              \
-  template <class T>                              \
-  data_ref& operator op(const T& n) {             \
-    kernel_add(name + " " #op " " + get_name(n)); \
-    return *this;                                 \
+#define SYCL_ASSIGNMENT_OPERATOR(op)       \
+  template <class T>                       \
+  data_ref& operator op(const T& n) {      \
+    kernel_assign(name, #op, get_name(n)); \
+    return *this;                          \
   }
 
-#define SYCL_DATA_REF_OPERATOR(op)                                             \
-  template <class T>                                                           \
-  data_ref operator op(const T& n) const {                                     \
-    return data_ref(open_parenthesis + name + " " #op " " + get_name(n) +      \
-                    ')');                                                      \
-  }                                                                            \
-  template <typename T,                                                        \
-            typename std::enable_if<std::is_arithmetic<T>::value>::type* =     \
-                nullptr>                                                       \
-  friend data_ref operator op(const T& n, const data_ref& dref) {              \
-    return data_ref(open_parenthesis + get_name(n) + " " #op " " + dref.name + \
-                    ')');                                                      \
+#define SYCL_DATA_REF_OPERATOR(op)                                         \
+  template <class T>                                                       \
+  data_ref operator op(const T& n) const {                                 \
+    return data_ref(ir::expr::binary(#op, name, get_name(n)));             \
+  }                                                                        \
+  template <typename T,                                                    \
+            typename std::enable_if<std::is_arithmetic<T>::value>::type* = \
+                nullptr>                                                   \
+  friend data_ref operator op(const T& n, const data_ref& dref) {          \
+    return data_ref(ir::expr::binary(#op, get_name(n), dref.name));        \
   }
 
   SYCL_ASSIGNMENT_OPERATOR(=);
@@ -156,20 +200,20 @@ class data_ref {
   // But there is no way to distinguish it
   // Here presume an expression
   data_ref operator++() const {
-    return data_ref(open_parenthesis + "++" + name + ')');
+    return data_ref(ir::expr::prefix("++", name));
   }
   data_ref operator++(int) const {
-    return data_ref(open_parenthesis + name + "++" + ')');
+    return data_ref(ir::expr::postfix("++", name));
   }
   data_ref operator--() const {
-    return data_ref(open_parenthesis + "--" + name + ')');
+    return data_ref(ir::expr::prefix("--", name));
   }
   data_ref operator--(int) const {
-    return data_ref(open_parenthesis + name + "--" + ')');
+    return data_ref(ir::expr::postfix("--", name));
   }
 
   data_ref operator!() const {
-    return data_ref(open_parenthesis + '!' + name + ')');
+    return data_ref(ir::expr::prefix("!", name));
   }
 };
 
@@ -2,39 +2,97 @@
 
 #include "SYCL/detail/msvc_version.h"
 
+#include <atomic>
 #include <cmath>
 #include <iostream>
+#include <memory>
 #include <sstream>
+#include <string>
 
 #if MSVC_2013_OR_LOWER
 #define __func__ __FUNCTION__
 #define constexpr const
 #endif
 
-#define DSELF() debug(__func__)
-
-#ifndef NDEBUG
-#define SYCL_ENABLE_DEBUG 1
-#endif
-
-#if SYCL_ENABLE_DEBUG
+namespace cl {
+namespace sycl {
+namespace detail {
+namespace logging {
+
+enum class level : unsigned char { off, error, warning, info, debug, trace };
+enum class category : unsigned char { runtime, codegen, transfers, sync };
+static const int num_categories = 4;
+
+/**
+ * Most detailed level written for each category.
+ * Set from the SYCL_GTX_LOG environment variable at startup,
+ * e.g. "info" or "warning;trace:sync,transfers".
+ * Defaults to debug in debug builds and to warning otherwise.
+ */
+extern std::atomic<unsigned char> thresholds[num_categories];
+
+inline bool enabled(level l, category c) {
+  return static_cast<unsigned char>(l) <=
+         thresholds[static_cast<int>(c)].load(std::memory_order_relaxed);
+}
+
+void set_level(level l, category c);
+/** Sets the level of all categories */
+void set_level(level l);
+/** Parses a configuration in the format of SYCL_GTX_LOG */
+void configure(const std::string& config);
+
+/**
+ * Queues the line for the background writer thread.
+ * Errors are written right away, after everything queued before them.
+ */
+void write(level l, std::string line);
+/** Blocks until all queued lines are written */
+void flush();
+
+}  // namespace logging
+}  // namespace detail
+}  // namespace sycl
+}  // namespace cl
+
+/**
+ * Only evaluates the streamed values if the level is enabled for the category:
+ * SYCL_LOG(debug, codegen) << code;
+ */
+#define SYCL_LOG(lvl, cat)                                   \
+  if (!::cl::sycl::detail::logging::enabled(                 \
+          ::cl::sycl::detail::logging::level::lvl,           \
+          ::cl::sycl::detail::logging::category::cat)) {     \
+  } else                                                     \
+    debug(::cl::sycl::detail::logging::level::lvl,           \
+          ::cl::sycl::detail::logging::category::cat, false) \
+        .self()
+
+#define DSELF() SYCL_LOG(trace, runtime) << __func__
+
+/**
+ * A single log line, written when the object is destroyed.
+ * Nothing is formatted unless the line is enabled.
+ */
 class debug {
  protected:
-  static constexpr bool DEBUG_ACTIVE = true;
-  std::stringstream stream;
-  std::stringstream before;
+  using level = ::cl::sycl::detail::logging::level;
+  using category = ::cl::sycl::detail::logging::category;
+
+  level lvl = level::debug;
+  std::unique_ptr<std::ostringstream> stream;
 
   template <typename T>
   void AddToStream(T add) {
-    if (DEBUG_ACTIVE) {
-      stream << add << ' ';
+    if (stream) {
+      *stream << add << ' ';
     }
   }
 
   template <class T>
   void AddToStream(std::basic_string<T> string) {
-    if (DEBUG_ACTIVE) {
-      stream << string << ' ';
+    if (stream) {
+      *stream << string << ' ';
     }
   }
 
@@ -47,19 +105,16 @@ class debug {
   }
 
  public:
-  debug() = default;
-#if MSVC_2013_OR_LOWER
-  debug(debug&& move)
-      : stream(std::move(move.stream)), before(std::move(move.before)) {}
-#elif defined(__GNUC__) && (__GNUC__ < 5)
-  // https://gcc.gnu.org/bugzilla/show_bug.cgi?id=54316
-  debug(debug&& move) noexcept {
-    stream << move.stream.str();
-    before << move.before.str();
+  debug() : debug(level::debug, category::runtime) {}
+
+  /** The check can be skipped if the caller already did it */
+  debug(level l, category c, bool check = true) : lvl(l) {
+    if (!check || ::cl::sycl::detail::logging::enabled(l, c)) {
+      stream.reset(new std::ostringstream());
+    }
   }
-#else
+
   debug(debug&& move) = default;
-#endif
   debug(const debug& copy) = delete;
 
   debug& operator=(const debug& copy) = delete;
@@ -67,13 +122,17 @@ class debug {
 
   template <typename T>
   debug(T add) : debug() {
-    before << "Debug: ";
+    if (stream) {
+      *stream << "Debug: ";
+    }
     AddToStream(add);
   }
 
   template <typename U, typename T>
   debug(U before, T add) : debug() {
-    this->before << before;
+    if (stream) {
+      *stream << before;
+    }
     AddToStream(add);
   }
 
@@ -84,37 +143,38 @@ class debug {
   }
 
   ~debug() {
-    if (DEBUG_ACTIVE) {
-      std::cout << before.str() << stream.str() << std::endl;
+    if (stream) {
+      ::cl::sycl::detail::logging::write(lvl, stream->str());
     }
   }
 
-  template <typename T>
-  static debug warning(T message) {
-    return debug("SYCL warning: ", message);
+  /** Lets free operator<< overloads take the temporary */
+  debug& self() {
+    return *this;
   }
-};
-#else
-class debug {
- public:
-  debug() {}
-
-  template <typename T>
-  debug(T) {}
 
-  template <typename U, typename T>
-  debug(U before, T add) {}
-
-  template <typename T>
-  debug& operator<<(T add) {
-    return *this;
+  /** Whether the line is going to be written */
+  bool active() const {
+    return stream != nullptr;
   }
 
   template <typename T>
   static debug warning(T message) {
-    return debug();
+    debug d(level::warning, category::runtime);
+    if (d.stream) {
+      *d.stream << "SYCL warning: ";
+    }
+    d.AddToStream(message);
+    return d;
   }
 
-  ~debug() {}
+  template <typename T>
+  static debug error(T message) {
+    debug d(level::error, category::runtime);
+    if (d.stream) {
+      *d.stream << "SYCL error: ";
+    }
+    d.AddToStream(message);
+    return d;
+  }
 };
-#endif
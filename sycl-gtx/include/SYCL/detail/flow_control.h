@@ -13,26 +13,25 @@ namespace detail {
 namespace control {
 
 static void if_detail(data_ref condition) {
-  kernel_ns::source::add<false>(string_class("if(") + condition.name + ")");
+  kernel_ns::source::control("if", "if(" + condition.name + ')');
 }
 
 static void else_if(data_ref condition) {
-  kernel_ns::source::add<false>(string_class("else if(") + condition.name +
-                                ")");
+  kernel_ns::source::control("else if", "else if(" + condition.name + ')');
 }
 
 static void else_detail() {
-  kernel_ns::source::add<false>("else");
+  kernel_ns::source::control("else", "else");
 }
 
 static void while_detail(data_ref condition) {
-  kernel_ns::source::add<false>(string_class("while( ") + condition.name + ")");
+  kernel_ns::source::control("while", "while( " + condition.name + ')');
 }
 
 /** Note: Increment can only be ++ or --, other assignments don't work */
 static void for_detail(data_ref condition, data_ref increment) {
-  kernel_ns::source::add<false>(string_class("for(; ") + condition.name + "; " +
-                                increment.name + ")");
+  kernel_ns::source::control(
+      "for", "for(; " + condition.name + "; " + increment.name + ')');
 }
 
 static void break_detail() {
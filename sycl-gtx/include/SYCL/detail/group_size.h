@@ -0,0 +1,68 @@
+#pragma once
+
+// Work-group sizes of the built-in algorithms
+
+#include "SYCL/detail/common.h"
+#include "SYCL/device.h"
+#include "SYCL/info.h"
+#include "SYCL/queue.h"
+#include <map>
+#include <mutex>
+#include <tuple>
+
+namespace cl {
+namespace sycl {
+
+namespace detail {
+
+/**
+ * Largest power of two work-group size up to max_size
+ * that fits the local memory of the device,
+ * with bytes_per_item for each work item and fixed_bytes per group.
+ * At least 1.
+ */
+::size_t power_of_two_group_size(const device& dev, ::size_t max_size,
+                                 ::size_t bytes_per_item,
+                                 ::size_t fixed_bytes = 0);
+
+/**
+ * Work-group size for kernels whose code depends on it,
+ * a power of two within the local memory of the device
+ * and within the work-group sizes of the kernels built by probe(size).
+ * The probe builds them in a command group without invoking them,
+ * see handler::get_work_group_size, and returns the smallest size.
+ * It runs once per device, bytes_per_item and fixed_bytes for each Tag.
+ */
+template <class Tag, class Probe>
+::size_t fitted_group_size(queue& q, ::size_t bytes_per_item,
+                           ::size_t fixed_bytes, Probe probe) {
+  static mutex_class lock;
+  static std::map<std::tuple<cl_device_id, ::size_t, ::size_t>, ::size_t>
+      sizes;
+
+  auto dev = q.get_device();
+  auto key = std::make_tuple(dev.get(), bytes_per_item, fixed_bytes);
+  std::lock_guard<mutex_class> guard(lock);
+  auto it = sizes.find(key);
+  if (it != sizes.end()) {
+    return it->second;
+  }
+
+  auto size = power_of_two_group_size(
+      dev, dev.get_info<info::device::max_work_group_size>(), bytes_per_item,
+      fixed_bytes);
+  while (size > 1) {
+    auto allowed = probe(size);
+    if (allowed >= size) {
+      break;
+    }
+    size = power_of_two_group_size(dev, allowed, bytes_per_item, fixed_bytes);
+  }
+  sizes[key] = size;
+  return size;
+}
+
+}  // namespace detail
+
+}  // namespace sycl
+}  // namespace cl
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "SYCL/detail/common.h"
+#include <cstdint>
+#include <memory>
+#include <new>
+
+namespace cl {
+namespace sycl {
+namespace detail {
+
+/**
+ * OpenCL implementations sharing memory with the host
+ * can only use host memory without copying it
+ * if it starts on a page and its size is a multiple of a cache line
+ */
+static const ::size_t host_page_size = 4096;
+static const ::size_t host_cache_line = 64;
+
+/**
+ * Default constructs count objects in page aligned host memory.
+ * If a constructor throws, the objects constructed before are destroyed
+ * and the memory is freed.
+ */
+template <typename T>
+shared_ptr_class<T> allocate_host(::size_t count) {
+  auto size = count * sizeof(T);
+  size = (size + host_cache_line - 1) / host_cache_line * host_cache_line;
+  std::unique_ptr<char[]> raw(new char[size + host_page_size]);
+
+  auto address = reinterpret_cast<std::uintptr_t>(raw.get());  // NOLINT
+  address = (address + host_page_size) & ~(host_page_size - 1);
+  T* data = reinterpret_cast<T*>(address);  // NOLINT
+  ::size_t constructed = 0;
+  try {
+    for (; constructed < count; ++constructed) {
+      new (data + constructed) T;
+    }
+  } catch (...) {
+    while (constructed > 0) {
+      data[--constructed].~T();
+    }
+    throw;
+  }
+
+  auto memory = raw.release();
+  return shared_ptr_class<T>(data, [memory, count](T* ptr) {
+    for (::size_t i = 0; i < count; ++i) {
+      ptr[i].~T();
+    }
+    delete[] memory;
+  });
+}
+
+}  // namespace detail
+}  // namespace sycl
+}  // namespace cl
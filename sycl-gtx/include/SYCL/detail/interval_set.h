@@ -0,0 +1,40 @@
+#pragma once
+
+#include "SYCL/detail/common.h"
+#include <map>
+#include <utility>
+
+namespace cl {
+namespace sycl {
+namespace detail {
+
+/**
+ * Set of disjoint half-open intervals [begin, end),
+ * adjacent intervals are merged together
+ */
+class interval_set {
+ public:
+  using interval = std::pair<::size_t, ::size_t>;
+
+ private:
+  /** Maps the beginning of each interval to its end */
+  std::map<::size_t, ::size_t> intervals;
+
+ public:
+  void add(::size_t begin, ::size_t end);
+  void remove(::size_t begin, ::size_t end);
+
+  /** Parts of the set inside [begin, end), in ascending order */
+  vector_class<interval> intersect(::size_t begin, ::size_t end) const;
+
+  bool empty() const {
+    return intervals.empty();
+  }
+  void clear() {
+    intervals.clear();
+  }
+};
+
+}  // namespace detail
+}  // namespace sycl
+}  // namespace cl
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "SYCL/detail/common.h"
+#include "SYCL/refc.h"
+#include <list>
+#include <unordered_map>
+
+namespace cl {
+namespace sycl {
+
+// Forward declarations
+class context;
+class device;
+
+namespace detail {
+
+/**
+ * In-process cache of linked programs and their kernels,
+ * so that tracing the same kernel again doesn't invoke the OpenCL compiler.
+ *
+ * Entries are keyed per context and device list
+ * on the normalized generated kernel source
+ * and evicted in least-recently-used order.
+ * All functions can be called from multiple threads.
+ */
+class kernel_cache {
+ public:
+  struct entry {
+    refc<cl_program, clRetainProgram, clReleaseProgram> prog;
+    refc<cl_kernel, clRetainKernel, clReleaseKernel> kern;
+  };
+
+  static const ::size_t default_capacity = 64;
+
+ private:
+  using entry_list = std::list<std::pair<string_class, entry>>;
+
+  static entry_list entries;
+  static std::unordered_map<string_class, entry_list::iterator> index;
+  static ::size_t capacity;
+  static mutex_class lock;
+
+  /** Expects the lock to be held */
+  static void trim();
+
+ public:
+  /**
+   * Renumbers names derived from runtime counters
+   * (kernel names, resource names, vector temporaries)
+   * in order of their first appearance,
+   * so that equivalent kernels produce the same string.
+   */
+  static string_class normalize(const string_class& code);
+
+  static string_class get_key(const context& ctx,
+                              const vector_class<device>& devices,
+                              const string_class& options,
+                              const string_class& code);
+
+  /** On a hit also marks the entry as the most recently used one */
+  static bool find(const string_class& key, entry& cached);
+  static void insert(const string_class& key, entry cached);
+
+  /** Maximum number of cached kernels, 0 disables caching */
+  static void set_capacity(::size_t max_entries);
+  static ::size_t get_capacity();
+  static ::size_t size();
+  static void clear();
+};
+
+}  // namespace detail
+
+}  // namespace sycl
+}  // namespace cl
@@ -0,0 +1,192 @@
+#pragma once
+
+// Intermediate representation of traced kernel code
+
+#include "SYCL/detail/common.h"
+#include <initializer_list>
+#include <memory>
+
+namespace cl {
+namespace sycl {
+namespace detail {
+namespace ir {
+
+/**
+ * Part of an expression, allocated in the arena of the kernel being traced.
+ * Nodes are immutable, so they can be shared by any number of expressions.
+ */
+struct node {
+  enum class kind_t : unsigned char {
+    /** Verbatim code, e.g. a name or a literal */
+    text,
+    /** Left followed by right, for code assembled piece by piece */
+    concat,
+    /** (left op right) */
+    binary,
+    /** (op left) */
+    prefix,
+    /** (left op) */
+    postfix,
+    /** str(arguments), with the arguments chained through argument nodes */
+    call,
+    /** left, followed by the next argument on the right */
+    argument,
+    /** left[right] */
+    subscript,
+    /** left followed by the field named by the right text, e.g. .s01 */
+    member,
+  };
+
+  /** Properties of the node or of anything below it */
+  enum flag_t : unsigned char {
+    /** Changes a value, e.g. through ++, so it cannot be moved or removed */
+    side_effects = 1,
+    /** Reads memory, e.g. an element of a buffer */
+    memory = 2,
+  };
+
+  kind_t kind;
+  unsigned char flags;
+  /** Length of the text, only for text nodes */
+  unsigned length;
+  /** Code of a text node, the operator or the called function */
+  const char* str;
+  const node* left;
+  const node* right;
+};
+
+/** A single line of kernel code */
+struct statement {
+  enum class kind_t : unsigned char {
+    /** Code followed by a semicolon, e.g. an expression or a return */
+    plain,
+    /** Head of a control structure, e.g. if(...) */
+    control,
+    open_block,
+    close_block,
+    /** target op value, with op being = or a compound assignment */
+    assign,
+    /** type target, optionally followed by = value */
+    declare,
+  };
+
+  kind_t kind;
+  /** Nesting level, the body of the kernel is on level 1 */
+  unsigned depth;
+  /** Assignment operator, or the keyword of a control statement, e.g. for */
+  const char* op;
+  const node* type;
+  const node* target;
+  /** Also holds the code of plain and control statements */
+  const node* value;
+};
+
+/**
+ * Bump allocator holding the IR of a single kernel.
+ * Everything is released at once, together with the kernel source.
+ */
+class arena {
+ private:
+  static const ::size_t block_size = 32 * 1024;
+
+  vector_class<std::unique_ptr<char[]>> blocks;
+  char* next = nullptr;
+  ::size_t available = 0;
+  ::size_t used = 0;
+
+  void* allocate(::size_t size);
+
+ public:
+  /** Arena of the kernel being traced by this thread, if any */
+  SYCL_THREAD_LOCAL static arena* current;
+
+  arena() = default;
+  arena(const arena&) = delete;
+  arena& operator=(const arena&) = delete;
+
+  /** Copies the code into the arena */
+  const node* text(const char* code, ::size_t length);
+  /** Copies the code of two text nodes into a single one */
+  const node* join(const node* left, const node* right);
+  /** The code has to outlive the arena, e.g. a string literal */
+  const node* literal(const char* code, ::size_t length);
+  /** The flags of the operands are added to the given ones */
+  const node* make(node::kind_t kind, const char* op, const node* left,
+                   const node* right = nullptr, unsigned char flags = 0);
+
+  /** Bytes taken by the nodes */
+  ::size_t size() const {
+    return used;
+  }
+};
+
+/**
+ * Handle to a piece of kernel code, cheap to copy and to concatenate.
+ * Outside of kernel tracing there is no arena,
+ * so the code is kept in a string until it is used inside a kernel.
+ */
+class expr {
+ private:
+  const node* n = nullptr;
+  string_class host;
+
+ public:
+  expr() = default;
+  expr(const node* n) : n(n) {}
+  expr(const string_class& code);
+  expr(const char* code);
+
+  /** Moves the code into the arena of the current kernel if needed */
+  const node* get() const;
+  bool empty() const;
+  /** Generates the code */
+  string_class str() const;
+  operator string_class() const {
+    return str();
+  }
+
+  static expr binary(const char* op, const expr& lhs, const expr& rhs);
+  static expr prefix(const char* op, const expr& operand);
+  static expr postfix(const char* op, const expr& operand);
+  static expr character(char c);
+  /** The name of the function has to outlive the arena */
+  static expr call(const char* function, std::initializer_list<expr> arguments,
+                   unsigned char flags = 0);
+  static expr subscript(const expr& array, const expr& index);
+  static expr member(const expr& object, const char* field);
+
+  friend expr operator+(const expr& lhs, const expr& rhs);
+  friend expr operator+(const expr& lhs, const char* rhs) {
+    return lhs + expr(rhs);
+  }
+  friend expr operator+(const char* lhs, const expr& rhs) {
+    return expr(lhs) + rhs;
+  }
+  friend expr operator+(const expr& lhs, const string_class& rhs) {
+    return lhs + expr(rhs);
+  }
+  friend expr operator+(const string_class& lhs, const expr& rhs) {
+    return expr(lhs) + rhs;
+  }
+  friend expr operator+(const expr& lhs, char rhs) {
+    return lhs + character(rhs);
+  }
+  friend expr operator+(char lhs, const expr& rhs) {
+    return character(lhs) + rhs;
+  }
+  template <class T>
+  expr& operator+=(const T& rhs) {
+    *this = *this + rhs;
+    return *this;
+  }
+};
+
+/** Appends the code of the node */
+void write(const node* n, string_class& out);
+/** Appends the lines, each one ending with a new line character */
+void write(const vector_class<statement>& statements, string_class& out);
+
+}  // namespace ir
+}  // namespace detail
+}  // namespace sycl
+}  // namespace cl
@@ -1,6 +1,9 @@
 #pragma once
 
+#include "SYCL/detail/common.h"
+#include <atomic>
 #include <cstddef>
+#include <typeinfo>
 
 namespace cl {
 namespace sycl {
@@ -9,32 +12,52 @@ namespace detail {
 
 class kernel_name {
  private:
-  static ::size_t current_count;
+  static std::atomic<::size_t> current_count;
+
+  /**
+   * Readable name of the type a pointer type points to,
+   * removes the compiler mangling where there is one
+   */
+  static string_class demangle_pointee(const char* name);
 
   template <class T>
   struct namer {
-    static ::size_t id;
-    static bool is_set;
-    static void set() {
-      if (!is_set) {
-        id = ++current_count;
-        is_set = true;
+    /** Zero until the name is first requested */
+    static std::atomic<::size_t> id;
+    static ::size_t get() {
+      auto current = id.load();
+      if (current == 0) {
+        // Concurrent callers agree on the first stored value
+        ::size_t expected = 0;
+        current = ++current_count;
+        if (!id.compare_exchange_strong(expected, current)) {
+          current = expected;
+        }
       }
+      return current;
     }
   };
 
  public:
   template <class T>
   static ::size_t get() {
-    namer<T>::set();
-    return namer<T>::id;
+    return namer<T>::get();
+  }
+
+  /**
+   * Readable name of the type, computed once per type.
+   * Kernel names are usually only declared,
+   * so the name is taken from a pointer to the type.
+   */
+  template <class T>
+  static const string_class& get_type_name() {
+    static const string_class name = demangle_pointee(typeid(T*).name());
+    return name;
   }
 };
 
 template <class T>
-::size_t kernel_name::namer<T>::id = 0;
-template <class T>
-bool kernel_name::namer<T>::is_set = false;
+std::atomic<::size_t> kernel_name::namer<T>::id(0);
 
 }  // namespace detail
 
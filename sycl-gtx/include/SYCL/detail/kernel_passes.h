@@ -0,0 +1,27 @@
+#pragma once
+
+// Optimization passes over the IR of traced kernels
+
+#include "SYCL/detail/common.h"
+#include "SYCL/detail/kernel_ir.h"
+#include <map>
+
+namespace cl {
+namespace sycl {
+namespace detail {
+namespace ir {
+
+/**
+ * Runs the passes selected by the bits of kernel_optimizer,
+ * rewriting the statements in place with nodes allocated in the arena.
+ * Names used but not declared by the statements map to their OpenCL type,
+ * buffers to a pointer type, e.g. float* for _sycl_buf1.
+ */
+void optimize(vector_class<statement>& statements, arena& nodes,
+              const std::map<string_class, string_class>& names,
+              unsigned passes);
+
+}  // namespace ir
+}  // namespace detail
+}  // namespace sycl
+}  // namespace cl
@@ -31,6 +31,12 @@ struct identifier_code {
       case type_t::range_local:
         name = "get_local_size";
         break;
+      case type_t::id_group:
+        name = "get_group_id";
+        break;
+      case type_t::range_group:
+        name = "get_num_groups";
+        break;
       default:
         break;
     }
@@ -42,19 +48,19 @@ struct identifier_code {
 
     for (int i = 0; i < dimensions; ++i) {
       auto id_s = get_string<int>::get(i);
-      source::add(string_class("const int ") + name + id_s + " = " +
-                  function_name + "(" + id_s + ")");
+      source::declare("const int", name + id_s,
+                      function_name + "(" + id_s + ")");
     }
 
     if (is_id) {
       string_replace_one(function_name, "id", "size");
 
       if (dimensions == 1) {
-        source::add(string_class("const int ") + name + " = " + name + "0");
+        source::declare("const int", name, name + "0");
       }
       if (dimensions == 2) {
-        source::add(string_class("const int ") + name + " = " + name + "1 * " +
-                    function_name + "(0) + " + name + "0");
+        source::declare("const int", name,
+                        name + "1 * " + function_name + "(0) + " + name + "0");
       }
 
       // TODO(progtx): 3d
@@ -72,6 +78,11 @@ struct generate_id_refs {
     identifier_code<dimensions, true>::generate(
         point<dimensions>::type_t::id_local);
   }
+  /** There is no size function to linearize the group ID with */
+  static void group() {
+    identifier_code<dimensions, false>::generate(
+        point<dimensions>::type_t::id_group);
+  }
 };
 
 template <int dimensions>
@@ -84,10 +95,18 @@ struct generate_range_refs {
     identifier_code<dimensions, true>::generate(
         point<dimensions>::type_t::range_local);
   }
+  static void group() {
+    identifier_code<dimensions, false>::generate(
+        point<dimensions>::type_t::range_group);
+  }
 };
 
 namespace kernel_ns {
 
+/**
+ * Traces the kernel functor by invoking it in place,
+ * so that values captured inside it can be recognized by their address
+ */
 template <class Input>
 struct constructor;
 
@@ -96,9 +115,10 @@ struct constructor;
  */
 template <>
 struct constructor<void> {
-  static source get(function_class<void(void)> kern) {
+  template <class KernelType>
+  static source get(KernelType& kern) {
     source src;
-    source::enter(src);
+    source::enter(src, kern);
 
     kern();
 
@@ -111,9 +131,10 @@ struct constructor<void> {
  */
 template <int dimensions>
 struct constructor<id<dimensions>> {
-  static source get(function_class<void(id<dimensions>)> kern) {
+  template <class KernelType>
+  static source get(KernelType& kern) {
     source src;
-    source::enter(src);
+    source::enter(src, kern);
 
     // TODO(progtx): num_work_items, work_item_offset
     generate_id_refs<dimensions>::global();
@@ -128,9 +149,10 @@ struct constructor<id<dimensions>> {
  */
 template <int dimensions>
 struct constructor<item<dimensions>> {
-  static source get(function_class<void(item<dimensions>)> kern) {
+  template <class KernelType>
+  static source get(KernelType& kern) {
     source src;
-    source::enter(src);
+    source::enter(src, kern);
 
     generate_id_refs<dimensions>::global();
     auto index = get_special_id<dimensions>::global();
@@ -148,9 +170,10 @@ struct constructor<item<dimensions>> {
  */
 template <int dimensions>
 struct constructor<nd_item<dimensions>> {
-  static source get(function_class<void(nd_item<dimensions>)> kern) {
+  template <class KernelType>
+  static source get(KernelType& kern) {
     source src;
-    source::enter(src);
+    source::enter(src, kern);
 
     generate_id_refs<dimensions>::global();
     generate_id_refs<dimensions>::local();
@@ -178,6 +201,57 @@ struct constructor<nd_item<dimensions>> {
   }
 };
 
+/**
+ * Parallel For hierarchical invoke,
+ * traced once for the group and once for each parallel_for_work_item
+ */
+template <int dimensions>
+struct constructor<group<dimensions>> {
+  template <class KernelType>
+  static source get(KernelType& kern) {
+    source src;
+    source::enter(src, kern);
+
+    generate_id_refs<dimensions>::global();
+    generate_id_refs<dimensions>::local();
+    generate_id_refs<dimensions>::group();
+    generate_range_refs<dimensions>::global();
+    generate_range_refs<dimensions>::local();
+    generate_range_refs<dimensions>::group();
+
+    nd_range<dimensions> execution_range(
+        get_special_range<dimensions>::global(),
+        get_special_range<dimensions>::local());
+    group<dimensions> g(get_special_id<dimensions>::group(),
+                        get_special_range<dimensions>::group(),
+                        execution_range);
+
+    source::enter_work_group();
+    kern(g);
+    source::exit_work_group(dimensions);
+
+    return source::exit(src);
+  }
+
+  template <class WorkItemFunctionType>
+  static void work_item(const group<dimensions>& g,
+                        WorkItemFunctionType& kern) {
+    auto section = source::enter_work_item();
+    source::add_curlies();
+
+    item<dimensions> global_item(get_special_id<dimensions>::global(),
+                                 g.get_global_range());
+    // The group ID is stored as the offset of the local item
+    item<dimensions> local_item(get_special_id<dimensions>::local(),
+                                g.get_local_range(), g.get());
+    nd_item<dimensions> it(std::move(global_item), std::move(local_item));
+    kern(it);
+
+    source::remove_curlies();
+    source::exit_work_item(section);
+  }
+};
+
 }  // namespace kernel_ns
 }  // namespace detail
 
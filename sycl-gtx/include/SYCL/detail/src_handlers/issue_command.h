@@ -15,6 +15,9 @@ namespace detail {
 
 class issue_command {
  private:
+  static const ::size_t num_enqueue_locks = 16;
+  static mutex_class enqueue_locks[num_enqueue_locks];
+
   static void compile_command(queue* q,
                               const vector_class<cl_event>& wait_events,
                               kernel_ns::source src,
@@ -23,12 +26,12 @@ class issue_command {
 
   static void enqueue_task_command(queue* q,
                                    const vector_class<cl_event>& wait_events,
-                                   shared_ptr_class<kernel> kern, event* evnt);
+                                   event* evnt, shared_ptr_class<kernel> kern);
 
   template <int dimensions>
   static void enqueue_range_command(queue* q,
                                     const vector_class<cl_event>& wait_events,
-                                    shared_ptr_class<kernel> kern, event* evnt,
+                                    event* evnt, shared_ptr_class<kernel> kern,
                                     range<dimensions> num_work_items,
                                     id<dimensions> offset) {
     prepare_kernel(kern);
@@ -37,32 +40,45 @@ class issue_command {
 
   template <int dimensions>
   static void enqueue_nd_range_command(
-      queue* q, const vector_class<cl_event>& wait_events,
-      shared_ptr_class<kernel> kern, event* evnt,
-      nd_range<dimensions> execution_range) {
+      queue* q, const vector_class<cl_event>& wait_events, event* evnt,
+      shared_ptr_class<kernel> kern, nd_range<dimensions> execution_range) {
     prepare_kernel(kern);
     kern->enqueue_nd_range(q, wait_events, evnt, execution_range);
   }
 
  public:
   static void write_buffers_to_device(shared_ptr_class<kernel> kern);
-  static void read_buffers_from_device(shared_ptr_class<kernel> kern);
+  static void invalidate_host_buffers(shared_ptr_class<kernel> kern);
+
+  static void enqueue_task(shared_ptr_class<kernel> kern);
+
+  static void set_indexed_args(shared_ptr_class<kernel> kern,
+                               std::map<int, vector_class<char>> args);
+
+  /** Captured scalars and buffers the kernel is currently enqueued with */
+  static kernel_args get_args(shared_ptr_class<kernel> kern);
+  static void set_args(shared_ptr_class<kernel> kern, const kernel_args& args);
 
-  static void enqueue_task(shared_ptr_class<kernel> kern, event* evnt);
+  /**
+   * Guards setting the arguments of a kernel until it is enqueued.
+   * Kernels from the kernel cache share their OpenCL kernel object,
+   * so the lock is chosen by that object.
+   */
+  static mutex_class& get_enqueue_lock(const shared_ptr_class<kernel>& kern);
 
   template <int dimensions>
-  static void enqueue_range(shared_ptr_class<kernel> kern, event* evnt,
+  static void enqueue_range(shared_ptr_class<kernel> kern,
                             range<dimensions> num_work_items,
                             id<dimensions> offset) {
     command::group_detail::add_kernel_enqueue_range(
-        enqueue_range_command, __func__, kern, evnt, num_work_items, offset);
+        enqueue_range_command, __func__, kern, num_work_items, offset);
   }
 
   template <int dimensions>
-  static void enqueue_nd_range(shared_ptr_class<kernel> kern, event* evnt,
+  static void enqueue_nd_range(shared_ptr_class<kernel> kern,
                                nd_range<dimensions> execution_range) {
     command::group_detail::add_kernel_enqueue_nd_range(
-        enqueue_nd_range_command, __func__, kern, evnt, execution_range);
+        enqueue_nd_range_command, __func__, kern, execution_range);
   }
 };
 
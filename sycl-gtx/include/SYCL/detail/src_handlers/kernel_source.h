@@ -5,7 +5,9 @@
 #include "SYCL/detail/common.h"
 #include "SYCL/detail/counter.h"
 #include "SYCL/detail/debug.h"
+#include "SYCL/detail/kernel_ir.h"
 #include <map>
+#include <set>
 
 namespace cl {
 namespace sycl {
@@ -33,18 +35,58 @@ class source : protected counter<source> {
     string_class resource_name;
     string_class type_name;
     ::size_t size;
+    /** Only this part of the buffer is transferred */
+    buffer_region region;
+  };
+
+  /** Scalar captured by the kernel functor, passed as a kernel argument */
+  struct arg_info {
+    /** Location inside the kernel functor */
+    ::size_t offset;
+    string_class name;
+    string_class type_name;
+    vector_class<char> value;
   };
 
   static const string_class resource_name_root;
+  static const string_class argument_name_root;
   SYCL_THREAD_LOCAL static int num_resources;
 
-  string_class tab_offset;
+  /** Nesting level of the next statement */
+  unsigned depth = 1;
 
   string_class kernel_name;
-  vector_class<string_class> lines;
+  /** Shared by the copies of the source, owns the nodes of the statements */
+  shared_ptr_class<ir::arena> nodes;
+  vector_class<ir::statement> statements;
+  /** Generated from the statements the first time it is needed */
+  string_class code;
+  /** Generated after running the enabled kernel_optimizer passes */
+  string_class optimized_code;
   std::map<void*, buf_info> resources;
-
-  // TODO(progtx): Multithreading support
+  /** Follow the resources in the kernel signature, in order of first use */
+  vector_class<arg_info> captured_args;
+  /** Set through handler::set_arg, keyed by argument index */
+  std::map<int, vector_class<char>> indexed_args;
+  /** OpenCL extensions used by the kernel, e.g. for 64-bit atomics */
+  std::set<string_class> extensions;
+
+  /** Memory occupied by the kernel functor while it is being traced */
+  const char* functor_begin = nullptr;
+  const char* functor_end = nullptr;
+
+  /** Set while tracing parallel_for_work_group outside of the work items */
+  bool work_group_scope = false;
+  /** First statement in the scope of the work-group */
+  ::size_t work_group_begin = 0;
+  /** Statements traced by parallel_for_work_item, from begin to end */
+  vector_class<std::pair<::size_t, ::size_t>> work_item_sections;
+
+  /**
+   * Kernel currently being traced by this thread.
+   * Each kernel has to be traced on a single thread,
+   * but different threads can trace kernels at the same time.
+   */
   SYCL_THREAD_LOCAL static source* scope;
 
   template <class Input>
@@ -52,19 +94,48 @@ class source : protected counter<source> {
   friend class ::cl::sycl::detail::issue_command;
 
   string_class generate_accessor_list() const;
-
-  static void enter(source& src);
+  /** Writes the kernel with the current statements */
+  string_class generate_code() const;
+
+  static void add_statement(ir::statement::kind_t kind,
+                            const char* op = nullptr,
+                            const ir::expr& type = ir::expr(),
+                            const ir::expr& target = ir::expr(),
+                            const ir::expr& value = ir::expr());
+
+  static void enter(source& src, const void* functor, ::size_t functor_size);
+  template <class KernelType>
+  static void enter(source& src, const KernelType& functor) {
+    enter(src, &functor, sizeof(KernelType));
+  }
   static source exit(source& src);
 
+  static void enter_work_group();
+  /**
+   * Runs the code traced in the scope of the work-group once per group
+   * and shares its values with the work items
+   */
+  static void exit_work_group(int dimensions);
+  /** Returns false inside of another parallel_for_work_item */
+  static bool enter_work_item();
+  static void exit_work_item(bool section);
+
  public:
   source()
-      : tab_offset("\t"),
-        kernel_name(string_class("_sycl_kernel_") +
+      : kernel_name(string_class("_sycl_kernel_") +
                     get_string<counter_t>::get(get_count_id())) {}
 
   static bool in_scope();
 
-  string_class get_code() const;
+  /** Code of the kernel as traced, which identifies it in the kernel caches */
+  string_class get_code();
+  /**
+   * Code to compile after running the passes given by the bits of
+   * kernel_optimizer, the IR of the kernel is released once it is generated
+   */
+  string_class get_optimized_code(unsigned passes);
+  /** Once the kernel is found in a cache the IR is no longer needed */
+  void release_ir();
   string_class get_kernel_name() const;
 
   void init_kernel(program& p, shared_ptr_class<kernel> kern);
@@ -88,26 +159,66 @@ class source : protected counter<source> {
       scope->resources[buf] = {{buf, mode, target},
                                resource_name,
                                type_string<DataType>::get() + '*',
-                               acc.argument_size()};
+                               acc.argument_size(),
+                               acc.access_region()};
     } else {
       resource_name = it->second.resource_name;
+      auto region = acc.access_region();
+      auto& known = it->second.region;
+      if (region.origin != known.origin || region.size() != known.size()) {
+        // Accessors with different ranges share the kernel argument
+        known = buf->region;
+      }
     }
 
     return resource_name;
   }
 
+  /**
+   * If the scalar is stored inside the kernel functor,
+   * registers it as a kernel argument and returns the argument name.
+   * Otherwise returns an empty string and the value has to be used as a literal.
+   */
+  static string_class register_argument(const void* address, ::size_t size,
+                                        const char* type_name);
+
+  /** The extension is enabled by a pragma at the top of the kernel */
+  static void enable_extension(const char* name);
+
+  /** Without auto_end the line is the head of a control structure */
   template <bool auto_end = true>
-  static void add(string_class line) {
-    scope->lines.push_back(scope->tab_offset + line + (auto_end ? ';' : ' '));
+  static void add(const ir::expr& line) {
+    using kind_t = ir::statement::kind_t;
+    add_statement(auto_end ? kind_t::plain : kind_t::control, nullptr,
+                  ir::expr(), ir::expr(), line);
+  }
+
+  /** Head of a control structure, the keyword has to be a string literal */
+  static void control(const char* keyword, const ir::expr& head) {
+    add_statement(ir::statement::kind_t::control, keyword, ir::expr(),
+                  ir::expr(), head);
+  }
+
+  static void assign(const ir::expr& target, const char* op,
+                     const ir::expr& value) {
+    add_statement(ir::statement::kind_t::assign, op, ir::expr(), target,
+                  value);
+  }
+
+  /** The initial value is optional */
+  static void declare(const ir::expr& type, const ir::expr& target,
+                      const ir::expr& value = ir::expr()) {
+    add_statement(ir::statement::kind_t::declare, nullptr, type, target,
+                  value);
   }
 
   static void add_curlies() {
-    add<false>("{");
-    scope->tab_offset.push_back('\t');
+    add_statement(ir::statement::kind_t::open_block);
+    ++scope->depth;
   }
   static void remove_curlies() {
-    scope->tab_offset.pop_back();
-    add<false>("}");
+    --scope->depth;
+    add_statement(ir::statement::kind_t::close_block);
   }
 
   static string_class get_name(access::target target);
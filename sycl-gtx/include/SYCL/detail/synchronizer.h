@@ -1,36 +1,60 @@
 #pragma once
 
+#include "SYCL/access.h"
+#include "SYCL/buffer_base.h"
 #include "SYCL/detail/common.h"
 #include <map>
 #include <set>
+#include <thread>
 
 namespace cl {
 namespace sycl {
-
-// Forward declaration
-class queue;
-
 namespace detail {
 
 // Forward declarations
 class accessor_base;
 class buffer_base;
 
+/**
+ * Keeps track of buffers held by host accessors.
+ *
+ * The registry is split into shards by buffer address,
+ * so threads working on different buffers rarely contend for a lock.
+ */
 class synchronizer {
  private:
-  static std::set<queue*> queues;
-  static std::map<accessor_base*, buffer_base*> host_accessors;
+  static const ::size_t num_shards = 16;
+
+  struct host_access {
+    /** Region mapped by the accessor, if any */
+    void* mapped;
+    std::thread::id owner;
+  };
 
-  static void wait_on_queues(buffer_base* buf);
-  static void flush_queues(buffer_base* buf);
+  struct shard {
+    mutex_class lock;
+    /** Keyed by the identity of the root buffer */
+    std::map<const void*, std::map<accessor_base*, host_access>>
+        host_accessors;
+  };
+  static shard shards[num_shards];
+
+  static shard& get_shard(const void* identity);
 
  public:
-  static void add(queue* q);
-  static void remove(queue* q);
-  static void add(accessor_base* acc, buffer_base* buf);
+  /**
+   * Also makes sure the accessed region of the host data is up to date,
+   * mapping it if the device shares memory with the host
+   */
+  static void add(accessor_base* acc, buffer_base* buf, access::mode mode,
+                  const buffer_region& accessed);
   static void remove(accessor_base* acc, buffer_base* buf);
 
   static bool can_flush(const std::set<detail::buffer_base*>& buffers_in_use);
+
+  /** Whether the calling thread holds a host accessor to any of the buffers */
+  static bool held_by_this_thread(
+      const std::set<detail::buffer_base*>& buffers_in_use);
 };
 
 }  // namespace detail
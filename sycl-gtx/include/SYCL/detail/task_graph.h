@@ -0,0 +1,173 @@
+#pragma once
+
+#include "SYCL/command_group.h"
+#include "SYCL/detail/common.h"
+#include "SYCL/event.h"
+#include "SYCL/handler_event.h"
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <set>
+
+namespace cl {
+namespace sycl {
+
+// Forward declarations
+class queue;
+
+namespace detail {
+
+// Forward declaration
+class buffer_base;
+
+/**
+ * Dependency graph of all submitted command groups.
+ *
+ * Each command group is a node with RAW, WAR and WAW edges
+ * to the earlier nodes accessing the same buffers,
+ * or overlapping parts of them through sub-buffers.
+ * A node is dispatched to its queue as soon as all its predecessors are,
+ * waiting on their completion events instead of serializing on the host.
+ *
+ * The buffer states are split into shards by root buffer,
+ * like the synchronizer does with host accessors.
+ * A node only locks the shards of its buffers, in ascending order,
+ * while adding its edges and while being dispatched,
+ * so threads submitting to different buffers rarely contend for a lock.
+ * A node that isn't ready when it is submitted
+ * is dispatched by the thread that dispatches its last predecessor,
+ * or by the one releasing the host accessor blocking it.
+ */
+class task_graph {
+ public:
+  struct node {
+    command_group group;
+    /** Nodes that must be dispatched first, cleared after dispatching */
+    vector_class<shared_ptr_class<node>> predecessors;
+    /** Nodes waiting for this one, cleared after dispatching */
+    vector_class<shared_ptr_class<node>> successors;
+    /** Shards of the buffers of the group, in ascending order */
+    vector_class<::size_t> shards;
+    /** Guards the successors and the results of dispatching */
+    mutex_class lock;
+    /** Predecessors not dispatched yet, plus one while being submitted */
+    std::atomic<int> waiting;
+    /** Taken by the single thread that dispatches or drops the node */
+    std::atomic<bool> claimed;
+    /** Whether the node is kept in the deferred nodes of its queue */
+    std::atomic<bool> deferred;
+    /** Completes together with all commands, known after dispatching */
+    event completion;
+    std::atomic<bool> dispatched;
+
+    template <typename T>
+    node(queue& q, T cgf)
+        : group(q, cgf),
+          waiting(1),
+          claimed(false),
+          deferred(false),
+          dispatched(false) {}
+    node(const command_group& recorded)
+        : group(recorded),
+          waiting(1),
+          claimed(false),
+          deferred(false),
+          dispatched(false) {}
+  };
+  using node_ptr = shared_ptr_class<node>;
+
+ private:
+  struct buffer_state {
+    node_ptr last_write;
+    /** Nodes reading the buffer since the last write */
+    vector_class<node_ptr> reads;
+  };
+
+  static const ::size_t num_shards = 16;
+
+  struct shard {
+    mutex_class lock;
+    /** Keyed by buffer identity, which copies of a root buffer share */
+    std::map<const void*, buffer_state> buffers;
+    /** Sub-buffers of each root buffer */
+    std::map<const void*, std::set<buffer_base*>> sub_buffers;
+  };
+  static shard shards[num_shards];
+
+  /** Nodes not dispatched right when they were submitted, by queue */
+  static std::map<queue*, std::set<node_ptr>> deferred;
+  /** Ready nodes waiting for a host accessor to be released */
+  static std::set<node_ptr> blocked;
+  /** Guards the deferred and blocked nodes */
+  static mutex_class deferred_lock;
+  /** Notified whenever deferred nodes have been dispatched */
+  static std::condition_variable progress;
+
+  /** A root buffer shares its shard with all of its sub-buffers */
+  static ::size_t get_shard(buffer_base* buf);
+  static vector_class<std::unique_lock<mutex_class>> lock_shards(
+      const vector_class<::size_t>& indices);
+
+  // These expect the shard of the buffer to be held
+  /** The buffer itself and the buffers sharing memory with it */
+  static vector_class<const void*> get_overlapping(buffer_base* buf);
+  static void add_edges(const node_ptr& n);
+  static vector_class<event> get_pending_events(buffer_base* buf);
+
+  static void defer(const node_ptr& n);
+  static void block(const node_ptr& n);
+  static void dispatch(node& n);
+  /** Marks the node as dispatched and returns its successors */
+  static vector_class<node_ptr> finish(node& n);
+  /** Dispatches the node and then every successor it makes ready */
+  static void run(node_ptr n);
+  /**
+   * Whether the nodes wait for a host accessor held by the calling thread,
+   * directly or through their predecessors
+   */
+  static bool blocked_by_this_thread(const vector_class<node_ptr>& nodes);
+
+  static vector_class<cl_event> get_events(const vector_class<node_ptr>& nodes);
+  static void wait(vector_class<event> events);
+  static handler_event submit(node_ptr n);
+
+ public:
+  template <typename T>
+  static handler_event submit(queue& q, T cgf) {
+    return submit(node_ptr(new node(q, cgf)));
+  }
+
+  /** Submits a copy of a command group recorded earlier */
+  static handler_event submit(const command_group& recorded);
+
+  /** Dispatches the nodes that were waiting for a host accessor */
+  static void dispatch();
+
+  /** Blocks until all dispatched nodes using the buffer have completed */
+  static void wait(buffer_base* buf);
+
+  /**
+   * Waits on the buffer and forgets about it,
+   * unless other copies of the buffer are still around
+   */
+  static void remove(buffer_base* buf);
+
+  /** Keeps track of a sub-buffer for its dependencies */
+  static void add_sub_buffer(buffer_base* sub);
+
+  /** Updates deferred nodes after a queue was moved */
+  static void replace_queue(queue* from, queue* to);
+
+  /**
+   * Waits until the nodes deferred on a queue that is being destroyed
+   * have been dispatched.
+   * Nodes waiting for a host accessor of the calling thread can't be,
+   * they are dropped with an error.
+   */
+  static void remove_queue(queue* q);
+};
+
+}  // namespace detail
+
+}  // namespace sycl
+}  // namespace cl
@@ -0,0 +1,32 @@
+#pragma once
+
+// Lowering of kernels invoked through parallel_for_work_group
+
+#include "SYCL/detail/common.h"
+#include "SYCL/detail/kernel_ir.h"
+#include <utility>
+
+namespace cl {
+namespace sycl {
+namespace detail {
+namespace ir {
+
+/**
+ * Statements from begin on are in the scope of the work-group,
+ * apart from the sections traced by parallel_for_work_item.
+ * The work-group scope is turned into code run by every work item:
+ * values only held in private variables are computed by each work item,
+ * while statements writing memory or variables the work items share
+ * are run by the leader, the work item for which the condition holds.
+ * Shared variables are declared __local
+ * and barriers separate the leader from the other work items.
+ */
+void distribute_work_group(
+    vector_class<statement>& statements, arena& nodes, ::size_t begin,
+    const vector_class<std::pair<::size_t, ::size_t>>& work_item_sections,
+    const node* leader);
+
+}  // namespace ir
+}  // namespace detail
+}  // namespace sycl
+}  // namespace cl
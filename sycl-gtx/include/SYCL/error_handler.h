@@ -31,7 +31,7 @@ static const async_handler default_async_handler =
       debug() << "Number of asynchronous errors during queue execution:"
               << list.size();
       for (auto& e : list) {
-        debug("SYCL_ERROR::", e.what());
+        debug::error(e.what());
       }
     };
 
@@ -48,7 +48,7 @@ struct thrower {
         new exception((*error::codes.find(error_code)).second, thrower));
   }
   static void report(exception& error) {
-    debug displayError("SYCL_ERROR::", error.what());
+    debug::error(error.what());
     throw error;
   }
   static void report_async(context* thrower, exception_list& list);
@@ -9,11 +9,15 @@
 #include "SYCL/handler_event.h"
 #include "SYCL/program.h"
 #include "SYCL/ranges.h"
+#include <map>
+#include <type_traits>
 
 namespace cl {
 namespace sycl {
 
 // Forward declarations
+template <typename, int>
+struct buffer;
 class kernel;
 class queue;
 
@@ -30,39 +34,86 @@ class handler {
 
   queue* q;
   handler_event events;
+  /** Arguments for OpenCL kernels invoked through interoperability */
+  std::map<int, vector_class<char>> args;
 
   // TODO(progtx): Implementation defined constructor
   handler(queue* q) : q(q) {}
 
   static context get_context(queue* q);
+  /** Largest work-group the kernel can be run with on the device of q */
+  static ::size_t get_work_group_size(queue* q, cl_kernel kern);
 
-  template <class KernelType>
+  template <int dimensions>
+  static range<dimensions> work_group_range(::size_t max_size) {
+    auto volume = [](::size_t side) {
+      ::size_t v = 1;
+      for (int i = 0; i < dimensions; ++i) {
+        v *= side;
+      }
+      return v;
+    };
+    ::size_t side = (dimensions == 1) ? max_size : 1;
+    while (volume(side * 2) <= max_size) {
+      side *= 2;
+    }
+    auto size = detail::empty_range<dimensions>();
+    for (int i = 0; i < dimensions; ++i) {
+      static_cast<::size_t&>(size[i]) = side;
+    }
+    return size;
+  }
+
+  template <int dimensions>
+  static nd_range<dimensions> work_group_nd_range(
+      range<dimensions> numWorkGroups, range<dimensions> workGroupSize) {
+    range<dimensions> global = workGroupSize;
+    for (int i = 0; i < dimensions; ++i) {
+      static_cast<::size_t&>(global[i]) *= numWorkGroups.get(i);
+    }
+    return nd_range<dimensions>(global, workGroupSize);
+  }
+
+  template <typename KernelName, class KernelType>
   shared_ptr_class<kernel> build(KernelType kernFunctor) {
     detail::command::group_detail::check_scope();
+    detail::runtime_recorder::scope timing;
     program prog(get_context(q));
     prog.build(kernFunctor, "");
 
     // We know here the program only contains one kernel
-    return prog.kernels.begin()->second;
+    auto kern = prog.kernels.begin()->second;
+    // Generated OpenCL names differ between traces,
+    // the statistics are kept under the name the user gave the kernel
+    auto& name = detail::kernel_name::get_type_name<KernelName>();
+    kern->name = name;
+    timing.commit(q->recorder.get(), name);
+    detail::command::group_detail::set_kernel_name(name);
+    return kern;
   }
 
   using issue = detail::issue_command;
 
   template <class... Args>
   void issue_enqueue(shared_ptr_class<kernel> kern,
-                     void (*issue_enqueue_f)(shared_ptr_class<kernel>, event*,
-                                             Args...),
+                     void (*issue_enqueue_f)(shared_ptr_class<kernel>, Args...),
                      Args... params) {
     issue::write_buffers_to_device(kern);
-    issue_enqueue_f(kern, &events.kernelEvent, params...);
-    issue::read_buffers_from_device(kern);
+    issue_enqueue_f(kern, params...);
+    issue::invalidate_host_buffers(kern);
+  }
+
+  shared_ptr_class<kernel> interop(kernel&& syclKernel) {
+    auto kern = shared_ptr_class<kernel>(new kernel(std::move(syclKernel)));
+    issue::set_indexed_args(kern, args);
+    return kern;
   }
 
   template <typename KernelName, class KernelType, int dimensions>
   void parallel_for_range(range<dimensions> numWorkItems,
                           id<dimensions> workItemOffset,
                           KernelType kernFunctor) {
-    auto kern = build(kernFunctor);
+    auto kern = build<KernelName>(kernFunctor);
     issue_enqueue(kern, &issue::enqueue_range, numWorkItems, workItemOffset);
   }
   // TODO(progtx): Why is the offset needed? It's already contained in the
@@ -71,7 +122,7 @@ class handler {
   void parallel_for_nd_range(nd_range<dimensions> executionRange,
                              id<dimensions> workItemOffset,
                              KernelType kernFunctor) {
-    auto kern = build(kernFunctor);
+    auto kern = build<KernelName>(kernFunctor);
     issue_enqueue(kern, &issue::enqueue_nd_range, executionRange);
   }
 
@@ -82,13 +133,29 @@ class handler {
   void set_arg(int arg_index,
                accessor<DataType, dimensions, mode, target>& acc_obj);
 
+  /**
+   * Sets a scalar argument of the OpenCL kernels
+   * invoked afterwards in this command group
+   */
   template <typename T>
-  void set_arg(int arg_index, T scalar_value);
+  void set_arg(int arg_index, T scalar_value) {
+    auto begin = reinterpret_cast<const char*>(&scalar_value);  // NOLINT
+    args[arg_index] = vector_class<char>(begin, begin + sizeof(T));
+  }
+
+  /**
+   * Largest work-group size the kernel allows on the device of the queue,
+   * the kernel is built but not invoked (sycl-gtx extension)
+   */
+  template <typename KernelName, class KernelType>
+  ::size_t get_work_group_size(KernelType kernFunctor) {
+    return get_work_group_size(q, build<KernelName>(kernFunctor)->get());
+  }
 
   /** 3.5.3.1 Single Task invoke */
   template <typename KernelName, class KernelType>
   void single_task(KernelType kernFunctor) {
-    auto kern = build(kernFunctor);
+    auto kern = build<KernelName>(kernFunctor);
     issue_enqueue(kern, &issue::enqueue_task);
   }
 
@@ -121,16 +188,52 @@ class handler {
                                       kernFunctor);
   }
 
-  // TODO(progtx): 3.5.3.3 Parallel For hierarchical invoke
-
+  /**
+   * 3.5.3.3 Parallel For hierarchical invoke
+   *
+   * The function is invoked once per work-group with a group parameter,
+   * it then calls parallel_for_work_item for the code of the work items.
+   * The size of the work-groups is the largest the device allows,
+   * sides of a power of two in more than one dimension.
+   */
   template <typename KernelName, class WorkgroupFunctionType, int dimensions>
   void parallel_for_work_group(range<dimensions> numWorkGroups,
-                               WorkgroupFunctionType kernFunctor);
+                               WorkgroupFunctionType kernFunctor) {
+    auto kern = build<KernelName>(kernFunctor);
+    auto workGroupSize = work_group_range<dimensions>(
+        get_work_group_size(q, kern->get()));
+    issue_enqueue(kern, &issue::enqueue_nd_range,
+                  work_group_nd_range(numWorkGroups, workGroupSize));
+  }
 
   template <typename KernelName, class WorkgroupFunctionType, int dimensions>
   void parallel_for_work_group(range<dimensions> numWorkGroups,
                                range<dimensions> workGroupSize,
-                               WorkgroupFunctionType kernFunctor);
+                               WorkgroupFunctionType kernFunctor) {
+    parallel_for_nd_range<KernelName>(
+        work_group_nd_range(numWorkGroups, workGroupSize), id<dimensions>(),
+        kernFunctor);
+  }
+
+  /**
+   * Reduces the input buffer into result[0] in two launches,
+   * one initializing result[0] and one reducing the input,
+   * see SYCL/reduction.h for the built-in operators.
+   * Each work-group reduces a tree in local memory,
+   * the partial results of the groups are then combined atomically.
+   * @param op combines two values, it is traced into the kernel
+   * @param identity doesn't change a value when combined with it
+   */
+  template <typename T, class BinaryOperation>
+  void reduce(buffer<T, 1>& input, buffer<T, 1>& result, BinaryOperation op,
+              typename std::remove_reference<T>::type identity);
+
+  /** Starts from the identity of a built-in operator */
+  template <typename T, class BinaryOperation>
+  void reduce(buffer<T, 1>& input, buffer<T, 1>& result,
+              BinaryOperation op) {
+    reduce(input, result, op, BinaryOperation::template identity<T>());
+  }
 
   // Specializations for working with functors instead of lambdas
 
@@ -170,7 +273,6 @@ class handler {
         numWorkItems, workItemOffset, kernFunctor);
   }
 
-  // TODO(progtx): Hierarchical invoke
   template <class WorkgroupFunctionType, int dimensions,
             class = decltype(WorkgroupFunctionType::operator())>
   void parallel_for_work_group(range<dimensions> numWorkGroups,
@@ -192,19 +294,19 @@ class handler {
 
   template <bool = true>
   void single_task(kernel syclKernel) {
-    auto kern = shared_ptr_class<kernel>(new kernel(std::move(syclKernel)));
+    auto kern = interop(std::move(syclKernel));
     issue_enqueue(kern, &issue::enqueue_task);
   }
 
   template <int dimensions>
   void parallel_for(range<dimensions> numWorkItems, kernel syclKernel) {
-    auto kern = shared_ptr_class<kernel>(new kernel(std::move(syclKernel)));
+    auto kern = interop(std::move(syclKernel));
     issue_enqueue(kern, &issue::enqueue_range, numWorkItems, id<dimensions>());
   }
 
   template <int dimensions>
   void parallel_for(nd_range<dimensions> ndRange, kernel syclKernel) {
-    auto kern = shared_ptr_class<kernel>(new kernel(std::move(syclKernel)));
+    auto kern = interop(std::move(syclKernel));
     issue_enqueue(kern, &issue::enqueue_nd_range, ndRange);
   }
 };
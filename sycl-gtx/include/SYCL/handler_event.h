@@ -5,13 +5,17 @@
 namespace cl {
 namespace sycl {
 
-// Forward declaration
+// Forward declarations
 class handler;
+namespace detail {
+class task_graph;
+}
 
 // TODO(progtx):
 class handler_event {
  private:
   friend class handler;
+  friend class detail::task_graph;
 
   event kernelEvent;
   event completeEvent;
@@ -186,6 +186,7 @@ enum class device_execution_capabilities : cl_device_exec_capabilities {
 };
 
 using queue_profiling = bool;
+using queue_out_of_order = bool;
 /** C.4 Queue Information Descriptors */
 enum class queue : cl_command_queue_info {
   context = CL_QUEUE_CONTEXT,
@@ -19,11 +19,13 @@ namespace sycl {
 // Forward declarations
 class context;
 class event;
+class handler;
 class queue;
 class program;
 
 class kernel {
  private:
+  friend class handler;
   friend class program;
   friend class detail::issue_command;
   friend class detail::kernel_ns::source;
@@ -32,6 +34,11 @@ class kernel {
   context ctx;
   shared_ptr_class<program> prog;
   detail::kernel_ns::source src;
+  /**
+   * Type name the kernel was invoked with, names its profiled commands.
+   * Empty for kernels created through interoperability.
+   */
+  string_class name;
 
   // These are meant only for program class
   kernel(bool);
@@ -82,7 +89,8 @@ class kernel {
   }
 
  private:
-  static cl_event get_cl_event(event* evnt);
+  /** Stores the event, taking over the reference, and profiles it */
+  void set_cl_event(queue* q, event* evnt, cl_event ev) const;
   static cl_command_queue get_cl_queue(queue* q);
 
   static const cl_event* get_events_ptr(
@@ -99,13 +107,14 @@ class kernel {
                      id<dimensions> offset) const {
     ::size_t* global_work_size = &num_work_items[0];
     ::size_t* offst = &static_cast<::size_t&>(offset[0]);
-    auto ev = get_cl_event(evnt);
+    cl_event ev;
 
     auto error_code = clEnqueueNDRangeKernel(
         get_cl_queue(q), kern.get(), dimensions, offst, global_work_size,
         nullptr, static_cast<::cl_uint>(wait_events.size()),
         get_events_ptr(wait_events), &ev);
     detail::error::report(error_code);
+    set_cl_event(q, evnt, ev);
   }
 
   template <int dimensions>
@@ -127,13 +136,14 @@ class kernel {
       }
     }
 
-    auto ev = get_cl_event(evnt);
+    cl_event ev;
 
     auto error_code = clEnqueueNDRangeKernel(
         get_cl_queue(q), kern.get(), dimensions, offst, global_work_size,
         local_work_size, static_cast<::cl_uint>(wait_events.size()),
         get_events_ptr(wait_events), &ev);
     detail::error::report(error_code);
+    set_cl_event(q, evnt, ev);
   }
 };
 
@@ -0,0 +1,62 @@
+#pragma once
+
+// Optimization passes over traced kernels (sycl-gtx extension)
+
+#include "SYCL/detail/common.h"
+#include <atomic>
+
+namespace cl {
+namespace sycl {
+
+// Forward declaration
+class program;
+
+/** Passes run over the traced code of a kernel before it is compiled */
+enum class kernel_pass : unsigned char {
+  /** Computes operations on literals, also through variables holding one */
+  constant_folding,
+  /**
+   * Computes expressions a SYCL_FOR or SYCL_WHILE loop doesn't change
+   * once, in front of the loop
+   */
+  loop_invariants,
+  /** Computes an expression repeated within a block once, into a variable */
+  common_subexpressions,
+  /** Removes unread variables, copies of variables and overwritten values */
+  dead_code,
+};
+
+/**
+ * Chooses the passes run over kernels compiled from now on,
+ * all of them are enabled by default.
+ *
+ * The passes only rewrite expressions without side effects,
+ * they never move buffer reads out of their block
+ * or integer divisions out of a condition.
+ * Kernels compiled with different passes are cached separately.
+ */
+class kernel_optimizer {
+ private:
+  friend class program;
+
+  static std::atomic<unsigned> passes;
+
+  /** A bit for each enabled pass */
+  static unsigned get_passes();
+
+ public:
+  static void enable(kernel_pass pass);
+  static void disable(kernel_pass pass);
+  static bool is_enabled(kernel_pass pass);
+
+  /**
+   * Enables only the listed passes,
+   * a comma separated list of their names, e.g. "constant_folding,dead_code",
+   * "all" or "none".
+   * Also read from the SYCL_GTX_KERNEL_PASSES environment variable at startup.
+   */
+  static void configure(const string_class& list);
+};
+
+}  // namespace sycl
+}  // namespace cl
@@ -0,0 +1,76 @@
+#pragma once
+
+// Device memory recycling (sycl-gtx extension)
+
+#include "SYCL/detail/common.h"
+#include <map>
+#include <tuple>
+
+namespace cl {
+namespace sycl {
+
+// Forward declaration
+class queue;
+
+namespace detail {
+// Forward declaration
+class buffer_base;
+}  // namespace detail
+
+struct memory_pool_stats {
+  /** Allocations served by a recycled memory object */
+  ::size_t hits = 0;
+  /** Allocations that had to create a new memory object */
+  ::size_t misses = 0;
+  /** Memory objects returned to the pool by destroyed buffers */
+  ::size_t recycled = 0;
+  /** Memory objects released because of the capacity or trimming */
+  ::size_t released = 0;
+  /** Idle memory currently held by the pool */
+  ::size_t cached_bytes = 0;
+  ::size_t cached_objects = 0;
+};
+
+/**
+ * Keeps the device memory of destroyed buffers for later buffers,
+ * so that short-lived buffers don't allocate on every use.
+ *
+ * Memory objects are recycled within the same context and flags,
+ * sizes are rounded up to classes at most a quarter apart.
+ * Buffers sharing memory with the host aren't pooled.
+ */
+class memory_pool {
+ private:
+  friend class detail::buffer_base;
+
+  using key_t = std::tuple<cl_context, cl_mem_flags, ::size_t>;
+
+  struct state;
+  /**
+   * Never destroyed,
+   * buffers with static storage duration recycle their memory on exit
+   */
+  static state& get_state();
+
+  static ::size_t size_class(::size_t size);
+  /** Expects the lock to be held */
+  static void release_until(::size_t keep_bytes);
+
+  static cl_mem allocate(queue* q, cl_mem_flags flags, ::size_t size,
+                         ::cl_int& error_code);
+  /** Takes over a memory object that is no longer used */
+  static void recycle(cl_mem mem);
+
+ public:
+  /** Upper limit on the idle memory kept, 256 MiB by default */
+  static void set_capacity(::size_t bytes);
+  static ::size_t get_capacity();
+
+  /** Releases idle memory until at most keep_bytes are left */
+  static void trim(::size_t keep_bytes = 0);
+
+  static memory_pool_stats get_stats();
+};
+
+}  // namespace sycl
+}  // namespace cl
@@ -0,0 +1,162 @@
+#pragma once
+
+// Out-of-core execution (sycl-gtx extension)
+
+#include "SYCL/access.h"
+#include "SYCL/buffer.h"
+#include "SYCL/detail/common.h"
+#include "SYCL/handler.h"
+#include "SYCL/queue.h"
+#include "SYCL/ranges.h"
+#include <algorithm>
+
+namespace cl {
+namespace sycl {
+
+namespace detail {
+
+/** Splits ranges along their last dimension */
+template <int dimensions>
+struct last_dimension;
+
+template <>
+struct last_dimension<1> {
+  static id<1> offset(::size_t start) {
+    return id<1>(start);
+  }
+  static range<1> resize(const range<1>& r, ::size_t length) {
+    return range<1>(length);
+  }
+};
+
+template <>
+struct last_dimension<2> {
+  static id<2> offset(::size_t start) {
+    return id<2>(0, start);
+  }
+  static range<2> resize(const range<2>& r, ::size_t length) {
+    return range<2>(r.get(0), length);
+  }
+};
+
+template <>
+struct last_dimension<3> {
+  static id<3> offset(::size_t start) {
+    return id<3>(0, 0, start);
+  }
+  static range<3> resize(const range<3>& r, ::size_t length) {
+    return range<3>(r.get(0), r.get(1), length);
+  }
+};
+
+}  // namespace detail
+
+/**
+ * Part of an out-of-core range processed by a single command group.
+ * Chunks span whole rows, they are split along the last dimension.
+ */
+template <int dimensions = 1>
+class out_of_core_chunk {
+ private:
+  friend class out_of_core;
+
+  id<dimensions> offset;
+  range<dimensions> rang;
+  /** Sub-buffers of the chunk, released once the chunk is done */
+  vector_class<shared_ptr_class<detail::buffer_base>> buffers;
+
+  out_of_core_chunk(id<dimensions> offset, range<dimensions> rang)
+      : offset(offset), rang(rang) {}
+
+ public:
+  /** Position of the chunk inside the whole range */
+  id<dimensions> get_offset() const {
+    return offset;
+  }
+  range<dimensions> get_range() const {
+    return rang;
+  }
+
+  /**
+   * Accesses the part of the buffer covered by the chunk,
+   * indices are relative to the chunk offset.
+   * Only this part is allocated on the device and transferred.
+   * The buffer is kept on the host from now on,
+   * so it can be larger than the device memory.
+   */
+  template <access::mode mode, typename DataType>
+  accessor<DataType, dimensions, mode, access::target::global_buffer>
+  get_access(handler& cgh, buffer<DataType, dimensions>& buf) {
+    static_cast<detail::buffer_base&>(buf).make_out_of_core();
+    auto sub =
+        std::make_shared<buffer<DataType, dimensions>>(buf, offset, rang);
+    buffers.push_back(sub);
+    return sub->template get_access<mode>(cgh);
+  }
+};
+
+/**
+ * Processes buffers larger than the device can hold in chunks.
+ *
+ * Each chunk is submitted as its own command group,
+ * with device memory for the part of each buffer it accesses.
+ * Chunks alternate between two queues,
+ * so one chunk is uploaded and downloaded while the other computes.
+ * At most two chunks are in flight, their memory is recycled by memory_pool.
+ */
+class out_of_core {
+ private:
+  queue* queues[2];
+  /** Number of work items per chunk, 0 to derive it from the device */
+  ::size_t chunk_items = 0;
+
+  /** Work items that fit on the device twice over */
+  ::size_t get_chunk_items(::size_t bytes_per_item) const;
+
+ public:
+  explicit out_of_core(queue& q) : out_of_core(q, q) {}
+  /** Chunks alternate between both queues */
+  out_of_core(queue& first, queue& second);
+
+  void set_chunk_size(::size_t items) {
+    chunk_items = items;
+  }
+
+  /**
+   * Calls cgf(cgh, chunk) for each chunk of the range,
+   * blocks until all chunks have completed and their results are on the host.
+   * @param bytes_per_item is the device memory used by one work item,
+   * summed over all buffers it accesses
+   */
+  template <int dimensions, typename T>
+  void submit(range<dimensions> total, ::size_t bytes_per_item, T cgf) {
+    ::size_t row_items = 1;
+    for (int i = 0; i < dimensions - 1; ++i) {
+      row_items *= total.get(i);
+    }
+    ::size_t length = total.get(dimensions - 1);
+    ::size_t rows = get_chunk_items(bytes_per_item) / row_items;
+    if (rows == 0) {
+      rows = 1;
+    }
+
+    using chunk_t = out_of_core_chunk<dimensions>;
+    shared_ptr_class<chunk_t> in_flight[2];
+    ::size_t k = 0;
+    for (::size_t start = 0; start < length; start += rows, ++k) {
+      auto& slot = in_flight[k % 2];
+      // Waits for the chunk submitted two steps ago
+      slot.reset();
+
+      using split = detail::last_dimension<dimensions>;
+      auto size = std::min(rows, length - start);
+      slot.reset(new chunk_t(split::offset(start), split::resize(total, size)));
+
+      auto chunk = slot.get();
+      queues[k % 2]->submit([&](handler& cgh) { cgf(cgh, *chunk); });
+    }
+  }
+};
+
+}  // namespace sycl
+}  // namespace cl
@@ -0,0 +1,125 @@
+#pragma once
+
+// Command timeline profiler (sycl-gtx extension)
+
+#include "SYCL/detail/common.h"
+#include "SYCL/event.h"
+#include "SYCL/refc.h"
+#include <atomic>
+#include <iosfwd>
+#include <map>
+
+namespace cl {
+namespace sycl {
+
+// Forward declaration
+class kernel;
+
+namespace detail {
+// Forward declaration
+class buffer_base;
+}  // namespace detail
+
+enum class profiler_command { kernel, write, read, copy, map, unmap };
+
+struct profiler_record {
+  profiler_command command = profiler_command::kernel;
+  /** Kernel function name, or the kind of command for the others */
+  string_class name;
+  /** Bytes transferred, zero for kernels */
+  ::size_t bytes = 0;
+  /** Queues are numbered in the order the profiler first sees them */
+  ::size_t queue = 0;
+  /**
+   * Device timestamps in nanoseconds,
+   * zero if the queue was created without profiling
+   */
+  cl_ulong queued = 0;
+  cl_ulong submit = 0;
+  cl_ulong start = 0;
+  cl_ulong end = 0;
+};
+
+/** Execution times of all commands with the same name, in nanoseconds */
+struct profiler_summary {
+  profiler_command command = profiler_command::kernel;
+  string_class name;
+  ::size_t count = 0;
+  ::size_t bytes = 0;
+  cl_ulong total = 0;
+  cl_ulong min = 0;
+  cl_ulong max = 0;
+};
+
+/**
+ * Records every command the runtime enqueues while enabled,
+ * the kernels and the transfers, copies and mappings of buffers.
+ *
+ * OpenCL only provides timestamps for queues created with profiling,
+ * queues created while the profiler is enabled always have it.
+ * Reading the records waits for the recorded commands to complete.
+ */
+class profiler {
+ private:
+  friend class kernel;
+  friend class detail::buffer_base;
+
+  struct pending {
+    profiler_record record;
+    event evnt;
+  };
+  /** Holds on to the queue, so its handle can't be reused by another one */
+  using queue_ref = detail::refc<cl_command_queue, clRetainCommandQueue,
+                                 clReleaseCommandQueue>;
+
+  /** Past this many commands in flight the completed ones are resolved */
+  static const ::size_t drain_threshold = 1024;
+
+  static std::atomic<bool> enabled;
+  static vector_class<pending> in_flight;
+  static vector_class<profiler_record> records;
+  static std::map<queue_ref, ::size_t> queues;
+  static mutex_class lock;
+
+  /** Commands other than kernels are named after their kind */
+  static void record(cl_command_queue q, cl_event evnt,
+                     profiler_command command, string_class name = "",
+                     ::size_t bytes = 0);
+  /** Waits for the commands in flight and reads their timestamps */
+  static void resolve();
+  /**
+   * Resolves the commands at the front of in_flight that have completed,
+   * expects the lock to be held
+   */
+  static void drain_completed();
+  /** The command has to be complete */
+  static void read_timestamps(pending& p);
+
+ public:
+  static void enable();
+  static void disable();
+  static bool is_enabled();
+
+  /** Discards everything recorded so far */
+  static void clear();
+
+  /** Recorded commands in the order they were enqueued */
+  static vector_class<profiler_record> get_records();
+  /** Profiled commands grouped by name, longest total time first */
+  static vector_class<profiler_summary> get_summary();
+
+  /**
+   * Writes the profiled commands in the Chrome trace event format,
+   * which chrome://tracing and Perfetto can display.
+   * Each queue is shown as a separate thread.
+   */
+  static void export_chrome_trace(std::ostream& os);
+  /** @return false if the file could not be written */
+  static bool export_chrome_trace(const string_class& path);
+
+  /** Writes the summary as a table */
+  static void print_summary(std::ostream& os);
+};
+
+}  // namespace sycl
+}  // namespace cl
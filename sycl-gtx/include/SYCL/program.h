@@ -12,8 +12,10 @@
 #include "SYCL/error_handler.h"
 #include "SYCL/info.h"
 #include "SYCL/kernel.h"
+#include "SYCL/kernel_optimizer.h"
 #include "SYCL/param_traits.h"
 #include "SYCL/refc.h"
+#include "SYCL/runtime_stats.h"
 #include <map>
 
 namespace cl {
@@ -42,23 +44,42 @@ class program {
   void init_kernels();
   vector_class<cl_program> get_program_pointers() const;
 
+  /** Runs the kernel passes given by the bits of kernel_optimizer */
   void compile(string_class compile_options, ::size_t kernel_name_id,
-               shared_ptr_class<kernel> kern);
+               shared_ptr_class<kernel> kern, unsigned passes);
   void report_compile_error(shared_ptr_class<kernel> kern, device& dev) const;
 
+  /** Returns false if the binaries cannot be used for the current devices */
+  bool build_from_binaries(
+      const vector_class<vector_class<unsigned char>>& binaries,
+      const string_class& kernel_name, const string_class& build_options,
+      shared_ptr_class<kernel> kern);
+
+  /** Compiles and links a single kernel, reusing a cached build if possible */
+  void build(string_class build_options, ::size_t kernel_name_id,
+             shared_ptr_class<kernel> kern);
+
   template <class KernelType>
-  void compile(KernelType kernFunctor, string_class compile_options = "") {
+  static shared_ptr_class<kernel> trace(KernelType kernFunctor) {
+    detail::runtime_recorder::timer timing(runtime_phase::trace);
     auto src = detail::kernel_ns::constructor<
         typename detail::first_arg<KernelType>::type>::get(kernFunctor);
+    timing.stop();
     auto kern = shared_ptr_class<kernel>(new kernel(true));
     kern->src = std::move(src);
-    compile(compile_options, detail::kernel_name::get<KernelType>(), kern);
+    return kern;
   }
 
   template <class KernelType>
-  void build(KernelType kernFunctor, string_class compile_options = "") {
-    compile(kernFunctor, compile_options);
-    link();
+  void compile(KernelType kernFunctor, string_class compile_options = "") {
+    compile(compile_options, detail::kernel_name::get<KernelType>(),
+            trace(kernFunctor), kernel_optimizer::get_passes());
+  }
+
+  template <class KernelType>
+  void build(KernelType kernFunctor, string_class build_options = "") {
+    build(build_options, detail::kernel_name::get<KernelType>(),
+          trace(kernFunctor));
   }
 
  public:
@@ -137,23 +158,9 @@ class program {
 
   template <class Contained_t>
   struct traits<vector_class<vector_class<Contained_t>>,
-                info::program::binaries>
-      : detail::array_traits<Contained_t*, info::program,
-                             info::program::binaries> {
-    using DoubleContainer = vector_class<vector_class<Contained_t>>;
-    DoubleContainer get_info(const program* p) {
-      auto binary_sizes = p->get_info<info::program::binary_sizes>();
-      this->get(p->prog.get());
-
-      DoubleContainer ret;
-      static const auto inner_type_size = sizeof(Contained_t);
-      ::size_t i = 0;
-      for (auto bin_size : binary_sizes) {
-        ret.emplace_back(this->param_value[i],
-                         this->param_value[i] + bin_size / inner_type_size);
-        ++i;
-      }
-      return ret;
+                info::program::binaries> {
+    vector_class<vector_class<Contained_t>> get_info(const program* p) {
+      return p->get_binaries();
     }
   };
 
@@ -163,9 +170,11 @@ class program {
     return traits<param_traits_t<info::program, param>, param>().get_info(this);
   }
 
-  // TODO(progtx):
+  /** One binary per device associated with the program */
   vector_class<vector_class<unsigned char>> get_binaries() const;
   vector_class<::size_t> get_binary_sizes() const;
+
+  // TODO(progtx):
   vector_class<device> get_devices() const;
   string_class get_build_options() const;
 
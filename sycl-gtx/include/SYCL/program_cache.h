@@ -0,0 +1,38 @@
+#pragma once
+
+// Persistent cache of program binaries (sycl-gtx extension)
+
+#include "SYCL/detail/common.h"
+
+namespace cl {
+namespace sycl {
+
+/**
+ * Keeps the binaries of built programs on disk,
+ * so a later run of the application doesn't invoke the OpenCL compiler.
+ *
+ * The cache directory is read from the SYCL_GTX_CACHE_DIR environment variable
+ * and has to exist beforehand; the cache is disabled if the variable is unset.
+ * Multiple processes can share the same directory.
+ */
+class program_cache {
+ public:
+  /** Overrides the environment variable, an empty string disables the cache */
+  static void set_directory(string_class dir);
+  static string_class get_directory();
+
+  /**
+   * Writes all binaries loaded or built by this process into a single file,
+   * which can be shipped together with the application.
+   */
+  static void export_bundle(const string_class& file_name);
+
+  /**
+   * Reads a bundle created by export_bundle and adds its entries to the cache.
+   * Without a cache directory the entries are kept in memory.
+   */
+  static void import_bundle(const string_class& file_name);
+};
+
+}  // namespace sycl
+}  // namespace cl
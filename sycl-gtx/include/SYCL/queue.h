@@ -7,12 +7,14 @@
 #include "SYCL/detail/common.h"
 #include "SYCL/detail/debug.h"
 #include "SYCL/detail/synchronizer.h"
+#include "SYCL/detail/task_graph.h"
 #include "SYCL/device.h"
 #include "SYCL/error_handler.h"
 #include "SYCL/handler_event.h"
 #include "SYCL/info.h"
 #include "SYCL/param_traits.h"
 #include "SYCL/refc.h"
+#include "SYCL/runtime_stats.h"
 
 namespace cl {
 namespace sycl {
@@ -20,24 +22,24 @@ namespace sycl {
 /** Encapsulation of an OpenCL cl_command_queue */
 class queue {
  private:
-  friend class detail::synchronizer;
-
-  using buffer_set = std::set<detail::buffer_base*>;
+  friend class handler;
+  friend class detail::task_graph;
 
   context ctx;
   device dev;
+  /** Set by create_queue, so it has to be initialized before command_q */
+  bool out_of_order = false;
   detail::refc<cl_command_queue, clRetainCommandQueue, clReleaseCommandQueue>
       command_q;
   exception_list ex_list;
-  detail::command_group command_group;
-  buffer_set buffers_in_use;
-  bool is_flushed = true;
-  vector_class<queue> subqueues;
+  /** Shared by copies of the queue */
+  shared_ptr_class<detail::runtime_recorder> recorder =
+      std::make_shared<detail::runtime_recorder>();
 
   void display_device_info() const;
-  cl_command_queue create_queue(bool display_info = true,
-                                bool register_with_synchronizer = true,
-                                info::queue_profiling enable_profiling = false);
+  cl_command_queue create_queue(
+      bool display_info = true, info::queue_profiling enable_profiling = false,
+      info::queue_out_of_order enable_out_of_order = false);
 
  public:
   /**
@@ -64,6 +66,15 @@ class queue {
         info::queue_profiling profilingFlag,
         const async_handler& asyncHandler = detail::default_async_handler);
 
+  /**
+   * Creates a queue that can execute independent commands concurrently.
+   * Falls back to in-order execution if the device doesn't support it.
+   */
+  queue(const context& syclContext, const device& syclDevice,
+        info::queue_profiling profilingFlag,
+        info::queue_out_of_order outOfOrderFlag,
+        const async_handler& asyncHandler = detail::default_async_handler);
+
   /** Creates a queue for the provided device. */
   queue(const device& syclDevice,
         const async_handler& asyncHandler = detail::default_async_handler);
@@ -75,17 +86,6 @@ class queue {
   queue(cl_command_queue clQueue,
         const async_handler& asyncHandler = detail::default_async_handler);
 
- private:
-  /** Create sub-queue, which executes the command group immediately */
-  template <typename T>
-  queue(queue* master, T cgf)
-      : ctx(master->ctx),
-        dev(master->dev),
-        command_q(create_queue(false, false)),
-        command_group(*this, cgf),
-        is_flushed(false) {}
-
- public:
   ~queue();
 
   // Copy semantics
@@ -94,19 +94,17 @@ class queue {
 
   /**
    * Queue requires custom move semantics
-   * because the parent pointer is carrier in subqueues
+   * because the queue pointer is carried in pending command groups
    */
   queue(queue&& move) noexcept
       : SYCL_MOVE_INIT(ctx),
         SYCL_MOVE_INIT(dev),
+        SYCL_MOVE_INIT(out_of_order),
         SYCL_MOVE_INIT(command_q),
         SYCL_MOVE_INIT(ex_list),
-        SYCL_MOVE_INIT(command_group),
-        SYCL_MOVE_INIT(buffers_in_use),
-        SYCL_MOVE_INIT(is_flushed),
-        SYCL_MOVE_INIT(subqueues) {
+        SYCL_MOVE_INIT(recorder) {
     move.command_q = nullptr;
-    command_group.q = this;
+    detail::task_graph::replace_queue(&move, this);
   }
   queue& operator=(queue&& move) noexcept {
     std::swap(*this, move);
@@ -116,16 +114,22 @@ class queue {
     using std::swap;
     SYCL_SWAP(ctx);
     SYCL_SWAP(dev);
+    SYCL_SWAP(out_of_order);
     SYCL_SWAP(command_q);
     SYCL_SWAP(ex_list);
-    SYCL_SWAP(command_group);
-    SYCL_SWAP(buffers_in_use);
-    SYCL_SWAP(is_flushed);
-    SYCL_SWAP(subqueues);
+    SYCL_SWAP(recorder);
+    detail::task_graph::replace_queue(&first, nullptr);
+    detail::task_graph::replace_queue(&second, &first);
+    detail::task_graph::replace_queue(nullptr, &second);
   }
 
   bool is_host();
 
+  /** Whether commands are enqueued with explicit dependencies */
+  bool is_out_of_order() const {
+    return out_of_order;
+  }
+
   // TODO(progtx): Returns the underlying OpenCL command queue after doing a
   // retain.
   /** Afterwards it needs to be manually released. */
@@ -137,6 +141,12 @@ class queue {
   /** Returns the SYCL device the queue is associated with. */
   device get_device() const;
 
+  /**
+   * Host time the runtime spent on the kernels submitted to the queue,
+   * from tracing them to flushing their command groups (sycl-gtx extension)
+   */
+  runtime_stats get_runtime_stats() const;
+
   template <info::queue param>
   typename param_traits<info::queue, param>::type get_info() const {
     return detail::non_vector_traits<info::queue, param, 1>().get(
@@ -163,11 +173,15 @@ class queue {
    */
   void wait_and_throw();
 
-  // TODO(progtx):
+  /**
+   * Records the command group and enqueues it to the underlying OpenCL queue
+   * as soon as the command groups it depends on are enqueued
+   * and no host accessor is blocking its buffers.
+   * The complete event is only set if the group could be enqueued immediately.
+   */
   template <typename T>
   handler_event submit(T cgf) {
-    subqueues.push_back({this, cgf});
-    return subqueues.back().process(buffers_in_use);
+    return detail::task_graph::submit(*this, cgf);
   }
 
   // TODO(progtx):
@@ -175,12 +189,7 @@ class queue {
   handler_event submit(T cgf, queue& secondaryQueue);
 
  private:
-  void flush();
   void finish();
-  void wait_subqueues(bool and_throw);
-  handler_event process(buffer_set& buffers_in_use_master);
-  static vector_class<cl_event> get_wait_events(const buffer_set& dependencies,
-                                                buffer_set& buffers_in_use);
 };
 
 }  // namespace sycl
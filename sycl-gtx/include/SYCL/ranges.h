@@ -2,6 +2,7 @@
 
 // 3.7.1 Ranges and identifiers
 
+#include "SYCL/ranges/group.h"
 #include "SYCL/ranges/id.h"
 #include "SYCL/ranges/item.h"
 #include "SYCL/ranges/nd_item.h"
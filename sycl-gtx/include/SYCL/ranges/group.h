@@ -0,0 +1,97 @@
+#pragma once
+
+// 3.5.1.6 Group class
+
+#include "SYCL/detail/point_ref.h"
+#include "SYCL/ranges/id.h"
+#include "SYCL/ranges/nd_range.h"
+#include "SYCL/ranges/range.h"
+
+namespace cl {
+namespace sycl {
+
+namespace detail {
+namespace kernel_ns {
+// Forward declaration
+template <class Input>
+struct constructor;
+}  // namespace kernel_ns
+}  // namespace detail
+
+/**
+ * Work-group of a kernel invoked through parallel_for_work_group.
+ * Code using it directly runs once per work-group,
+ * code inside parallel_for_work_item once per work item of the group.
+ */
+template <int dimensions = 1>
+struct group {
+ protected:
+  friend struct detail::kernel_ns::constructor<group<dimensions>>;
+
+  id<dimensions> group_id;
+  range<dimensions> group_range;
+  nd_range<dimensions> execution_range;
+
+  group(id<dimensions> group_id, range<dimensions> group_range,
+        nd_range<dimensions> execution_range)
+      : group_id(group_id),
+        group_range(group_range),
+        execution_range(execution_range) {}
+
+  using size_t = detail::point_ref<true>;
+
+ public:
+  id<dimensions> get() const {
+    return group_id;
+  }
+  size_t get(int dimension) const {
+    return group_id.get(dimension);
+  }
+  size_t operator[](int dimension) const {
+    return get(dimension);
+  }
+
+  range<dimensions> get_group_range() const {
+    return group_range;
+  }
+  size_t get_group_range(int dimension) const {
+    return get_group_range().get(dimension);
+  }
+
+  range<dimensions> get_global_range() const {
+    return execution_range.get_global();
+  }
+  size_t get_global_range(int dimension) const {
+    return get_global_range().get(dimension);
+  }
+
+  /** Number of work items in the group */
+  range<dimensions> get_local_range() const {
+    return execution_range.get_local();
+  }
+  size_t get_local_range(int dimension) const {
+    return get_local_range().get(dimension);
+  }
+
+  nd_range<dimensions> get_nd_range() const {
+    return execution_range;
+  }
+};
+
+/**
+ * 3.5.3.3 Parallel For hierarchical invoke
+ *
+ * Runs the function once for each work item of the group,
+ * passing it an nd_item or an item with the global ID.
+ * The work items wait for each other before and after the call,
+ * so values written in the scope of the group are visible inside it
+ * and values written by work items are visible afterwards.
+ */
+template <int dimensions, class WorkItemFunctionType>
+void parallel_for_work_item(const group<dimensions>& g,
+                            WorkItemFunctionType kernFunctor) {
+  detail::kernel_ns::constructor<group<dimensions>>::work_item(g, kernFunctor);
+}
+
+}  // namespace sycl
+}  // namespace cl
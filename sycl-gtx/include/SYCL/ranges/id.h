@@ -78,6 +78,11 @@ struct get_special_id {
     i.set(data_ref::type_t::id_local);
     return i;
   }
+  static id<dimensions> group() {
+    auto i = id<dimensions>();
+    i.set(data_ref::type_t::id_group);
+    return i;
+  }
 };
 
 }  // namespace detail
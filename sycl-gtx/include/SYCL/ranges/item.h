@@ -14,6 +14,8 @@ template <int dimensions>
 struct range;
 template <int dimensions>
 struct nd_item;
+template <int dimensions>
+struct group;
 
 namespace detail {
 
@@ -34,6 +36,7 @@ struct item {
  protected:
   friend struct detail::kernel_ns::constructor<item<dimensions>>;
   friend struct detail::kernel_ns::constructor<nd_item<dimensions>>;
+  friend struct detail::kernel_ns::constructor<group<dimensions>>;
 
   item(id<dimensions> global_id, range<dimensions> global_range,
        id<dimensions> offset = id<dimensions>())
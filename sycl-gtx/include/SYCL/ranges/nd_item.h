@@ -17,6 +17,8 @@ template <int dimensions>
 struct range;
 template <int dimensions>
 struct nd_range;
+template <int dimensions>
+struct group;
 
 namespace detail {
 namespace kernel_ns {
@@ -29,6 +31,7 @@ template <int dimensions = 1>
 struct nd_item {
  protected:
   friend struct detail::kernel_ns::constructor<nd_item<dimensions>>;
+  friend struct detail::kernel_ns::constructor<group<dimensions>>;
 
   item<dimensions> global_item;
   item<dimensions> local_item;
@@ -69,7 +72,7 @@ struct nd_item {
     return local_item.get_offset();
   }
   size_t get_group(int dimension) const {
-    return get_group()[dimension];
+    return get_group().get(dimension);
   }
   size_t get_group_linear_id() const {
     // TODO(progtx):
@@ -110,7 +113,8 @@ struct nd_item {
         break;
     }
 
-    detail::kernel_add(string_class("barrier(") + flag_string + ")");
+    detail::kernel_add(detail::ir::expr::call(
+        "barrier", {flag_string}, detail::ir::node::side_effects));
   }
 };
 
@@ -22,6 +22,9 @@ struct point_names {
 
   static const string_class id_local;
   static const string_class range_local;
+
+  static const string_class id_group;
+  static const string_class range_group;
 };
 
 #define SYCL_POINT_OP_EQ(lhs, op)             \
@@ -58,6 +61,12 @@ struct point : data_ref {
       case type_t::range_local:
         name = point_names::range_local;
         break;
+      case type_t::id_group:
+        name = point_names::id_group;
+        break;
+      case type_t::range_group:
+        name = point_names::range_group;
+        break;
       default:
         break;
     }
@@ -88,6 +97,8 @@ struct point : data_ref {
       case type_t::id_local:
       case type_t::range_global:
       case type_t::range_local:
+      case type_t::id_group:
+      case type_t::range_group:
         return true;
       default:
         return false;
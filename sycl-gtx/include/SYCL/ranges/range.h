@@ -63,6 +63,11 @@ struct get_special_range {
     r.set(data_ref::type_t::range_local);
     return r;
   }
+  static range<dimensions> group() {
+    auto r = empty_range<dimensions>();
+    r.set(data_ref::type_t::range_group);
+    return r;
+  }
 };
 
 }  // namespace detail
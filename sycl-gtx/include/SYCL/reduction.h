@@ -0,0 +1,247 @@
+#pragma once
+
+// Single-call reductions (sycl-gtx extension)
+
+#include "SYCL/access.h"
+#include "SYCL/accessors/buffer.h"
+#include "SYCL/accessors/local.h"
+#include "SYCL/atomic.h"
+#include "SYCL/buffer.h"
+#include "SYCL/detail/common.h"
+#include "SYCL/detail/data_ref.h"
+#include "SYCL/detail/flow_control.h"
+#include "SYCL/detail/group_size.h"
+#include "SYCL/functions/common.h"
+#include "SYCL/handler.h"
+#include "SYCL/info.h"
+#include "SYCL/queue.h"
+#include "SYCL/ranges.h"
+#include "SYCL/vectors/vec.h"
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+namespace cl {
+namespace sycl {
+
+// Built-in operators of handler::reduce
+
+struct plus {
+  template <typename T>
+  static T identity() {
+    return T(0);
+  }
+  detail::data_ref operator()(const detail::data_ref& x,
+                              const detail::data_ref& y) const {
+    return x + y;
+  }
+};
+
+struct minimum {
+  template <typename T>
+  static T identity() {
+    return std::numeric_limits<T>::max();
+  }
+  detail::data_ref operator()(const detail::data_ref& x,
+                              const detail::data_ref& y) const {
+    return min(x, y);
+  }
+};
+
+struct maximum {
+  template <typename T>
+  static T identity() {
+    return std::numeric_limits<T>::lowest();
+  }
+  detail::data_ref operator()(const detail::data_ref& x,
+                              const detail::data_ref& y) const {
+    return max(x, y);
+  }
+};
+
+namespace detail {
+
+/** Whether an OpenCL atomic function implements the operator */
+template <class BinaryOperation, typename T>
+struct reduction_atomic {
+  static const bool available = false;
+};
+
+#define SYCL_REDUCTION_ATOMIC(op, function)                             \
+  template <typename T>                                                 \
+  struct reduction_atomic<op, T> {                                      \
+    static const bool available = std::is_integral<T>::value;           \
+    static void combine(const atomic<T>& element, const data_ref& x) {  \
+      element.function(x);                                              \
+    }                                                                   \
+  };
+
+SYCL_REDUCTION_ATOMIC(plus, fetch_add)
+SYCL_REDUCTION_ATOMIC(minimum, fetch_min)
+SYCL_REDUCTION_ATOMIC(maximum, fetch_max)
+
+#undef SYCL_REDUCTION_ATOMIC
+
+/**
+ * Combines the partial result of a work-group with result[0].
+ * Operators without an atomic function retry a compare and exchange
+ * on the bits of the value until no other group got in between.
+ */
+template <typename T, class BinaryOperation,
+          bool = reduction_atomic<BinaryOperation, T>::available>
+struct reduction_combine {
+  static const access::mode mode = access::mode::read_write;
+
+  using bits_t = typename std::conditional<sizeof(T) == 4, ::cl_uint,
+                                           ::cl_ulong>::type;
+
+  /** Name of the OpenCL function reinterpreting bits as T */
+  static const char* as_type() {
+    if (std::is_floating_point<T>::value) {
+      return sizeof(T) == 4 ? "as_float" : "as_double";
+    }
+    if (std::is_signed<T>::value) {
+      return sizeof(T) == 4 ? "as_int" : "as_long";
+    }
+    return sizeof(T) == 4 ? "as_uint" : "as_ulong";
+  }
+
+  static ir::expr as_bits(const data_ref& x) {
+    return ir::expr::call(sizeof(T) == 4 ? "as_uint" : "as_ulong", {x.name});
+  }
+
+  template <class Accessor>
+  static void initialize(const Accessor& result, const T& identity) {
+    result[0] = identity;
+  }
+
+  template <class Accessor>
+  static void apply(const Accessor& result, const data_ref& partial,
+                    const BinaryOperation& op) {
+    const char* cmpxchg = "atomic_cmpxchg";
+    if (sizeof(T) == 8) {
+      cmpxchg = "atom_cmpxchg";
+      kernel_enable_extension("cl_khr_int64_base_atomics");
+    }
+    if (std::is_same<T, double>::value) {
+      kernel_enable_extension("cl_khr_fp64");
+    }
+
+    data_ref element = result[0];
+    auto pointer = "(volatile __global " + type_string<bits_t>::get() +
+                   "*)" + ir::expr::prefix("&", element.name);
+    auto exchange = [&](const data_ref& old) {
+      return data_ref(ir::expr::call(cmpxchg,
+                                     {pointer, as_bits(old),
+                                      as_bits(op(old, partial))},
+                                     ir::node::side_effects));
+    };
+
+    vec<T, 1> old = element;
+    vec<bits_t, 1> expected = data_ref(as_bits(old));
+    vec<bits_t, 1> seen = exchange(old);
+    SYCL_WHILE(seen != expected) {
+      expected = seen;
+      old = data_ref(ir::expr::call(as_type(), {seen.name}));
+      seen = exchange(old);
+    }
+    SYCL_END
+  }
+};
+
+template <typename T, class BinaryOperation>
+struct reduction_combine<T, BinaryOperation, true> {
+  static const access::mode mode = access::mode::atomic;
+
+  template <class Accessor>
+  static void initialize(const Accessor& result, const T& identity) {
+    result[0].store(identity);
+  }
+
+  template <class Accessor>
+  static void apply(const Accessor& result, const data_ref& partial,
+                    const BinaryOperation&) {
+    reduction_atomic<BinaryOperation, T>::combine(result[0], partial);
+  }
+};
+
+// Kernel names, the reduction kernel also keys its fitted work-group size
+class reduction_init;
+template <typename T, class BinaryOperation>
+class reduction_kernel;
+
+}  // namespace detail
+
+template <typename T, class BinaryOperation>
+void handler::reduce(buffer<T, 1>& input, buffer<T, 1>& result,
+                     BinaryOperation op,
+                     typename std::remove_reference<T>::type identity) {
+  static_assert(sizeof(T) == 4 || sizeof(T) == 8,
+                "Reductions require 32-bit or 64-bit types");
+  using combine = detail::reduction_combine<T, BinaryOperation>;
+  using scratch_t =
+      accessor<T, 1, access::mode::read_write, access::target::local>;
+  using kernel_name = detail::reduction_kernel<T, BinaryOperation>;
+  auto count = input.get_count();
+
+  auto in = input.template get_access<access::mode::read>(*this);
+  auto res = result.template get_access<combine::mode>(*this);
+
+  single_task<detail::reduction_init>(
+      [=]() { combine::initialize(res, identity); });
+  if (count == 0) {
+    return;
+  }
+
+  const ::cl_uint n = static_cast<::cl_uint>(count);
+  auto num_groups = [=](::size_t size) {
+    return std::min((count + size - 1) / size, size);
+  };
+  auto reduction = [&](::size_t size, scratch_t scratch) {
+    const ::cl_uint stride = static_cast<::cl_uint>(num_groups(size) * size);
+    return [=](nd_item<1> index) {
+      auto lid = index.get_local(0);
+      uint1 i = index.get_global(0);
+
+      // Each work item first combines a strided part of the input
+      vec<T, 1> partial = identity;
+      SYCL_WHILE(i < n) {
+        partial = op(partial, in[i]);
+        i += stride;
+      }
+      SYCL_END
+      scratch[lid] = partial;
+      index.barrier(access::fence_space::local_space);
+
+      for (::size_t s = size / 2; s > 0; s /= 2) {
+        SYCL_IF(lid < s) {
+          scratch[lid] = op(scratch[lid], scratch[lid + s]);
+        }
+        SYCL_END
+        if (s > 1) {
+          index.barrier(access::fence_space::local_space);
+        }
+      }
+
+      SYCL_IF(lid == 0) {
+        combine::apply(res, scratch[0], op);
+      }
+      SYCL_END
+    };
+  };
+
+  // The tree halves the work items in each step
+  auto group_size = detail::fitted_group_size<kernel_name>(
+      *q, sizeof(T), 0, [&](::size_t size) {
+        return get_work_group_size<kernel_name>(
+            reduction(size, scratch_t(size, *this)));
+      });
+
+  scratch_t scratch(group_size, *this);
+  auto kern = build<kernel_name>(reduction(group_size, scratch));
+  issue_enqueue(kern, &issue::enqueue_nd_range,
+                nd_range<1>(num_groups(group_size) * group_size, group_size));
+}
+
+}  // namespace sycl
+}  // namespace cl
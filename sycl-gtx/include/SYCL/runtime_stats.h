@@ -0,0 +1,132 @@
+#pragma once
+
+// Host-side runtime overhead breakdown (sycl-gtx extension)
+
+#include "SYCL/detail/common.h"
+#include <array>
+#include <chrono>
+#include <iosfwd>
+#include <map>
+
+namespace cl {
+namespace sycl {
+
+/** Host-side work the runtime does for a kernel */
+enum class runtime_phase {
+  /** Running the kernel functor to record its source */
+  trace,
+  /** Building the OpenCL C code from the recorded source */
+  codegen,
+  /** clCompileProgram, or clBuildProgram for cached binaries */
+  compile,
+  /** clLinkProgram and setting the kernel arguments up */
+  link,
+  /** command_group::optimize */
+  optimize,
+  /** Enqueueing the commands of a command group */
+  enqueue,
+  /** clFlush at the end of a command group */
+  flush
+};
+static const ::size_t runtime_phase_count = 7;
+
+struct runtime_phase_stats {
+  ::size_t count = 0;
+  std::chrono::nanoseconds total{0};
+  std::chrono::nanoseconds max{0};
+};
+
+/**
+ * Host time spent in each phase, per kernel name.
+ * Command groups are accounted to the last kernel they invoke,
+ * those without a kernel to the empty name.
+ */
+struct runtime_stats {
+  using phases = std::array<runtime_phase_stats, runtime_phase_count>;
+
+  std::map<string_class, phases> kernels;
+
+  /** The phase summed over all kernels */
+  runtime_phase_stats total(runtime_phase phase) const;
+
+  /** Writes a table with the total time of each phase per kernel */
+  void print(std::ostream& os) const;
+};
+
+namespace detail {
+
+/**
+ * Collects the runtime statistics of a queue and its copies.
+ * If the SYCL_GTX_RUNTIME_STATS environment variable is set,
+ * they are written to the standard error once the last copy is destroyed.
+ */
+class runtime_recorder {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  static const char* const environment_variable;
+
+ private:
+  mutex_class lock;
+  runtime_stats stats;
+
+ public:
+  ~runtime_recorder();
+
+  void add(const string_class& kernel, runtime_phase phase,
+           clock::duration elapsed);
+  runtime_stats get();
+
+  /**
+   * Phases measured on this thread while building a kernel,
+   * before its name is known
+   */
+  class scope {
+   private:
+    SYCL_THREAD_LOCAL static scope* current;
+
+    scope* previous;
+    std::array<clock::duration, runtime_phase_count> elapsed;
+    std::array<bool, runtime_phase_count> measured;
+
+   public:
+    scope();
+    ~scope();
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+
+    /** Adds the time to the innermost scope of the thread, if there is one */
+    static void add(runtime_phase phase, clock::duration time);
+    void commit(runtime_recorder* recorder, const string_class& kernel);
+  };
+
+  /**
+   * Measures until stopped or destroyed,
+   * accounting the time to the current scope
+   */
+  class timer {
+   private:
+    runtime_phase phase;
+    clock::time_point start;
+    bool running = true;
+
+   public:
+    explicit timer(runtime_phase phase) : phase(phase), start(clock::now()) {}
+    ~timer() {
+      stop();
+    }
+    void stop() {
+      if (running) {
+        scope::add(phase, clock::now() - start);
+        running = false;
+      }
+    }
+    timer(const timer&) = delete;
+    timer& operator=(const timer&) = delete;
+  };
+};
+
+}  // namespace detail
+
+}  // namespace sycl
+}  // namespace cl
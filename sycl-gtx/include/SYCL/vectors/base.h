@@ -44,24 +44,28 @@ class base : protected counter<base<dataT, numElements>>, public data_ref {
 
   static const int half_size = (numElements + 1) / 2;
 
-  static string_class type_name() {
-    return cl_base<dataT, numElements, 0>::type_name();
+  static const string_class& type_name() {
+    static const string_class name =
+        cl_base<dataT, numElements, 0>::type_name();
+    return name;
   }
 
-  string_class generate_name() const {
-    return '_' + type_name() + '_' +
-           get_string<counter_t>::get(this->get_count_id());
+  /** Vector literals are written as a call to (type) */
+  static const char* literal_cast() {
+    static const string_class cast = '(' + type_name() + ')';
+    return cast.c_str();
   }
 
-  string_class this_name() const {
-    return type_name() + ' ' + this->name;
+  ir::expr generate_name() const {
+    static const string_class prefix = '_' + type_name() + '_';
+    return prefix + get_string<counter_t>::get(this->get_count_id());
   }
 
  protected:
-  base(string_class assign, bool generate_new = false)
-      : data_ref(generate_new ? generate_name() : assign) {
+  base(ir::expr assign, bool generate_new = false)
+      : data_ref(generate_new ? generate_name() : std::move(assign)) {
     if (generate_new) {
-      kernel_add(this_name() + " = " + assign);
+      kernel_declare(type_name(), this->name, assign);
     }
   }
 
@@ -71,7 +75,7 @@ class base : protected counter<base<dataT, numElements>>, public data_ref {
   using vector_t = detail::cl_type<dataT, numElements>;
 
   base() : data_ref(generate_name()) {
-    kernel_add(this_name());
+    kernel_declare(type_name(), this->name);
   }
 
   base(const base& copy) : data_ref(copy.name) {}
@@ -96,28 +100,24 @@ class base : protected counter<base<dataT, numElements>>, public data_ref {
 
   template <int num = numElements>
   base(const data_ref& x, const data_ref& y, SYCL_ENABLE_IF_DIM(2))
-      : base(open_parenthesis + type_name() + ")(" + x.name + ", " + y.name +
-                 ')',
-             true) {}
+      : base(ir::expr::call(literal_cast(), {x.name, y.name}), true) {}
   template <int num = numElements>
   base(const data_ref& x, const data_ref& y, const data_ref& z,
        SYCL_ENABLE_IF_DIM(3))
-      : base(open_parenthesis + type_name() + ")(" + x.name + ", " + y.name +
-                 ", " + z.name + ')',
+      : base(ir::expr::call(literal_cast(), {x.name, y.name, z.name}),
              true) {}
   template <int num = numElements>
   base(const data_ref& x, const data_ref& y, const data_ref& z,
        const data_ref& w, SYCL_ENABLE_IF_DIM(4))
-      : base(open_parenthesis + type_name() + ")(" + x.name + ", " + y.name +
-                 ", " + z.name + ", " + w.name + ')',
+      : base(ir::expr::call(literal_cast(), {x.name, y.name, z.name, w.name}),
              true) {}
   template <int num = numElements>
   base(const data_ref& s0, const data_ref& s1, const data_ref& s2,
        const data_ref& s3, const data_ref& s4, const data_ref& s5,
        const data_ref& s6, const data_ref& s7, SYCL_ENABLE_IF_DIM(8))
-      : base(open_parenthesis + type_name() + ")(" + s0.name + ", " + s1.name +
-                 ", " + s2.name + ", " + s3.name + ", " + s4.name + ", " +
-                 s5.name + ", " + s6.name + ", " + s7.name + ')',
+      : base(ir::expr::call(literal_cast(),
+                            {s0.name, s1.name, s2.name, s3.name, s4.name,
+                             s5.name, s6.name, s7.name}),
              true) {}
   template <int num = numElements>
   base(const data_ref& s0, const data_ref& s1, const data_ref& s2,
@@ -127,12 +127,11 @@ class base : protected counter<base<dataT, numElements>>, public data_ref {
        const data_ref& sC, const data_ref& sD, const data_ref& sE,
        const data_ref& sF, const data_ref& sG, const data_ref& sH,
        SYCL_ENABLE_IF_DIM(16))
-      : base(open_parenthesis + type_name() + ")(" + s0.name + ", " + s1.name +
-                 ", " + s2.name + ", " + s3.name + ", " + s4.name + ", " +
-                 s5.name + ", " + s6.name + ", " + s7.name + ", " + s8.name +
-                 ", " + s9.name + ", " + sA.name + ", " + sB.name + ", " +
-                 sC.name + ", " + sD.name + ", " + sE.name + ", " + sF.name +
-                 ')',
+      : base(ir::expr::call(literal_cast(),
+                            {s0.name, s1.name, s2.name, s3.name, s4.name,
+                             s5.name, s6.name, s7.name, s8.name, s9.name,
+                             sA.name, sB.name, sC.name, sD.name, sE.name,
+                             sF.name}),
              true) {}
 
   operator vec<dataT, numElements>&() {
@@ -151,19 +150,20 @@ class base : protected counter<base<dataT, numElements>>, public data_ref {
     static const auto size = sizeof...(indices);
     static_assert(size > 0, "Cannot swizzle to zero elements");
 
-    // One extra for final null char
-    char access_name[size + 1];
-    swizzled<0, indices...>::get(access_name);
-    access_name[size] = 0;
+    // Two extra for the .s prefix, one for final null char
+    char access_name[size + 3] = {'.', 's'};
+    swizzled<0, indices...>::get(access_name + 2);
+    access_name[size + 2] = 0;
 
-    return swizzled_vec<dataT, size>(this->name + ".s" + access_name);
+    return swizzled_vec<dataT, size>(
+        ir::expr::member(this->name, access_name));
   }
 
   swizzled_vec<dataT, half_size> lo() const {
-    return swizzled_vec<dataT, half_size>(this->name + ".lo");
+    return swizzled_vec<dataT, half_size>(ir::expr::member(this->name, ".lo"));
   }
   swizzled_vec<dataT, half_size> hi() const {
-    return swizzled_vec<dataT, half_size>(this->name + ".hi");
+    return swizzled_vec<dataT, half_size>(ir::expr::member(this->name, ".hi"));
   }
 
 // TODO(progtx): Swizzle methods
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "SYCL/access.h"
 #include "SYCL/detail/common.h"
 #include "SYCL/vectors/cl_vec.h"
 
@@ -26,12 +27,13 @@ struct base_host_data<vec<dataT, numElements>> {
   using type = vectors::cl_base<dataT, numElements, numElements>;
 };
 
-template <typename dataT, int numElements>
-struct acc_device_return<vec<dataT, numElements>> {
+template <typename dataT, int numElements, access::mode mode>
+struct acc_device_return<vec<dataT, numElements>, mode> {
   using type = vec<dataT, numElements>;
 };
-template <typename dataT, int numElements>
-struct acc_device_return<vectors::cl_base<dataT, numElements, numElements>> {
+template <typename dataT, int numElements, access::mode mode>
+struct acc_device_return<vectors::cl_base<dataT, numElements, numElements>,
+                         mode> {
   using type = vec<dataT, numElements>;
 };
 
@@ -34,7 +34,8 @@ class vec : public detail::vectors::base<dataT, numElements>,
   using type_t = data_ref::type_t;
 
   // Helper constructor to help with assignment
-  vec(const string_class& name, bool, bool) : Base(name, true), Members(this) {}
+  vec(const detail::ir::expr& name, bool, bool)
+      : Base(name, true), Members(this) {}
 
   template <typename T>
   void assign(const T& copy) {
@@ -46,8 +47,8 @@ class vec : public detail::vectors::base<dataT, numElements>,
     Base::operator=(copy);
   }
 
-  vec(string_class name, type_t type = type_t::general)
-      : Base(name), Members(this) {
+  vec(detail::ir::expr name, type_t type = type_t::general)
+      : Base(std::move(name)), Members(this) {
     this->type = type;
   }
 
@@ -150,7 +151,8 @@ class vec<dataT, 1> : public detail::vectors::base<dataT, 1>,
   using type_t = data_ref::type_t;
 
   // Helper constructor to help with assignment
-  vec(const string_class& name, bool, bool) : Base(name, true), Members(this) {}
+  vec(const detail::ir::expr& name, bool, bool)
+      : Base(name, true), Members(this) {}
 
   template <typename T>
   vec& assign(const T& copy) {
@@ -163,8 +165,8 @@ class vec<dataT, 1> : public detail::vectors::base<dataT, 1>,
     return *this;
   }
 
-  vec(string_class name, type_t type = type_t::general)
-      : Base(name), Members(this) {
+  vec(detail::ir::expr name, type_t type = type_t::general)
+      : Base(std::move(name)), Members(this) {
     this->type = type;
   }
 
@@ -179,7 +181,7 @@ class vec<dataT, 1> : public detail::vectors::base<dataT, 1>,
   ~vec() = default;
 
   vec(const dataT& n)
-      : Base(detail::get_string<dataT>::get(n), true), Members(this) {}
+      : Base(detail::data_ref::get_name(n), true), Members(this) {}
 
   vec& operator=(const vec& copy) {
     assign(static_cast<const Base&>(copy));
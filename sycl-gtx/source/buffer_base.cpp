@@ -1,21 +1,442 @@
 #include "SYCL/buffer_base.h"
 
+#include "SYCL/detail/task_graph.h"
+#include "SYCL/memory_pool.h"
+#include "SYCL/profiler.h"
 #include "SYCL/queue.h"
 
 using namespace cl::sycl;
 using namespace detail;
 
-::cl_int buffer_base::cl_enqueue_buffer(
-    queue* q, ::size_t size, void* host_ptr,
-    const vector_class<cl_event>& wait_events, cl_event& evnt,
-    clEnqueueBuffer_f clEnqueueBuffer) {
-  auto num_events_to_wait = wait_events.size();
+void buffer_region::get_coordinates(::size_t coordinates[3]) const {
+  coordinates[0] = origin % row_pitch;
+  coordinates[1] = (origin % slice_pitch) / row_pitch;
+  coordinates[2] = origin / slice_pitch;
+}
+
+bool buffer_region::is_contiguous() const {
+  if (rows * slices == 1) {
+    return true;
+  }
+  return row_size == row_pitch &&
+         (slices == 1 || rows * row_pitch == slice_pitch);
+}
+
+bool buffer_region::overlaps(const buffer_region& other) const {
+  return origin < other.end() && other.origin < end();
+}
+
+vector_class<interval_set::interval> buffer_region::pieces() const {
+  vector_class<interval_set::interval> result;
+  if (is_contiguous()) {
+    result.emplace_back(origin, origin + size());
+    return result;
+  }
+
+  bool full_rows = (row_size == row_pitch);
+  for (::size_t z = 0; z < slices; ++z) {
+    auto slice = origin + z * slice_pitch;
+    if (full_rows) {
+      result.emplace_back(slice, slice + rows * row_pitch);
+      continue;
+    }
+    for (::size_t y = 0; y < rows; ++y) {
+      auto row = slice + y * row_pitch;
+      result.emplace_back(row, row + row_size);
+    }
+  }
+  return result;
+}
+
+buffer_region buffer_region::sub_region(const ::size_t offset[3],
+                                        const ::size_t size[3]) const {
+  buffer_region sub = *this;
+  sub.origin += offset[0] + offset[1] * row_pitch + offset[2] * slice_pitch;
+  sub.row_size = size[0];
+  sub.rows = size[1];
+  sub.slices = size[2];
+  return sub;
+}
 
-  return clEnqueueBuffer(
-      q->get(), device_data.get(), false,
-      // TODO(progtx): Sub-buffer access
-      0, size, host_ptr, static_cast<::cl_uint>(num_events_to_wait),
-      (num_events_to_wait == 0 ? nullptr : wait_events.data()), &evnt);
+buffer_base::buffer_base(const buffer_base& copy) {
+  *this = copy;
+}
+
+buffer_base::buffer_base(buffer_base&& move) noexcept {
+  *this = std::move(move);
+}
+
+buffer_base::~buffer_base() {
+  // Copies of the buffer can still be using the memory
+  if (pooled && device_data.use_count() == 1) {
+    memory_pool::recycle(device_data.get());
+  }
+  if (shared && shared.use_count() == 1 && shared->pooled) {
+    memory_pool::recycle(shared->device_data.get());
+  }
+}
+
+buffer_base& buffer_base::operator=(const buffer_base& copy) {
+  device_data = copy.device_data;
+  root = (copy.root == &copy) ? this : copy.root;
+  region = copy.region;
+  device_copy = copy.device_copy;
+  pooled = copy.pooled;
+  detached = copy.detached;
+  shared = copy.shared;
+  if (root != this) {
+    task_graph::add_sub_buffer(this);
+  }
+  return *this;
+}
+
+buffer_base& buffer_base::operator=(buffer_base&& move) noexcept {
+  device_data = std::move(move.device_data);
+  root = (move.root == &move) ? this : move.root;
+  region = move.region;
+  device_copy = move.device_copy;
+  pooled = move.pooled;
+  detached = move.detached;
+  shared = std::move(move.shared);
+  if (root != this) {
+    task_graph::add_sub_buffer(this);
+  }
+  return *this;
+}
+
+void buffer_base::init_root(::size_t element_size, const ::size_t range[3]) {
+  root = this;
+  region.origin = 0;
+  region.row_size = range[0] * element_size;
+  region.rows = range[1];
+  region.slices = range[2];
+  region.row_pitch = region.row_size;
+  region.slice_pitch = region.row_size * region.rows;
+
+  shared = std::make_shared<shared_state>();
+  shared->device_stale.add(0, region.size());
+}
+
+void buffer_base::init_sub_buffer(buffer_base& parent, ::size_t element_size,
+                                  const ::size_t offset[3],
+                                  const ::size_t range[3]) {
+  root = parent.root;
+  const ::size_t byte_offset[3] = {offset[0] * element_size, offset[1],
+                                   offset[2]};
+  const ::size_t byte_size[3] = {range[0] * element_size, range[1], range[2]};
+  region = parent.region.sub_region(byte_offset, byte_size);
+}
+
+void buffer_base::update_device_command(
+    queue* q, const vector_class<cl_event>& wait_events, event* evnt,
+    buffer_base* buffer, buffer_region accessed) {
+  auto cl_q = q->get();
+  auto& state = *buffer->root->shared;
+  std::lock_guard<std::recursive_mutex> guard(state.coherence_lock);
+  if (buffer->detached) {
+    // Kernels using the whole buffer can have written the region
+    // since it became out-of-core, the host needs their data first
+    auto downloaded =
+        buffer->transfer(cl_q, wait_events, buffer->region, false);
+    if (downloaded.get() == nullptr) {
+      *evnt = buffer->transfer_detached(cl_q, wait_events, true);
+    } else {
+      *evnt = buffer->transfer_detached(cl_q, {downloaded.get()}, true);
+    }
+    return;
+  }
+  state.last_queue = cl_q;
+
+  event written;
+  if (!state.zero_copy) {
+    written = buffer->transfer(cl_q, wait_events, accessed, true);
+  }
+  if (!buffer->device_copy) {
+    *evnt = written;
+    return;
+  }
+
+  if (written.get() == nullptr) {
+    *evnt = buffer->copy_region(cl_q, wait_events, true);
+  } else {
+    *evnt = buffer->copy_region(cl_q, {written.get()}, true);
+  }
+}
+
+void buffer_base::device_written_command(
+    queue* q, const vector_class<cl_event>& wait_events, event* evnt,
+    buffer_base* buffer, buffer_region accessed) {
+  auto& state = *buffer->root->shared;
+  std::lock_guard<std::recursive_mutex> guard(state.coherence_lock);
+  if (buffer->detached) {
+    // Downloaded right away, overlapping with the next chunk
+    *evnt = buffer->transfer_detached(q->get(), wait_events, false);
+    for (auto& piece : accessed.pieces()) {
+      state.host_stale.remove(piece.first, piece.second);
+      state.device_stale.add(piece.first, piece.second);
+    }
+    return;
+  }
+  state.last_queue = q->get();
+
+  if (buffer->device_copy) {
+    *evnt = buffer->copy_region(q->get(), wait_events, false);
+  }
+
+  for (auto& piece : accessed.pieces()) {
+    state.host_stale.add(piece.first, piece.second);
+    state.device_stale.remove(piece.first, piece.second);
+  }
+}
+
+void buffer_base::update_host(const buffer_region& accessed) {
+  auto& state = *root->shared;
+  std::lock_guard<std::recursive_mutex> guard(state.coherence_lock);
+  auto q = state.last_queue.get();
+  if (q == nullptr) {
+    // Never used on the device
+    return;
+  }
+
+  if (state.zero_copy) {
+    // Mapping synchronizes the host memory without copying it
+    release_host(map(accessed, CL_MAP_READ));
+    return;
+  }
+
+  auto evnt = transfer(q, {}, accessed, false);
+  if (evnt.get() != nullptr) {
+    evnt.wait();
+  }
+}
+
+void* buffer_base::acquire_host(access::mode mode,
+                                const buffer_region& accessed) {
+  auto& state = *root->shared;
+  std::lock_guard<std::recursive_mutex> guard(state.coherence_lock);
+  if (state.zero_copy && state.last_queue.get() != nullptr) {
+    cl_map_flags flags = CL_MAP_READ | CL_MAP_WRITE;
+    if (mode == access::mode::read) {
+      flags = CL_MAP_READ;
+    } else if (mode == access::mode::discard_write ||
+               mode == access::mode::discard_read_write) {
+      flags = CL_MAP_WRITE_INVALIDATE_REGION;
+    }
+    return map(accessed, flags);
+  }
+
+  auto pieces = accessed.pieces();
+
+  if (mode == access::mode::discard_write ||
+      mode == access::mode::discard_read_write) {
+    for (auto& piece : pieces) {
+      state.host_stale.remove(piece.first, piece.second);
+    }
+  } else {
+    update_host(accessed);
+  }
+
+  if (mode != access::mode::read) {
+    for (auto& piece : pieces) {
+      state.device_stale.add(piece.first, piece.second);
+    }
+  }
+  return nullptr;
+}
+
+void* buffer_base::map(const buffer_region& accessed, cl_map_flags flags) {
+  ::cl_int error_code;
+  cl_event evnt;
+  auto& state = *root->shared;
+  auto size = accessed.end() - accessed.origin;
+  // The host accessor keeps using the host pointer,
+  // which is where a buffer using host memory gets mapped to
+  auto mapped = clEnqueueMapBuffer(
+      state.last_queue.get(), state.device_data.get(), CL_TRUE, flags,
+      accessed.origin, size, 0, nullptr, &evnt, &error_code);
+  detail::error::report(error_code);
+  profiler::record(state.last_queue.get(), evnt, profiler_command::map, "",
+                   size);
+  clReleaseEvent(evnt);
+  return mapped;
+}
+
+void buffer_base::release_host(void* mapped) {
+  cl_event evnt;
+  auto& state = *root->shared;
+  auto error_code =
+      clEnqueueUnmapMemObject(state.last_queue.get(), state.device_data.get(),
+                              mapped, 0, nullptr, &evnt);
+  detail::error::report(error_code);
+  profiler::record(state.last_queue.get(), evnt, profiler_command::unmap);
+  // Kernels on other queues must not see the buffer mapped
+  event(evnt).wait();
+  clReleaseEvent(evnt);
+}
+
+/** Combines the events of several commands into a single one */
+static event join_events(cl_command_queue q, vector_class<cl_event>& events) {
+  if (events.empty()) {
+    return event();
+  }
+
+  cl_event evnt = events.front();
+  if (events.size() > 1) {
+    auto error_code = clEnqueueMarkerWithWaitList(
+        q, static_cast<::cl_uint>(events.size()), events.data(), &evnt);
+    detail::error::report(error_code);
+    for (auto e : events) {
+      clReleaseEvent(e);
+    }
+  }
+
+  event ret(evnt);
+  // The event object holds its own reference
+  clReleaseEvent(evnt);
+  return ret;
+}
+
+event buffer_base::transfer(cl_command_queue q,
+                            const vector_class<cl_event>& wait_events,
+                            const buffer_region& accessed, bool to_device) {
+  auto& state = *root->shared;
+  auto& stale = to_device ? state.device_stale : state.host_stale;
+
+  vector_class<interval_set::interval> parts;
+  ::size_t stale_size = 0;
+  for (auto& piece : accessed.pieces()) {
+    for (auto& part : stale.intersect(piece.first, piece.second)) {
+      stale_size += part.second - part.first;
+      parts.push_back(part);
+    }
+  }
+  if (parts.empty()) {
+    return event();
+  }
+
+  auto mem = state.device_data.get();
+  auto host = static_cast<char*>(root->host_pointer());
+  auto num_wait = static_cast<::cl_uint>(wait_events.size());
+  auto wait_list = wait_events.empty() ? nullptr : wait_events.data();
+  auto command = to_device ? profiler_command::write : profiler_command::read;
+  vector_class<cl_event> events;
+  cl_event evnt;
+  ::cl_int error_code;
+
+  if (parts.size() > 1 && stale_size == accessed.size()) {
+    // A single rectangular transfer replaces one transfer per row
+    ::size_t origin[3];
+    accessed.get_coordinates(origin);
+    const ::size_t rect[3] = {accessed.row_size, accessed.rows,
+                              accessed.slices};
+    if (to_device) {
+      error_code = clEnqueueWriteBufferRect(
+          q, mem, false, origin, origin, rect, accessed.row_pitch,
+          accessed.slice_pitch, accessed.row_pitch, accessed.slice_pitch, host,
+          num_wait, wait_list, &evnt);
+    } else {
+      error_code = clEnqueueReadBufferRect(
+          q, mem, false, origin, origin, rect, accessed.row_pitch,
+          accessed.slice_pitch, accessed.row_pitch, accessed.slice_pitch, host,
+          num_wait, wait_list, &evnt);
+    }
+    detail::error::report(error_code);
+    profiler::record(q, evnt, command, "", stale_size);
+    events.push_back(evnt);
+  } else {
+    for (auto& part : parts) {
+      auto size = part.second - part.first;
+      if (to_device) {
+        error_code =
+            clEnqueueWriteBuffer(q, mem, false, part.first, size,
+                                 host + part.first, num_wait, wait_list, &evnt);
+      } else {
+        error_code =
+            clEnqueueReadBuffer(q, mem, false, part.first, size,
+                                host + part.first, num_wait, wait_list, &evnt);
+      }
+      detail::error::report(error_code);
+      profiler::record(q, evnt, command, "", size);
+      events.push_back(evnt);
+    }
+  }
+
+  for (auto& part : parts) {
+    stale.remove(part.first, part.second);
+  }
+  return join_events(q, events);
+}
+
+event buffer_base::transfer_detached(cl_command_queue q,
+                                     const vector_class<cl_event>& wait_events,
+                                     bool to_device) {
+  ::size_t host_origin[3];
+  region.get_coordinates(host_origin);
+  const ::size_t device_origin[3] = {0, 0, 0};
+  const ::size_t rect[3] = {region.row_size, region.rows, region.slices};
+  // The device memory is compact
+  auto device_slice_pitch = region.row_size * region.rows;
+  auto host = root->host_pointer();
+
+  cl_event evnt;
+  ::cl_int error_code;
+  auto num_wait = static_cast<::cl_uint>(wait_events.size());
+  auto wait_list = wait_events.empty() ? nullptr : wait_events.data();
+  if (to_device) {
+    error_code = clEnqueueWriteBufferRect(
+        q, device_data.get(), false, device_origin, host_origin, rect,
+        region.row_size, device_slice_pitch, region.row_pitch,
+        region.slice_pitch, host, num_wait, wait_list, &evnt);
+  } else {
+    error_code = clEnqueueReadBufferRect(
+        q, device_data.get(), false, device_origin, host_origin, rect,
+        region.row_size, device_slice_pitch, region.row_pitch,
+        region.slice_pitch, host, num_wait, wait_list, &evnt);
+  }
+  detail::error::report(error_code);
+  profiler::record(
+      q, evnt, to_device ? profiler_command::write : profiler_command::read,
+      "", region.size());
+
+  event ret(evnt);
+  clReleaseEvent(evnt);
+  return ret;
+}
+
+event buffer_base::copy_region(cl_command_queue q,
+                               const vector_class<cl_event>& wait_events,
+                               bool to_copy) {
+  auto root_mem = root->shared->device_data.get();
+  auto copy_mem = device_data.get();
+
+  ::size_t root_origin[3];
+  region.get_coordinates(root_origin);
+  const ::size_t copy_origin[3] = {0, 0, 0};
+  const ::size_t rect[3] = {region.row_size, region.rows, region.slices};
+  // The copy is compact
+  auto copy_slice_pitch = region.row_size * region.rows;
+
+  cl_event evnt;
+  ::cl_int error_code;
+  auto num_wait = static_cast<::cl_uint>(wait_events.size());
+  auto wait_list = wait_events.empty() ? nullptr : wait_events.data();
+  if (to_copy) {
+    error_code = clEnqueueCopyBufferRect(
+        q, root_mem, copy_mem, root_origin, copy_origin, rect, region.row_pitch,
+        region.slice_pitch, region.row_size, copy_slice_pitch, num_wait,
+        wait_list, &evnt);
+  } else {
+    error_code = clEnqueueCopyBufferRect(
+        q, copy_mem, root_mem, copy_origin, root_origin, rect, region.row_size,
+        copy_slice_pitch, region.row_pitch, region.slice_pitch, num_wait,
+        wait_list, &evnt);
+  }
+  detail::error::report(error_code);
+  profiler::record(q, evnt, profiler_command::copy, "", region.size());
+
+  event ret(evnt);
+  clReleaseEvent(evnt);
+  return ret;
 }
 
 cl_mem buffer_base::cl_create_buffer(queue* q, const cl_mem_flags& flags,
@@ -24,3 +445,71 @@ cl_mem buffer_base::cl_create_buffer(queue* q, const cl_mem_flags& flags,
   return clCreateBuffer(q->get_context().get(), flags, size, host_ptr,
                         &error_code);
 }
+
+void buffer_base::create_root_buffer(queue* q, cl_mem_flags flags,
+                                     ::size_t size, void* host_ptr) {
+  ::cl_int error_code;
+  shared->zero_copy =
+      (host_ptr != nullptr) &&
+      q->get_device().get_info<info::device::host_unified_memory>();
+  if (shared->zero_copy) {
+    SYCL_LOG(debug, transfers) << "zero-copy buffer" << this;
+    shared->device_data = cl_create_buffer(q, flags | CL_MEM_USE_HOST_PTR,
+                                           size, host_ptr, error_code);
+  } else {
+    // Transfers copy the data explicitly,
+    // so the device memory doesn't have to be tied to the host memory
+    shared->device_data = memory_pool::allocate(q, flags, size, error_code);
+    shared->pooled = true;
+  }
+  detail::error::report(error_code);
+  shared->device_data.release_one();
+}
+
+void buffer_base::create_sub_buffer(queue* q, cl_mem_flags flags) {
+  ::cl_int error_code;
+
+  if (root->shared->out_of_core) {
+    detached = true;
+    device_data = memory_pool::allocate(q, flags, region.size(), error_code);
+    pooled = true;
+    detail::error::report(error_code);
+    device_data.release_one();
+    return;
+  }
+
+  // Reported in bits
+  ::size_t align =
+      q->get_device().get_info<info::device::mem_base_addr_align>() / 8;
+  if (align == 0) {
+    align = 1;
+  }
+
+  if (region.is_contiguous() && region.origin % align == 0) {
+    cl_buffer_region cl_region = {region.origin, region.size()};
+    device_data = clCreateSubBuffer(root->shared->device_data.get(), flags,
+                                    CL_BUFFER_CREATE_TYPE_REGION, &cl_region,
+                                    &error_code);
+    detail::error::report(error_code);
+    device_data.release_one();
+    device_copy = false;
+    return;
+  }
+
+  // Rectangular or misaligned regions get a compact copy
+  device_copy = true;
+  device_data = memory_pool::allocate(q, flags, region.size(), error_code);
+  pooled = true;
+  detail::error::report(error_code);
+  device_data.release_one();
+}
+
+void buffer_base::make_out_of_core() {
+  auto& state = *root->shared;
+  if (state.out_of_core) {
+    return;
+  }
+  task_graph::wait(this);
+  update_host();
+  state.out_of_core = true;
+}
@@ -0,0 +1,31 @@
+#include "SYCL/command_graph.h"
+
+#include "SYCL/detail/task_graph.h"
+#include "SYCL/queue.h"
+
+using namespace cl::sycl;
+
+command_graph::command_graph(queue& q) : q(&q) {}
+
+handler_event command_graph::replay() {
+  handler_event events;
+  for (auto& group : groups) {
+    if (replacements.empty()) {
+      events = detail::task_graph::submit(group);
+    } else {
+      detail::command_group rebound(group);
+      rebound.rebind(replacements);
+      events = detail::task_graph::submit(rebound);
+    }
+  }
+  return events;
+}
+
+::size_t command_graph::size() const {
+  return groups.size();
+}
+
+void command_graph::clear() {
+  groups.clear();
+  replacements.clear();
+}
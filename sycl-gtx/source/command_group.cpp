@@ -2,6 +2,7 @@
 
 #include "SYCL/accessor.h"
 #include "SYCL/buffer.h"
+#include "SYCL/detail/src_handlers/issue_command.h"
 #include "SYCL/queue.h"
 #include <map>
 #include <unordered_set>
@@ -16,9 +17,23 @@ void command_group::exit() {
   detail::command::group_detail::last = nullptr;
 }
 
+void command_group::init_buffers() {
+  for (auto& command : commands) {
+    if (command.type == detail::command::type_t::init_buffer) {
+      event evnt;
+      command.function(q, {}, &evnt);
+    }
+  }
+}
+
 // TODO(progtx): Reschedules commands to achieve better performance
 void command_group::optimize() {
   DSELF();
+  if (optimized) {
+    return;
+  }
+  optimized = true;
+  runtime_recorder::timer timing(runtime_phase::optimize);
 
   auto size_to_keep = commands.size();
   std::map<command_t*, bool> keep;
@@ -87,31 +102,151 @@ void command_group::optimize() {
   commands = std::move(saveResults);
 }
 
+void command_group::record_args() {
+  bound_args.clear();
+  bound_args.reserve(kernels.size());
+  for (auto& kern : kernels) {
+    bound_args.push_back(issue_command::get_args(kern));
+  }
+}
+
+void command_group::set_arg(::size_t index, vector_class<char> value) {
+  if (bound_args.empty()) {
+    detail::error::report(CL_INVALID_KERNEL);
+  }
+  auto& scalars = bound_args.back().scalars;
+  if (index >= scalars.size()) {
+    detail::error::report(CL_INVALID_ARG_INDEX);
+  }
+  if (value.size() != scalars[index].size()) {
+    detail::error::report(CL_INVALID_ARG_SIZE);
+  }
+  scalars[index] = std::move(value);
+}
+
+void command_group::rebind(
+    const std::map<buffer_base*, buffer_base*>& replacements) {
+  auto replace = [&replacements](buffer_base*& buf) {
+    auto it = replacements.find(buf);
+    if (it == replacements.end()) {
+      return false;
+    }
+    buf = it->second;
+    return true;
+  };
+  auto replace_all = [&replace](std::set<buffer_base*>& buffers) {
+    std::set<buffer_base*> replaced;
+    for (auto buf : buffers) {
+      replace(buf);
+      replaced.insert(buf);
+    }
+    buffers = std::move(replaced);
+  };
+
+  using detail::command::type_t;
+
+  for (auto& command : commands) {
+    if (command.type == type_t::get_accessor) {
+      replace(command.data.buf_acc.data);
+    } else if (command.type == type_t::copy_data) {
+      auto& copy = command.data.buf_copy;
+      if (replace(copy.buf.data)) {
+        command.function =
+            std::bind(copy.transfer, std::placeholders::_1,
+                      std::placeholders::_2, std::placeholders::_3,
+                      copy.buf.data, copy.region);
+      }
+    }
+  }
+  replace_all(read_buffers);
+  replace_all(write_buffers);
+  for (auto& args : bound_args) {
+    for (auto& buf : args.buffers) {
+      replace(buf);
+    }
+  }
+}
+
 /** Executes all commands in queue and removes them */
-void command_group::flush(vector_class<cl_event> wait_events) {
+event command_group::flush(vector_class<cl_event> wait_events) {
   DSELF() << q << q->get();
 
   using detail::command::type_t;
 
+  // An out-of-order queue needs explicit dependencies between the commands.
+  // Consecutive transfers are independent of each other,
+  // every other command waits on everything issued before it,
+  // and so does the first transfer after such a command.
+  auto out_of_order = q->is_out_of_order();
+  runtime_recorder::timer enqueue_timing(runtime_phase::enqueue);
+  vector_class<event> issued;
+  vector_class<cl_event> batch;
+  bool after_copy = false;
+  ::size_t kernel_index = 0;
+
   for (auto& command : commands) {
     if (command.type == type_t::get_accessor) {
       auto& acc = command.data.buf_acc;
-      auto d = debug();
-      d << command.type << acc.data << acc.mode << acc.target;
+      SYCL_LOG(trace, runtime)
+          << command.type << acc.data << acc.mode << acc.target;
     } else if (command.type == type_t::copy_data) {
       auto& copy = command.data.buf_copy;
-      auto d = debug();
-      d << command.type << copy.buf.data << copy.buf.mode << copy.buf.target
-        << copy.mode;
+      SYCL_LOG(trace, transfers) << command.type << copy.buf.data
+                                 << copy.buf.mode << copy.buf.target
+                                 << copy.mode;
     } else {
-      debug() << "command:" << command.name;
+      SYCL_LOG(trace, runtime) << "command:" << command.name;
+    }
+
+    auto is_copy = (command.type == type_t::copy_data);
+    if (out_of_order && !(is_copy && after_copy)) {
+      wait_events.insert(wait_events.end(), batch.begin(), batch.end());
+      batch.clear();
+    }
+    after_copy = is_copy;
+
+    event evnt;
+    if (command.type == type_t::kernel) {
+      // The arguments stay set on the kernel until it is enqueued
+      auto& kern = kernels[kernel_index];
+      std::lock_guard<mutex_class> guard(issue_command::get_enqueue_lock(kern));
+      if (!bound_args.empty()) {
+        issue_command::set_args(kern, bound_args[kernel_index]);
+      }
+      ++kernel_index;
+      command.function(q, wait_events, &evnt);
+      kernel_event = evnt;
+    } else {
+      command.function(q, wait_events, &evnt);
+    }
+
+    if (out_of_order && evnt.get() != nullptr) {
+      batch.push_back(evnt.get());
+      issued.push_back(std::move(evnt));
     }
-    command.function(q, wait_events);
   }
   commands.clear();
 
-  auto error = clFlush(q->get());
+  // Without a wait list the marker completes after all previous commands
+  vector_class<cl_event> marker_events;
+  if (out_of_order) {
+    marker_events = std::move(wait_events);
+    marker_events.insert(marker_events.end(), batch.begin(), batch.end());
+  }
+
+  cl_event evnt;
+  auto error = clEnqueueMarkerWithWaitList(
+      q->get(), static_cast<::cl_uint>(marker_events.size()),
+      marker_events.empty() ? nullptr : marker_events.data(), &evnt);
+  detail::error::report(error);
+  event completion(evnt);
+  clReleaseEvent(evnt);
+  enqueue_timing.stop();
+
+  runtime_recorder::timer flush_timing(runtime_phase::flush);
+  error = clFlush(q->get());
   detail::error::report(error);
+  return completion;
 }
 
 using namespace detail;
@@ -132,7 +267,8 @@ void command::group_detail::add_buffer_access(buffer_access buf_acc,
                                               string_class name) {
   last->commands.push_back({name,
                             std::bind(info::do_nothing, std::placeholders::_1,
-                                      std::placeholders::_2),
+                                      std::placeholders::_2,
+                                      std::placeholders::_3),
                             type_t::get_accessor, metadata(buf_acc)});
 
   // TODO(progtx): Maybe other targets
@@ -149,12 +285,12 @@ void command::group_detail::add_buffer_access(buffer_access buf_acc,
 
 void command::group_detail::add_buffer_copy(
     buffer_access buf_acc, access::mode copy_mode,
-    fn<buffer_base*, buffer_base::clEnqueueBuffer_f> function,
-    string_class name, buffer_base* buffer,
-    buffer_base::clEnqueueBuffer_f enqueue_function) {
+    fn<buffer_base*, buffer_region> function, string_class name,
+    buffer_base* buffer, const buffer_region& accessed) {
   last->commands.push_back(
       {name,
-       std::bind(function, std::placeholders::_1, std::placeholders::_2, buffer,
-                 enqueue_function),
-       type_t::copy_data, metadata(buffer_copy{buf_acc, copy_mode})});
+       std::bind(function, std::placeholders::_1, std::placeholders::_2,
+                 std::placeholders::_3, buffer, accessed),
+       type_t::copy_data,
+       metadata(buffer_copy{buf_acc, copy_mode, function, accessed})});
 }
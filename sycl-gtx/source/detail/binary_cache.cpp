@@ -0,0 +1,312 @@
+#include "SYCL/detail/binary_cache.h"
+
+#include "SYCL/detail/debug.h"
+#include "SYCL/detail/kernel_cache.h"
+#include "SYCL/device.h"
+#include "SYCL/error_handler.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace cl::sycl;
+using namespace detail;
+
+const char* const binary_cache::environment_variable = "SYCL_GTX_CACHE_DIR";
+
+bool binary_cache::directory_set = false;
+string_class binary_cache::directory;
+std::map<string_class, binary_cache::entry> binary_cache::imported;
+std::set<string_class> binary_cache::used_keys;
+mutex_class binary_cache::lock;
+std::atomic<unsigned int> binary_cache::temp_counter(0);
+std::atomic<::size_t> binary_cache::disk_loads(0);
+
+static const char entry_magic[] = "SYCLGTXB";
+static const char bundle_magic[] = "SYCLGTXP";
+static const ::size_t magic_size = sizeof(entry_magic) - 1;
+static const std::uint32_t format_version = 1;
+
+static long process_id() {
+#ifdef _WIN32
+  return static_cast<long>(_getpid());
+#else
+  return static_cast<long>(getpid());
+#endif
+}
+
+// FNV-1a, stable between runs and platforms
+static std::uint64_t hash(const string_class& str) {
+  std::uint64_t h = 14695981039346656037ULL;
+  for (auto c : str) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+template <class T>
+static void write_value(std::ostream& out, T value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));  // NOLINT
+}
+
+template <class T>
+static bool read_value(std::istream& in, T& value) {
+  in.read(reinterpret_cast<char*>(&value), sizeof(T));  // NOLINT
+  return static_cast<bool>(in);
+}
+
+template <class Container>
+static void write_array(std::ostream& out, const Container& data) {
+  write_value(out, static_cast<std::uint64_t>(data.size()));
+  out.write(reinterpret_cast<const char*>(data.data()),  // NOLINT
+            static_cast<std::streamsize>(data.size()));
+}
+
+static std::uint64_t remaining_bytes(std::istream& in) {
+  auto position = in.tellg();
+  in.seekg(0, std::ios::end);
+  auto end = in.tellg();
+  in.seekg(position);
+  if (!in || position < 0 || end < position) {
+    return 0;
+  }
+  return static_cast<std::uint64_t>(end - position);
+}
+
+template <class Container>
+static bool read_array(std::istream& in, Container& data) {
+  std::uint64_t size;
+  // A corrupted size must not allocate more than the file could hold
+  if (!read_value(in, size) || size > remaining_bytes(in)) {
+    return false;
+  }
+  data.resize(static_cast<::size_t>(size));
+  if (size == 0) {
+    return true;
+  }
+  // string::data() only returns a writable pointer since C++17
+  in.read(reinterpret_cast<char*>(&data[0]),  // NOLINT
+          static_cast<std::streamsize>(size));
+  return static_cast<bool>(in);
+}
+
+static void write_magic(std::ostream& out, const char* magic) {
+  out.write(magic, magic_size);
+  write_value(out, format_version);
+}
+
+static bool read_magic(std::istream& in, const char* magic) {
+  char buffer[magic_size];
+  std::uint32_t version;
+  in.read(buffer, magic_size);
+  return in && string_class(buffer, magic_size) == magic &&
+         read_value(in, version) && version == format_version;
+}
+
+static void write_entry(std::ostream& out, const string_class& key,
+                        const binary_cache::entry& e) {
+  write_array(out, key);
+  write_array(out, e.kernel_name);
+  write_value(out, static_cast<std::uint64_t>(e.binaries.size()));
+  for (auto& binary : e.binaries) {
+    write_array(out, binary);
+  }
+}
+
+static bool read_entry(std::istream& in, string_class& key,
+                       binary_cache::entry& e) {
+  std::uint64_t num_binaries;
+  if (!read_array(in, key) || !read_array(in, e.kernel_name) ||
+      !read_value(in, num_binaries) ||
+      num_binaries > remaining_bytes(in) / sizeof(std::uint64_t)) {
+    // Every binary is at least preceded by its size
+    return false;
+  }
+  e.binaries.resize(static_cast<::size_t>(num_binaries));
+  for (auto& binary : e.binaries) {
+    if (!read_array(in, binary)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void binary_cache::set_directory(string_class dir) {
+  std::lock_guard<mutex_class> guard(lock);
+  directory = std::move(dir);
+  directory_set = true;
+}
+
+string_class binary_cache::get_directory() {
+  std::lock_guard<mutex_class> guard(lock);
+  if (!directory_set) {
+    auto env = std::getenv(environment_variable);
+    if (env != nullptr) {
+      directory = env;
+    }
+    directory_set = true;
+  }
+  return directory;
+}
+
+bool binary_cache::is_enabled() {
+  return !get_directory().empty();
+}
+
+string_class binary_cache::get_key(const vector_class<device>& devices,
+                                   const string_class& options,
+                                   const string_class& code) {
+  string_class key;
+  for (auto& dev : devices) {
+    key += dev.get_info<info::device::name>() + '\n' +
+           dev.get_info<info::device::driver_version>() + '\n';
+  }
+  key += options + '\n' + kernel_cache::normalize(code);
+  return key;
+}
+
+string_class binary_cache::get_file_name(const string_class& key) {
+  std::stringstream name;
+  name << get_directory() << '/' << std::hex << std::setw(16)
+       << std::setfill('0') << hash(key) << ".bin";
+  return name.str();
+}
+
+bool binary_cache::read_file(const string_class& file_name,
+                             const string_class& key, entry& e) {
+  std::ifstream in(file_name, std::ios::binary);
+  string_class stored_key;
+  entry stored;
+  // The key is compared in full to guard against hash collisions,
+  // a damaged or foreign file is a cache miss
+  if (!in || !read_magic(in, entry_magic) ||
+      !read_entry(in, stored_key, stored) || stored_key != key) {
+    return false;
+  }
+  e = std::move(stored);
+  return true;
+}
+
+bool binary_cache::write_file(const string_class& file_name,
+                              const string_class& key, const entry& e) {
+  // Write into a unique temporary file and rename it afterwards,
+  // so readers never see a partially written entry
+  std::stringstream temp_name;
+  temp_name << file_name << ".tmp." << process_id() << '.' << temp_counter++;
+
+  {
+    std::ofstream out(temp_name.str(), std::ios::binary | std::ios::trunc);
+    if (out) {
+      write_magic(out, entry_magic);
+      write_entry(out, key, e);
+    }
+    if (!out) {
+      std::remove(temp_name.str().c_str());
+      return false;
+    }
+  }
+
+  if (std::rename(temp_name.str().c_str(), file_name.c_str()) != 0) {
+    // Another process might have been faster, which is fine
+    std::remove(temp_name.str().c_str());
+    return false;
+  }
+  return true;
+}
+
+bool binary_cache::load(const string_class& key, entry& e) {
+  {
+    std::lock_guard<mutex_class> guard(lock);
+    auto it = imported.find(key);
+    if (it != imported.end()) {
+      e = it->second;
+      used_keys.insert(key);
+      return true;
+    }
+  }
+
+  // File access doesn't need the lock
+  if (!is_enabled() || !read_file(get_file_name(key), key, e)) {
+    return false;
+  }
+  ++disk_loads;
+  std::lock_guard<mutex_class> guard(lock);
+  used_keys.insert(key);
+  return true;
+}
+
+::size_t binary_cache::get_disk_loads() {
+  return disk_loads;
+}
+
+void binary_cache::store(const string_class& key, const entry& e) {
+  if (!is_enabled()) {
+    return;
+  }
+  auto file_name = get_file_name(key);
+  if (write_file(file_name, key, e)) {
+    std::lock_guard<mutex_class> guard(lock);
+    used_keys.insert(key);
+  } else {
+    debug::warning("Unable to write binary cache file") << file_name;
+  }
+}
+
+void binary_cache::export_bundle(const string_class& file_name) {
+  std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    error::report(error::code::BINARY_CACHE_FAILURE);
+  }
+
+  std::set<string_class> keys;
+  {
+    std::lock_guard<mutex_class> guard(lock);
+    keys = used_keys;
+  }
+
+  vector_class<std::pair<string_class, entry>> entries;
+  for (auto& key : keys) {
+    entry e;
+    if (load(key, e)) {
+      entries.emplace_back(key, std::move(e));
+    }
+  }
+
+  write_magic(out, bundle_magic);
+  write_value(out, static_cast<std::uint64_t>(entries.size()));
+  for (auto& e : entries) {
+    write_entry(out, e.first, e.second);
+  }
+
+  if (!out) {
+    error::report(error::code::BINARY_CACHE_FAILURE);
+  }
+}
+
+void binary_cache::import_bundle(const string_class& file_name) {
+  std::ifstream in(file_name, std::ios::binary);
+  std::uint64_t num_entries;
+  if (!in || !read_magic(in, bundle_magic) || !read_value(in, num_entries)) {
+    error::report(error::code::BINARY_CACHE_FAILURE);
+  }
+
+  for (std::uint64_t i = 0; i < num_entries; ++i) {
+    string_class key;
+    entry e;
+    if (!read_entry(in, key, e)) {
+      error::report(error::code::BINARY_CACHE_FAILURE);
+    }
+    if (!is_enabled() || !write_file(get_file_name(key), key, e)) {
+      std::lock_guard<mutex_class> guard(lock);
+      imported[key] = std::move(e);
+    }
+  }
+}
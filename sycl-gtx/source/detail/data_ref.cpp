@@ -5,8 +5,27 @@
 using namespace cl::sycl;
 using namespace detail;
 
-void detail::kernel_add(string_class line) {
+void detail::kernel_add(const ir::expr& line) {
   kernel_ns::source::add(line);
 }
 
+void detail::kernel_assign(const ir::expr& target, const char* op,
+                           const ir::expr& value) {
+  kernel_ns::source::assign(target, op, value);
+}
+
+void detail::kernel_declare(const ir::expr& type, const ir::expr& target,
+                            const ir::expr& value) {
+  kernel_ns::source::declare(type, target, value);
+}
+
+string_class detail::kernel_add_argument(const void* address, ::size_t size,
+                                         const char* type_name) {
+  return kernel_ns::source::register_argument(address, size, type_name);
+}
+
+void detail::kernel_enable_extension(const char* name) {
+  kernel_ns::source::enable_extension(name);
+}
+
 const string_class data_ref::open_parenthesis = "(";
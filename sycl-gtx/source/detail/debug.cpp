@@ -0,0 +1,290 @@
+#include "SYCL/detail/debug.h"
+
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+using namespace cl::sycl::detail;
+using logging::category;
+using logging::level;
+
+#ifdef NDEBUG
+#define SYCL_DEFAULT_LOG_LEVEL level::warning
+#else
+#define SYCL_DEFAULT_LOG_LEVEL level::debug
+#endif
+
+std::atomic<unsigned char> logging::thresholds[logging::num_categories] = {
+    {static_cast<unsigned char>(SYCL_DEFAULT_LOG_LEVEL)},
+    {static_cast<unsigned char>(SYCL_DEFAULT_LOG_LEVEL)},
+    {static_cast<unsigned char>(SYCL_DEFAULT_LOG_LEVEL)},
+    {static_cast<unsigned char>(SYCL_DEFAULT_LOG_LEVEL)}};
+
+#undef SYCL_DEFAULT_LOG_LEVEL
+
+namespace {
+
+/**
+ * Bounded queue of lines, lock-free for any number of writers
+ * and a single reader.
+ * Each slot carries a sequence number telling whose turn it is.
+ */
+class ring {
+ private:
+  static const ::size_t capacity = 4096;
+
+  struct slot {
+    std::atomic<::size_t> sequence;
+    std::string line;
+  };
+
+  slot slots[capacity];
+  std::atomic<::size_t> tail{0};
+  /** Only used by the reader */
+  ::size_t head = 0;
+
+ public:
+  ring() {
+    for (::size_t i = 0; i < capacity; ++i) {
+      slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /** Returns false if the ring is full */
+  bool push(std::string& line) {
+    auto pos = tail.load(std::memory_order_relaxed);
+    slot* s;
+    while (true) {
+      s = &slots[pos % capacity];
+      auto sequence = s->sequence.load(std::memory_order_acquire);
+      if (sequence == pos) {
+        if (tail.compare_exchange_weak(pos, pos + 1,
+                                       std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (sequence < pos) {
+        // The reader hasn't emptied the slot yet
+        return false;
+      } else {
+        pos = tail.load(std::memory_order_relaxed);
+      }
+    }
+    s->line = std::move(line);
+    s->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(std::string& line) {
+    auto& s = slots[head % capacity];
+    if (s.sequence.load(std::memory_order_acquire) != head + 1) {
+      return false;
+    }
+    line = std::move(s.line);
+    s.line.clear();
+    s.sequence.store(head + capacity, std::memory_order_release);
+    ++head;
+    return true;
+  }
+};
+
+/**
+ * Writes the queued lines to the standard error from a background thread,
+ * started when the first line is queued
+ */
+class writer {
+ private:
+  ring lines;
+  std::atomic<::size_t> dropped{0};
+  std::atomic<bool> stopped{false};
+  /** Set when lines were queued since the thread last woke up */
+  std::atomic<bool> pending{false};
+  std::once_flag started;
+  std::thread thread;
+  /** Held by whoever is reading the ring */
+  std::mutex output;
+  std::mutex signal;
+  std::condition_variable wake;
+
+  void run() {
+    std::unique_lock<std::mutex> lock(signal);
+    while (true) {
+      wake.wait(lock, [this] { return pending.load() || stopped.load(); });
+      if (stopped.load()) {
+        return;
+      }
+      pending.store(false);
+      lock.unlock();
+      drain();
+      lock.lock();
+    }
+  }
+
+  void notify() {
+    std::lock_guard<std::mutex> guard(signal);
+    wake.notify_one();
+  }
+
+ public:
+  /** Returns whether anything was written */
+  bool drain() {
+    std::lock_guard<std::mutex> guard(output);
+    std::string batch;
+    std::string line;
+    while (lines.pop(line)) {
+      batch += line;
+      batch += '\n';
+    }
+    auto lost = dropped.exchange(0);
+    if (lost > 0) {
+      batch += "SYCL warning: " + std::to_string(lost) +
+               " log lines dropped, the log buffer was full\n";
+    }
+    if (batch.empty()) {
+      return false;
+    }
+    std::cerr << batch << std::flush;
+    return true;
+  }
+
+  void write(level l, std::string& line) {
+    if (l == level::error || stopped.load()) {
+      drain();
+      std::lock_guard<std::mutex> guard(output);
+      std::cerr << line << std::endl;
+      return;
+    }
+    std::call_once(started,
+                   [this] { thread = std::thread(&writer::run, this); });
+    if (!lines.push(line)) {
+      ++dropped;
+    }
+    if (stopped.load()) {
+      // stop() might have drained the ring before the push
+      drain();
+    } else if (!pending.exchange(true)) {
+      notify();
+    }
+  }
+
+  void stop() {
+    stopped.store(true);
+    notify();
+    if (thread.joinable()) {
+      thread.join();
+    }
+    drain();
+  }
+};
+
+/** Never destroyed, lines can be written during static destruction */
+writer& get_writer() {
+  static writer* w = new writer();
+  return *w;
+}
+
+/** Stops the writer thread at exit, later lines are written directly */
+struct shutdown {
+  shutdown() {
+    auto config = std::getenv("SYCL_GTX_LOG");
+    if (config != nullptr) {
+      logging::configure(config);
+    }
+    get_writer();
+  }
+  ~shutdown() {
+    get_writer().stop();
+  }
+} at_exit;
+
+level parse_level(const std::string& name, bool& valid) {
+  static const char* const names[] = {"off",  "error", "warning",
+                                      "info", "debug", "trace"};
+  for (unsigned char i = 0; i < 6; ++i) {
+    if (name == names[i]) {
+      valid = true;
+      return static_cast<level>(i);
+    }
+  }
+  valid = false;
+  return level::off;
+}
+
+bool parse_category(const std::string& name, category& c) {
+  static const char* const names[] = {"runtime", "codegen", "transfers",
+                                      "sync"};
+  for (unsigned char i = 0; i < logging::num_categories; ++i) {
+    if (name == names[i]) {
+      c = static_cast<category>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+void logging::set_level(level l, category c) {
+  thresholds[static_cast<int>(c)].store(static_cast<unsigned char>(l),
+                                        std::memory_order_relaxed);
+}
+
+void logging::set_level(level l) {
+  for (int i = 0; i < num_categories; ++i) {
+    set_level(l, static_cast<category>(i));
+  }
+}
+
+void logging::configure(const std::string& config) {
+  // Entries separated by ';', each one "level" or "level:category,category"
+  ::size_t begin = 0;
+  while (begin <= config.size()) {
+    auto end = config.find(';', begin);
+    if (end == std::string::npos) {
+      end = config.size();
+    }
+    auto entry = config.substr(begin, end - begin);
+    begin = end + 1;
+    if (entry.empty()) {
+      continue;
+    }
+
+    auto colon = entry.find(':');
+    bool valid;
+    auto l = parse_level(entry.substr(0, colon), valid);
+    if (!valid) {
+      debug::warning("Unknown log level in") << entry;
+      continue;
+    }
+    if (colon == std::string::npos) {
+      set_level(l);
+      continue;
+    }
+
+    auto categories = entry.substr(colon + 1);
+    ::size_t pos = 0;
+    while (pos <= categories.size()) {
+      auto comma = categories.find(',', pos);
+      if (comma == std::string::npos) {
+        comma = categories.size();
+      }
+      category c;
+      auto name = categories.substr(pos, comma - pos);
+      if (parse_category(name, c)) {
+        set_level(l, c);
+      } else {
+        debug::warning("Unknown log category") << name;
+      }
+      pos = comma + 1;
+    }
+  }
+}
+
+void logging::write(level l, std::string line) {
+  get_writer().write(l, line);
+}
+
+void logging::flush() {
+  get_writer().drain();
+}
@@ -0,0 +1,19 @@
+#include "SYCL/detail/group_size.h"
+
+#include "SYCL/device.h"
+#include "SYCL/info.h"
+
+using namespace cl::sycl;
+
+::size_t detail::power_of_two_group_size(const device& dev, ::size_t max_size,
+                                         ::size_t bytes_per_item,
+                                         ::size_t fixed_bytes) {
+  auto local_memory =
+      static_cast<::size_t>(dev.get_info<info::device::local_mem_size>());
+  ::size_t size = 1;
+  while (size * 2 <= max_size &&
+         fixed_bytes + size * 2 * bytes_per_item <= local_memory) {
+    size *= 2;
+  }
+  return size;
+}
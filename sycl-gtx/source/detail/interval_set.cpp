@@ -0,0 +1,65 @@
+#include "SYCL/detail/interval_set.h"
+
+#include <algorithm>
+#include <iterator>
+
+using namespace cl::sycl;
+using namespace detail;
+
+void interval_set::add(::size_t begin, ::size_t end) {
+  if (begin >= end) {
+    return;
+  }
+
+  // First interval that could touch [begin, end)
+  auto it = intervals.upper_bound(begin);
+  if (it != intervals.begin() && std::prev(it)->second >= begin) {
+    --it;
+  }
+
+  while (it != intervals.end() && it->first <= end) {
+    begin = std::min(begin, it->first);
+    end = std::max(end, it->second);
+    it = intervals.erase(it);
+  }
+  intervals.emplace(begin, end);
+}
+
+void interval_set::remove(::size_t begin, ::size_t end) {
+  if (begin >= end) {
+    return;
+  }
+
+  auto it = intervals.upper_bound(begin);
+  if (it != intervals.begin() && std::prev(it)->second > begin) {
+    --it;
+  }
+
+  while (it != intervals.end() && it->first < end) {
+    auto first = it->first;
+    auto last = it->second;
+    it = intervals.erase(it);
+    // Keep the parts sticking out on either side
+    if (first < begin) {
+      intervals.emplace(first, begin);
+    }
+    if (last > end) {
+      intervals.emplace(end, last);
+    }
+  }
+}
+
+vector_class<interval_set::interval> interval_set::intersect(
+    ::size_t begin, ::size_t end) const {
+  vector_class<interval> result;
+
+  auto it = intervals.upper_bound(begin);
+  if (it != intervals.begin() && std::prev(it)->second > begin) {
+    --it;
+  }
+
+  for (; it != intervals.end() && it->first < end; ++it) {
+    result.emplace_back(std::max(begin, it->first), std::min(end, it->second));
+  }
+  return result;
+}
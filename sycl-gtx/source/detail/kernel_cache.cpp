@@ -0,0 +1,148 @@
+#include "SYCL/detail/kernel_cache.h"
+
+#include "SYCL/context.h"
+#include "SYCL/detail/counter.h"
+#include "SYCL/device.h"
+#include <cctype>
+
+using namespace cl::sycl;
+using namespace detail;
+
+kernel_cache::entry_list kernel_cache::entries;
+std::unordered_map<string_class, kernel_cache::entry_list::iterator>
+    kernel_cache::index;
+::size_t kernel_cache::capacity = kernel_cache::default_capacity;
+mutex_class kernel_cache::lock;
+
+static bool is_name_char(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+/**
+ * Generated names have the form _prefix_N or _sycl_bufN,
+ * where N comes from a counter and differs between traces
+ */
+static bool split_generated_name(const string_class& name,
+                                 string_class& prefix) {
+  static const string_class resource_root = "_sycl_buf";
+
+  if (name.size() < 3 || name[0] != '_' ||
+      !std::isdigit(static_cast<unsigned char>(name.back()))) {
+    return false;
+  }
+
+  auto end = name.find_last_not_of("0123456789");
+  prefix = name.substr(0, end + 1);
+  return prefix.back() == '_' || prefix == resource_root;
+}
+
+string_class kernel_cache::normalize(const string_class& code) {
+  string_class normalized;
+  normalized.reserve(code.size());
+
+  std::unordered_map<string_class, string_class> renamed;
+  counter_t next_id = 0;
+  string_class prefix;
+
+  ::size_t i = 0;
+  while (i < code.size()) {
+    if (!is_name_char(code[i])) {
+      normalized += code[i];
+      ++i;
+      continue;
+    }
+
+    auto start = i;
+    while (i < code.size() && is_name_char(code[i])) {
+      ++i;
+    }
+    auto name = code.substr(start, i - start);
+
+    if (!split_generated_name(name, prefix)) {
+      // Keywords, built-in functions, literals
+      normalized += name;
+      continue;
+    }
+
+    auto it = renamed.find(name);
+    if (it == renamed.end()) {
+      it = renamed
+               .emplace(name, prefix + get_string<counter_t>::get(next_id++))
+               .first;
+    }
+    normalized += it->second;
+  }
+
+  return normalized;
+}
+
+string_class kernel_cache::get_key(const context& ctx,
+                                   const vector_class<device>& devices,
+                                   const string_class& options,
+                                   const string_class& code) {
+  std::stringstream key;
+  key << ctx.get();
+  for (auto& dev : devices) {
+    key << ' ' << dev.get();
+  }
+  key << '\n' << options << '\n' << normalize(code);
+  return key.str();
+}
+
+bool kernel_cache::find(const string_class& key, entry& cached) {
+  std::lock_guard<mutex_class> guard(lock);
+  auto it = index.find(key);
+  if (it == index.end()) {
+    return false;
+  }
+  entries.splice(entries.begin(), entries, it->second);
+  cached = it->second->second;
+  return true;
+}
+
+void kernel_cache::insert(const string_class& key, entry cached) {
+  std::lock_guard<mutex_class> guard(lock);
+  if (capacity == 0) {
+    return;
+  }
+
+  auto it = index.find(key);
+  if (it != index.end()) {
+    it->second->second = std::move(cached);
+    entries.splice(entries.begin(), entries, it->second);
+    return;
+  }
+
+  entries.emplace_front(key, std::move(cached));
+  index.emplace(key, entries.begin());
+  trim();
+}
+
+void kernel_cache::trim() {
+  while (entries.size() > capacity) {
+    index.erase(entries.back().first);
+    entries.pop_back();
+  }
+}
+
+void kernel_cache::set_capacity(::size_t max_entries) {
+  std::lock_guard<mutex_class> guard(lock);
+  capacity = max_entries;
+  trim();
+}
+
+::size_t kernel_cache::get_capacity() {
+  std::lock_guard<mutex_class> guard(lock);
+  return capacity;
+}
+
+::size_t kernel_cache::size() {
+  std::lock_guard<mutex_class> guard(lock);
+  return entries.size();
+}
+
+void kernel_cache::clear() {
+  std::lock_guard<mutex_class> guard(lock);
+  index.clear();
+  entries.clear();
+}
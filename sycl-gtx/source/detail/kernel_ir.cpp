@@ -0,0 +1,356 @@
+#include "SYCL/detail/kernel_ir.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace cl::sycl;
+using namespace detail::ir;
+
+const ::size_t arena::block_size;
+SYCL_THREAD_LOCAL arena* arena::current = nullptr;
+
+namespace {
+
+/** Verbatim code can take addresses or dereference pointers */
+unsigned char text_flags(const char* code, ::size_t length) {
+  unsigned char flags = 0;
+  for (::size_t i = 0; i < length; ++i) {
+    if (code[i] == '[') {
+      flags |= node::memory;
+    } else if (code[i] == '(' && i > 0) {
+      if (code[i - 1] == '*') {
+        flags |= node::memory;
+      } else if (code[i - 1] == '&') {
+        flags |= node::side_effects | node::memory;
+      }
+    }
+  }
+  return flags;
+}
+
+bool is_text(const node* n) {
+  return n->kind == node::kind_t::text;
+}
+
+}  // namespace
+
+void* arena::allocate(::size_t size) {
+  static const ::size_t alignment = alignof(node);
+  size = (size + alignment - 1) & ~(alignment - 1);
+  if (size > available) {
+    auto block = std::max(size, block_size);
+    blocks.emplace_back(new char[block]);
+    next = blocks.back().get();
+    available = block;
+  }
+  auto ptr = next;
+  next += size;
+  available -= size;
+  used += size;
+  return ptr;
+}
+
+const node* arena::text(const char* code, ::size_t length) {
+  auto n = static_cast<node*>(allocate(sizeof(node) + length));
+  auto copy = reinterpret_cast<char*>(n + 1);
+  std::memcpy(copy, code, length);
+  *n = {node::kind_t::text, text_flags(code, length),
+        static_cast<unsigned>(length), copy, nullptr, nullptr};
+  return n;
+}
+
+const node* arena::join(const node* left, const node* right) {
+  auto length = left->length + right->length;
+  auto n = static_cast<node*>(allocate(sizeof(node) + length));
+  auto copy = reinterpret_cast<char*>(n + 1);
+  std::memcpy(copy, left->str, left->length);
+  std::memcpy(copy + left->length, right->str, right->length);
+  *n = {node::kind_t::text, text_flags(copy, length), length, copy, nullptr,
+        nullptr};
+  return n;
+}
+
+const node* arena::literal(const char* code, ::size_t length) {
+  auto n = static_cast<node*>(allocate(sizeof(node)));
+  *n = {node::kind_t::text, text_flags(code, length),
+        static_cast<unsigned>(length), code, nullptr, nullptr};
+  return n;
+}
+
+const node* arena::make(node::kind_t kind, const char* op, const node* left,
+                        const node* right, unsigned char flags) {
+  if (left != nullptr) {
+    flags |= left->flags;
+  }
+  if (right != nullptr) {
+    flags |= right->flags;
+  }
+  if ((kind == node::kind_t::prefix || kind == node::kind_t::postfix) &&
+      (op[0] == '+' || op[0] == '-')) {
+    flags |= node::side_effects;
+  } else if (kind == node::kind_t::subscript) {
+    flags |= node::memory;
+  }
+  auto n = static_cast<node*>(allocate(sizeof(node)));
+  *n = {kind, flags, 0, op, left, right};
+  return n;
+}
+
+expr::expr(const string_class& code) {
+  if (arena::current != nullptr) {
+    n = arena::current->text(code.data(), code.size());
+  } else {
+    host = code;
+  }
+}
+
+expr::expr(const char* code) {
+  if (arena::current != nullptr) {
+    n = arena::current->text(code, std::strlen(code));
+  } else {
+    host = code;
+  }
+}
+
+const node* expr::get() const {
+  // The node cannot be kept, the expression can outlive the arena
+  if (n != nullptr || arena::current == nullptr) {
+    return n;
+  }
+  return arena::current->text(host.data(), host.size());
+}
+
+bool expr::empty() const {
+  if (n == nullptr) {
+    return host.empty();
+  }
+  return n->kind == node::kind_t::text && n->length == 0;
+}
+
+string_class expr::str() const {
+  if (n == nullptr) {
+    return host;
+  }
+  string_class code;
+  write(n, code);
+  return code;
+}
+
+expr expr::binary(const char* op, const expr& lhs, const expr& rhs) {
+  if (arena::current == nullptr) {
+    return expr(string_class("(") + lhs.str() + ' ' + op + ' ' + rhs.str() +
+                ')');
+  }
+  return arena::current->make(node::kind_t::binary, op, lhs.get(), rhs.get());
+}
+
+expr expr::prefix(const char* op, const expr& operand) {
+  if (arena::current == nullptr) {
+    return expr(string_class("(") + op + operand.str() + ')');
+  }
+  return arena::current->make(node::kind_t::prefix, op, operand.get());
+}
+
+expr expr::postfix(const char* op, const expr& operand) {
+  if (arena::current == nullptr) {
+    return expr(string_class("(") + operand.str() + op + ')');
+  }
+  return arena::current->make(node::kind_t::postfix, op, operand.get());
+}
+
+expr expr::character(char c) {
+  static char characters[256];
+  static const bool filled = [] {
+    for (int i = 0; i < 256; ++i) {
+      characters[i] = static_cast<char>(i);
+    }
+    return true;
+  }();
+  (void)filled;
+
+  if (arena::current == nullptr) {
+    return expr(string_class(1, c));
+  }
+  return arena::current->literal(&characters[static_cast<unsigned char>(c)],
+                                 1);
+}
+
+expr expr::call(const char* function, std::initializer_list<expr> arguments,
+                unsigned char flags) {
+  if (arena::current == nullptr) {
+    string_class code = string_class(function) + '(';
+    for (auto& argument : arguments) {
+      if (&argument != arguments.begin()) {
+        code += ", ";
+      }
+      code += argument.str();
+    }
+    return expr(code + ')');
+  }
+  const node* chain = nullptr;
+  for (auto it = arguments.end(); it != arguments.begin();) {
+    --it;
+    chain = arena::current->make(node::kind_t::argument, nullptr, it->get(),
+                                 chain);
+  }
+  return arena::current->make(node::kind_t::call, function, chain, nullptr,
+                              flags);
+}
+
+expr expr::subscript(const expr& array, const expr& index) {
+  if (arena::current == nullptr) {
+    return expr(array.str() + '[' + index.str() + ']');
+  }
+  return arena::current->make(node::kind_t::subscript, nullptr, array.get(),
+                              index.get());
+}
+
+expr expr::member(const expr& object, const char* field) {
+  if (arena::current == nullptr) {
+    return expr(object.str() + field);
+  }
+  return arena::current->make(node::kind_t::member, nullptr, object.get(),
+                              expr(field).get());
+}
+
+namespace cl {
+namespace sycl {
+namespace detail {
+namespace ir {
+
+expr operator+(const expr& lhs, const expr& rhs) {
+  if (arena::current == nullptr) {
+    return expr(lhs.str() + rhs.str());
+  }
+  if (lhs.empty()) {
+    return rhs.get();
+  }
+  if (rhs.empty()) {
+    return lhs.get();
+  }
+  auto left = lhs.get();
+  auto right = rhs.get();
+  if (is_text(left) && is_text(right)) {
+    // Keeps names assembled from pieces recognizable, e.g. _sycl_gid0
+    return arena::current->join(left, right);
+  }
+  return arena::current->make(node::kind_t::concat, nullptr, left, right);
+}
+
+}  // namespace ir
+}  // namespace detail
+}  // namespace sycl
+}  // namespace cl
+
+namespace {
+
+void write_node(const node* n, string_class& out) {
+  if (n == nullptr) {
+    return;
+  }
+  switch (n->kind) {
+    case node::kind_t::text:
+      out.append(n->str, n->length);
+      break;
+    case node::kind_t::concat:
+      write_node(n->left, out);
+      write_node(n->right, out);
+      break;
+    case node::kind_t::binary:
+      out += '(';
+      write_node(n->left, out);
+      out += ' ';
+      out += n->str;
+      out += ' ';
+      write_node(n->right, out);
+      out += ')';
+      break;
+    case node::kind_t::prefix:
+      out += '(';
+      out += n->str;
+      write_node(n->left, out);
+      out += ')';
+      break;
+    case node::kind_t::postfix:
+      out += '(';
+      write_node(n->left, out);
+      out += n->str;
+      out += ')';
+      break;
+    case node::kind_t::call:
+      out += n->str;
+      out += '(';
+      write_node(n->left, out);
+      out += ')';
+      break;
+    case node::kind_t::argument:
+      write_node(n->left, out);
+      if (n->right != nullptr) {
+        out += ", ";
+        write_node(n->right, out);
+      }
+      break;
+    case node::kind_t::subscript:
+      write_node(n->left, out);
+      out += '[';
+      write_node(n->right, out);
+      out += ']';
+      break;
+    case node::kind_t::member:
+      write_node(n->left, out);
+      write_node(n->right, out);
+      break;
+  }
+}
+
+void write_statement(const statement& s, string_class& out) {
+  out.append(s.depth, '\t');
+  switch (s.kind) {
+    case statement::kind_t::plain:
+      write_node(s.value, out);
+      out += ';';
+      break;
+    case statement::kind_t::control:
+      write_node(s.value, out);
+      out += ' ';
+      break;
+    case statement::kind_t::open_block:
+      out += "{ ";
+      break;
+    case statement::kind_t::close_block:
+      out += "} ";
+      break;
+    case statement::kind_t::assign:
+      write_node(s.target, out);
+      out += ' ';
+      out += s.op;
+      out += ' ';
+      write_node(s.value, out);
+      out += ';';
+      break;
+    case statement::kind_t::declare:
+      write_node(s.type, out);
+      out += ' ';
+      write_node(s.target, out);
+      if (s.value != nullptr) {
+        out += " = ";
+        write_node(s.value, out);
+      }
+      out += ';';
+      break;
+  }
+}
+
+}  // namespace
+
+void detail::ir::write(const node* n, string_class& out) {
+  write_node(n, out);
+}
+
+void detail::ir::write(const vector_class<statement>& statements,
+                       string_class& out) {
+  for (auto& s : statements) {
+    write_statement(s, out);
+    out += '\n';
+  }
+}
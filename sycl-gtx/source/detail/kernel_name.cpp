@@ -1,6 +1,33 @@
 #include "SYCL/detail/kernel_name.h"
 
+#if defined(__GNUC__) || defined(__clang__)
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
 using namespace cl::sycl;
 using namespace detail;
 
-::size_t kernel_name::current_count = 0;
+std::atomic<::size_t> kernel_name::current_count(0);
+
+string_class kernel_name::demangle_pointee(const char* name) {
+  // MSVC names are readable already
+  string_class result(name);
+#if defined(__GNUC__) || defined(__clang__)
+  int status = 0;
+  auto demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+  if (status == 0 && demangled != nullptr) {
+    result = demangled;
+    std::free(demangled);
+  }
+#endif
+  // Drops the pointer, "name*" or "class name * __ptr64"
+  auto star = result.rfind('*');
+  if (star != string_class::npos) {
+    result.erase(star);
+    while (!result.empty() && result.back() == ' ') {
+      result.pop_back();
+    }
+  }
+  return result;
+}
@@ -0,0 +1,1361 @@
+#include "SYCL/detail/kernel_passes.h"
+
+#include "SYCL/kernel_optimizer.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace cl::sycl;
+using namespace detail::ir;
+using detail::get_string;
+
+namespace {
+
+using kind_t = node::kind_t;
+using statement_kind = statement::kind_t;
+using name_set = std::set<string_class>;
+
+/** OpenCL C type of a value, unknown for anything but numbers */
+struct value_type {
+  enum class base_t : unsigned char {
+    unknown,
+    char_t,
+    uchar_t,
+    short_t,
+    ushort_t,
+    int_t,
+    uint_t,
+    long_t,
+    ulong_t,
+    float_t,
+    double_t,
+  };
+
+  base_t base;
+  unsigned char width;
+
+  value_type(base_t base = base_t::unknown, unsigned char width = 1)
+      : base(base), width(width) {}
+
+  bool known() const {
+    return base != base_t::unknown;
+  }
+  bool is_floating() const {
+    return base == base_t::float_t || base == base_t::double_t;
+  }
+  bool is_unsigned() const {
+    return base == base_t::uchar_t || base == base_t::ushort_t ||
+           base == base_t::uint_t || base == base_t::ulong_t;
+  }
+  /** Conversion order of the scalar types */
+  int rank() const {
+    return (static_cast<int>(base) + 1) / 2;
+  }
+
+  bool operator==(const value_type& other) const {
+    return base == other.base && width == other.width;
+  }
+  bool operator!=(const value_type& other) const {
+    return !(*this == other);
+  }
+
+  string_class name() const;
+  /** Also accepts a const qualifier */
+  static value_type parse(string_class name);
+};
+
+const char* const base_names[] = {"",     "char", "uchar", "short",
+                                  "ushort", "int",  "uint",  "long",
+                                  "ulong",  "float", "double"};
+const int num_bases = 11;
+
+string_class value_type::name() const {
+  string_class n = base_names[static_cast<int>(base)];
+  if (width > 1) {
+    n += get_string<int>::get(width);
+  }
+  return n;
+}
+
+value_type value_type::parse(string_class name) {
+  static const string_class qualifier = "const ";
+  while (name.compare(0, qualifier.size(), qualifier) == 0) {
+    name.erase(0, qualifier.size());
+  }
+  for (int b = 1; b < num_bases; ++b) {
+    auto length = std::strlen(base_names[b]);
+    if (name.compare(0, length, base_names[b]) != 0) {
+      continue;
+    }
+    auto rest = name.substr(length);
+    if (rest.empty()) {
+      return {static_cast<base_t>(b)};
+    }
+    for (int width : {2, 3, 4, 8, 16}) {
+      if (rest == get_string<int>::get(width)) {
+        return {static_cast<base_t>(b), static_cast<unsigned char>(width)};
+      }
+    }
+  }
+  return {};
+}
+
+using base_t = value_type::base_t;
+
+/** Integer promotion of scalars */
+value_type promote(value_type t) {
+  if (t.known() && t.rank() < value_type(base_t::int_t).rank()) {
+    return {base_t::int_t};
+  }
+  return t;
+}
+
+/** Usual arithmetic conversions, a scalar converts to the other vector */
+value_type arithmetic(value_type a, value_type b) {
+  if (!a.known() || !b.known()) {
+    return {};
+  }
+  if (a.width > 1 || b.width > 1) {
+    if (a.width > 1 && b.width > 1 && a != b) {
+      return {};
+    }
+    return a.width > 1 ? a : b;
+  }
+  a = promote(a);
+  b = promote(b);
+  if (a.base == base_t::double_t || b.base == base_t::double_t) {
+    return {base_t::double_t};
+  }
+  if (a.base == base_t::float_t || b.base == base_t::float_t) {
+    return {base_t::float_t};
+  }
+  if (a == b) {
+    return a;
+  }
+  if (a.is_unsigned() == b.is_unsigned()) {
+    return a.rank() > b.rank() ? a : b;
+  }
+  auto u = a.is_unsigned() ? a : b;
+  auto s = a.is_unsigned() ? b : a;
+  return u.rank() >= s.rank() ? u : s;
+}
+
+/** Scalar comparisons give an int, vector ones a signed integer vector */
+value_type relational(value_type a, value_type b) {
+  if (!a.known() || !b.known() ||
+      (a.width > 1 && b.width > 1 && a.width != b.width)) {
+    return {};
+  }
+  auto v = a.width > 1 ? a : b;
+  if (v.width == 1) {
+    return {base_t::int_t};
+  }
+  switch (v.base) {
+    case base_t::char_t:
+    case base_t::uchar_t:
+      return {base_t::char_t, v.width};
+    case base_t::short_t:
+    case base_t::ushort_t:
+      return {base_t::short_t, v.width};
+    case base_t::long_t:
+    case base_t::ulong_t:
+    case base_t::double_t:
+      return {base_t::long_t, v.width};
+    default:
+      return {base_t::int_t, v.width};
+  }
+}
+
+bool is_one_of(const char* op, std::initializer_list<const char*> ops) {
+  for (auto o : ops) {
+    if (std::strcmp(op, o) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool is_relational(const char* op) {
+  return is_one_of(op, {"==", "!=", "<", "<=", ">", ">=", "&&", "||"});
+}
+
+string_class text_of(const node* n) {
+  return string_class(n->str, n->length);
+}
+
+bool is_identifier_start(char c) {
+  return c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+bool is_identifier_char(char c) {
+  return is_identifier_start(c) || (c >= '0' && c <= '9');
+}
+
+bool is_identifier(const node* n) {
+  if (n == nullptr || n->kind != kind_t::text || n->length == 0 ||
+      !is_identifier_start(n->str[0])) {
+    return false;
+  }
+  for (unsigned i = 1; i < n->length; ++i) {
+    if (!is_identifier_char(n->str[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool is_int_literal(const node* n, long long& value) {
+  if (n == nullptr || n->kind != kind_t::text || n->length == 0 ||
+      n->length > 11) {
+    return false;
+  }
+  unsigned i = n->str[0] == '-' ? 1 : 0;
+  if (i == n->length || (n->str[i] == '0' && n->length > i + 1)) {
+    // A leading zero would make it octal
+    return false;
+  }
+  for (unsigned j = i; j < n->length; ++j) {
+    if (n->str[j] < '0' || n->str[j] > '9') {
+      return false;
+    }
+  }
+  value = std::strtoll(text_of(n).c_str(), nullptr, 10);
+  return value >= INT_MIN && value <= INT_MAX;
+}
+
+bool is_float_literal(const node* n, float& value) {
+  if (n == nullptr || n->kind != kind_t::text || n->length < 2 ||
+      n->str[n->length - 1] != 'f') {
+    return false;
+  }
+  auto code = string_class(n->str, n->length - 1);
+  if (code.find_first_of(".e") == string_class::npos ||
+      code.find_first_not_of("0123456789.e+-") != string_class::npos) {
+    return false;
+  }
+  char* end;
+  value = std::strtof(code.c_str(), &end);
+  return *end == '\0' && std::isfinite(value);
+}
+
+bool is_jump(const node* n) {
+  if (n == nullptr || n->kind != kind_t::text) {
+    return false;
+  }
+  auto code = text_of(n);
+  return code == "break" || code == "continue" || code == "return";
+}
+
+/** Statements within a block, executed one after the other */
+bool is_straight(const statement& s) {
+  return s.kind == statement_kind::plain || s.kind == statement_kind::assign ||
+         s.kind == statement_kind::declare;
+}
+
+bool has_side_effects(const statement& s) {
+  for (auto n : {s.target, s.value}) {
+    if (n != nullptr && (n->flags & node::side_effects) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/** The variable written through a target, e.g. v for v.s0 */
+const node* root_of(const node* target) {
+  while (target != nullptr && target->kind == kind_t::member) {
+    target = target->left;
+  }
+  return is_identifier(target) ? target : nullptr;
+}
+
+/** Adds the identifiers in the code, not counting fields or literal suffixes */
+void collect_names(const node* n, name_set& names,
+                   std::unordered_set<const node*>& visited) {
+  if (n == nullptr || !visited.insert(n).second) {
+    return;
+  }
+  if (n->kind != kind_t::text) {
+    collect_names(n->left, names, visited);
+    collect_names(n->right, names, visited);
+    return;
+  }
+  for (unsigned i = 0; i < n->length;) {
+    auto after_name = i > 0 && (is_identifier_char(n->str[i - 1]) ||
+                                n->str[i - 1] == '.');
+    if (!is_identifier_start(n->str[i]) || after_name) {
+      ++i;
+      continue;
+    }
+    auto begin = i;
+    while (i < n->length && is_identifier_char(n->str[i])) {
+      ++i;
+    }
+    names.emplace(n->str + begin, i - begin);
+  }
+}
+
+name_set names_in(const node* n) {
+  name_set names;
+  std::unordered_set<const node*> visited;
+  collect_names(n, names, visited);
+  return names;
+}
+
+bool intersects(const name_set& a, const name_set& b) {
+  for (auto& name : a) {
+    if (b.count(name) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/** What a statement can change */
+struct effects {
+  name_set variables;
+  bool memory = false;
+  /** Could change anything, e.g. verbatim code */
+  bool unknown = false;
+
+  void add_target(const node* target) {
+    auto root = root_of(target);
+    if (root != nullptr) {
+      variables.insert(text_of(root));
+    } else if (target != nullptr && target->kind == kind_t::subscript) {
+      memory = true;
+    } else {
+      unknown = true;
+    }
+  }
+
+  void add(const node* n) {
+    if (n == nullptr || (n->flags & node::side_effects) == 0) {
+      return;
+    }
+    switch (n->kind) {
+      case kind_t::text:
+        unknown = true;
+        return;
+      case kind_t::prefix:
+      case kind_t::postfix:
+        if (n->str[0] == '+' || n->str[0] == '-') {
+          add_target(n->left);
+        }
+        break;
+      case kind_t::call:
+        memory = true;
+        break;
+      default:
+        break;
+    }
+    add(n->left);
+    add(n->right);
+  }
+
+  void add(const statement& s) {
+    switch (s.kind) {
+      case statement_kind::plain:
+        if (s.value != nullptr && s.value->kind == kind_t::call) {
+          memory = true;
+        } else if (!is_jump(s.value)) {
+          unknown = true;
+        }
+        break;
+      case statement_kind::assign:
+        add_target(s.target);
+        add(s.target);
+        break;
+      case statement_kind::declare:
+        add_target(s.target);
+        break;
+      default:
+        break;
+    }
+    add(s.value);
+  }
+
+  /** Whether a value reading the names could change */
+  bool changes(const name_set& names, bool reads_memory) const {
+    return unknown || (reads_memory && memory) || intersects(names, variables);
+  }
+};
+
+class optimizer {
+ private:
+  using rewrite_map = std::unordered_map<const node*, const node*>;
+
+  /** Expression that can be computed once and used more than once */
+  struct common {
+    int id;
+    const node* value;
+    name_set reads;
+    bool memory;
+    /** Statements between the first and the last use */
+    ::size_t first;
+    ::size_t last;
+    unsigned uses;
+    /** Variable holding the value */
+    const node* name;
+    /** The value already has a variable, declared by the first statement */
+    bool declared;
+  };
+
+  vector_class<statement>& statements;
+  arena& nodes;
+  std::map<string_class, value_type> variables;
+  /** Element types of buffers */
+  std::map<string_class, value_type> arrays;
+  /** Variables changed after their declaration or accessed through pointers */
+  name_set changed;
+  /** Variables named by verbatim code with side effects, e.g. &(x) */
+  name_set escaped;
+  std::unordered_map<const node*, value_type> types;
+  /** Equal expressions have the same id */
+  std::unordered_map<const node*, int> ids;
+  std::map<string_class, int> id_keys;
+  std::unordered_map<const node*, ::size_t> sizes;
+  unsigned temporaries = 0;
+
+  void collect_escaped(const node* n) {
+    if (n == nullptr || (n->flags & node::side_effects) == 0) {
+      return;
+    }
+    if (n->kind == kind_t::text) {
+      auto names = names_in(n);
+      escaped.insert(names.begin(), names.end());
+    }
+    collect_escaped(n->left);
+    collect_escaped(n->right);
+  }
+
+  const node* text(const string_class& code) {
+    return nodes.text(code.data(), code.size());
+  }
+  const node* rebuild(const node* n, const node* left, const node* right) {
+    if (left == n->left && right == n->right) {
+      return n;
+    }
+    return nodes.make(n->kind, n->str, left, right, n->flags);
+  }
+  const node* int_literal(long long value) {
+    return text(get_string<long long>::get(value));
+  }
+  const node* float_literal(float value);
+
+  value_type type_of(const node* n);
+  value_type type_of_call(const node* n);
+  value_type type_of_member(const node* n);
+  int id(const node* n);
+  ::size_t size(const node* n);
+
+  /** Integer divisions by zero are undefined, they cannot be speculated */
+  bool may_trap(const node* n);
+
+  const node* fold(const node* n, rewrite_map& folded,
+                   const std::map<string_class, const node*>& constants);
+  const node* compute(const char* op, const node* left, const node* right);
+  const node* compute(const char* op, long long a, long long b);
+  const node* compute(const char* op, float a, float b);
+
+  const node* hoist(const node* n, const effects& loop, unsigned depth,
+                    std::map<int, const node*>& hoisted,
+                    vector_class<statement>& declarations, rewrite_map& memo);
+
+  const node* declare_temporary(const char* prefix, const node* value,
+                                unsigned depth,
+                                vector_class<statement>& declarations);
+  bool is_common(const node* n);
+  void count(const node* n, ::size_t i, bool guarded,
+             vector_class<common>& found, std::map<int, ::size_t>& available);
+  ::size_t eliminate_common_subexpressions(::size_t begin, ::size_t end);
+  const node* replace(const node* n, const std::map<int, const node*>& names,
+                      rewrite_map& memo);
+
+  void collect_reads(const statement& s, name_set& names);
+
+  /** Applies the function to each expression the statement reads */
+  template <class F>
+  void rewrite_reads(statement& s, F f) {
+    s.value = f(s.value);
+    if (s.kind != statement_kind::assign) {
+      return;
+    }
+    const node* path[8];
+    int length = 0;
+    auto target = s.target;
+    while (target->kind == kind_t::member && length < 8) {
+      path[length++] = target;
+      target = target->left;
+    }
+    if (target->kind == kind_t::subscript) {
+      target = rebuild(target, target->left, f(target->right));
+    }
+    while (length > 0) {
+      auto m = path[--length];
+      target = rebuild(m, target, m->right);
+    }
+    s.target = target;
+  }
+
+  void propagate_copies();
+  void remove_dead_stores();
+  void remove_unused_variables();
+
+ public:
+  optimizer(vector_class<statement>& statements, arena& nodes,
+            const std::map<string_class, string_class>& names);
+
+  void fold_constants();
+  void hoist_invariants();
+  void eliminate_common_subexpressions();
+  void eliminate_dead_code();
+};
+
+optimizer::optimizer(vector_class<statement>& statements, arena& nodes,
+                     const std::map<string_class, string_class>& names)
+    : statements(statements), nodes(nodes) {
+  for (auto& n : names) {
+    auto& type = n.second;
+    if (!type.empty() && type.back() == '*') {
+      arrays[n.first] = value_type::parse(type.substr(0, type.size() - 1));
+    } else {
+      variables[n.first] = value_type::parse(type);
+    }
+  }
+
+  for (auto& s : statements) {
+    if (s.kind == statement_kind::declare && is_identifier(s.target)) {
+      string_class type;
+      write(s.type, type);
+      variables[text_of(s.target)] = value_type::parse(type);
+    }
+    if (s.kind == statement_kind::assign) {
+      auto root = root_of(s.target);
+      if (root != nullptr) {
+        changed.insert(text_of(root));
+      }
+    }
+    effects e;
+    e.add(s.target);
+    e.add(s.value);
+    changed.insert(e.variables.begin(), e.variables.end());
+    collect_escaped(s.target);
+    collect_escaped(s.value);
+  }
+  changed.insert(escaped.begin(), escaped.end());
+}
+
+const node* optimizer::float_literal(float value) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+  string_class code = buffer;
+  if (code.find_first_of(".e") == string_class::npos) {
+    code += '.';
+  }
+  return text(code + 'f');
+}
+
+value_type optimizer::type_of(const node* n) {
+  if (n == nullptr) {
+    return {};
+  }
+  auto it = types.find(n);
+  if (it != types.end()) {
+    return it->second;
+  }
+
+  value_type t;
+  long long i;
+  float f;
+  switch (n->kind) {
+    case kind_t::text:
+      if (is_identifier(n)) {
+        auto v = variables.find(text_of(n));
+        if (v != variables.end()) {
+          t = v->second;
+        }
+      } else if (is_int_literal(n, i)) {
+        t = {base_t::int_t};
+      } else if (is_float_literal(n, f)) {
+        t = {base_t::float_t};
+      }
+      break;
+    case kind_t::binary: {
+      auto l = type_of(n->left);
+      auto r = type_of(n->right);
+      if (is_relational(n->str)) {
+        t = relational(l, r);
+      } else if (is_one_of(n->str, {"<<", ">>"})) {
+        t = l.width > 1 ? l : promote(l);
+      } else {
+        t = arithmetic(l, r);
+      }
+      if ((t.is_floating() || l.is_floating() || r.is_floating()) &&
+          is_one_of(n->str, {"%", "&", "|", "^", "<<", ">>"})) {
+        t = {};
+      }
+      break;
+    }
+    case kind_t::prefix:
+      t = type_of(n->left);
+      if (std::strcmp(n->str, "!") == 0) {
+        t = relational(t, t);
+      }
+      break;
+    case kind_t::postfix:
+      t = type_of(n->left);
+      break;
+    case kind_t::call:
+      t = type_of_call(n);
+      break;
+    case kind_t::subscript:
+      if (is_identifier(n->left)) {
+        auto a = arrays.find(text_of(n->left));
+        if (a != arrays.end()) {
+          t = a->second;
+        }
+      }
+      break;
+    case kind_t::member:
+      t = type_of_member(n);
+      break;
+    default:
+      break;
+  }
+  types[n] = t;
+  return t;
+}
+
+value_type optimizer::type_of_call(const node* n) {
+  string_class function = n->str;
+  if (function.size() > 2 && function.front() == '(' &&
+      function.back() == ')') {
+    // Vector literal
+    return value_type::parse(function.substr(1, function.size() - 2));
+  }
+
+  vector_class<value_type> arguments;
+  for (auto a = n->left; a != nullptr; a = a->right) {
+    arguments.push_back(type_of(a->left));
+  }
+  if (arguments.size() == 1 &&
+      (function == "cos" || function == "sin" || function == "sqrt" ||
+       function == "fabs") &&
+      arguments[0].is_floating()) {
+    return arguments[0];
+  }
+  if (arguments.size() == 2 && arguments[0].known() &&
+      arguments[1].known()) {
+    auto& a = arguments[0];
+    auto& b = arguments[1];
+    if (function == "pow" && a.is_floating() && a == b) {
+      return a;
+    }
+    if (function == "min" && a.base == b.base &&
+        (a.width == b.width || b.width == 1)) {
+      return a;
+    }
+  }
+  return {};
+}
+
+value_type optimizer::type_of_member(const node* n) {
+  auto object = type_of(n->left);
+  if (!object.known() || object.width == 1) {
+    return {};
+  }
+  auto field = text_of(n->right);
+  if (field == ".lo" || field == ".hi") {
+    return {object.base, static_cast<unsigned char>(
+                             object.width == 3 ? 2 : object.width / 2)};
+  }
+  if (field.size() < 3 || field.compare(0, 2, ".s") != 0) {
+    return {};
+  }
+  auto elements = field.size() - 2;
+  if (elements != 1 && elements != 2 && elements != 3 && elements != 4 &&
+      elements != 8 && elements != 16) {
+    return {};
+  }
+  return {object.base, static_cast<unsigned char>(elements)};
+}
+
+int optimizer::id(const node* n) {
+  if (n == nullptr) {
+    return 0;
+  }
+  auto it = ids.find(n);
+  if (it != ids.end()) {
+    return it->second;
+  }
+
+  string_class key(1, static_cast<char>(n->kind));
+  if (n->kind == kind_t::text) {
+    key.append(n->str, n->length);
+  } else {
+    if (n->str != nullptr) {
+      key += n->str;
+    }
+    key += '\n' + get_string<int>::get(id(n->left)) + ',' +
+           get_string<int>::get(id(n->right));
+  }
+  auto inserted = id_keys.emplace(key, static_cast<int>(id_keys.size()) + 1);
+  auto result = inserted.first->second;
+  ids[n] = result;
+  return result;
+}
+
+::size_t optimizer::size(const node* n) {
+  if (n == nullptr) {
+    return 0;
+  }
+  auto it = sizes.find(n);
+  if (it != sizes.end()) {
+    return it->second;
+  }
+  auto result = 1 + size(n->left) + size(n->right);
+  sizes[n] = result;
+  return result;
+}
+
+bool optimizer::may_trap(const node* n) {
+  if (n == nullptr || n->kind == kind_t::text) {
+    return false;
+  }
+  if (n->kind == kind_t::binary && is_one_of(n->str, {"/", "%"}) &&
+      !type_of(n).is_floating()) {
+    return true;
+  }
+  return may_trap(n->left) || may_trap(n->right);
+}
+
+const node* optimizer::compute(const char* op, long long a, long long b) {
+  long long r;
+  if (is_one_of(op, {"+"})) {
+    r = a + b;
+  } else if (is_one_of(op, {"-"})) {
+    r = a - b;
+  } else if (is_one_of(op, {"*"})) {
+    r = a * b;
+  } else if (is_one_of(op, {"/", "%"})) {
+    if (b == 0 || (a == INT_MIN && b == -1)) {
+      return nullptr;
+    }
+    r = op[0] == '/' ? a / b : a % b;
+  } else if (is_one_of(op, {"<<", ">>"})) {
+    if (a < 0 || b < 0 || b > 31) {
+      return nullptr;
+    }
+    r = op[0] == '<' ? a << b : a >> b;
+  } else if (is_one_of(op, {"&"})) {
+    r = a & b;
+  } else if (is_one_of(op, {"|"})) {
+    r = a | b;
+  } else if (is_one_of(op, {"^"})) {
+    r = a ^ b;
+  } else if (is_one_of(op, {"=="})) {
+    r = a == b;
+  } else if (is_one_of(op, {"!="})) {
+    r = a != b;
+  } else if (is_one_of(op, {"<"})) {
+    r = a < b;
+  } else if (is_one_of(op, {"<="})) {
+    r = a <= b;
+  } else if (is_one_of(op, {">"})) {
+    r = a > b;
+  } else if (is_one_of(op, {">="})) {
+    r = a >= b;
+  } else if (is_one_of(op, {"&&"})) {
+    r = a != 0 && b != 0;
+  } else if (is_one_of(op, {"||"})) {
+    r = a != 0 || b != 0;
+  } else {
+    return nullptr;
+  }
+  if (r < INT_MIN || r > INT_MAX) {
+    // Signed overflow is undefined, the device may do anything
+    return nullptr;
+  }
+  return int_literal(r);
+}
+
+const node* optimizer::compute(const char* op, float a, float b) {
+  if (is_relational(op)) {
+    long long r;
+    if (is_one_of(op, {"=="})) {
+      r = a == b;
+    } else if (is_one_of(op, {"!="})) {
+      r = a != b;
+    } else if (is_one_of(op, {"<"})) {
+      r = a < b;
+    } else if (is_one_of(op, {"<="})) {
+      r = a <= b;
+    } else if (is_one_of(op, {">"})) {
+      r = a > b;
+    } else if (is_one_of(op, {">="})) {
+      r = a >= b;
+    } else if (is_one_of(op, {"&&"})) {
+      r = a != 0 && b != 0;
+    } else {
+      r = a != 0 || b != 0;
+    }
+    return int_literal(r);
+  }
+
+  volatile float r;
+  if (is_one_of(op, {"+"})) {
+    r = a + b;
+  } else if (is_one_of(op, {"-"})) {
+    r = a - b;
+  } else if (is_one_of(op, {"*"})) {
+    r = a * b;
+  } else if (is_one_of(op, {"/"}) && b != 0) {
+    r = a / b;
+  } else {
+    return nullptr;
+  }
+  // Devices may flush denormals to zero
+  if (std::fpclassify(r) != FP_NORMAL && r != 0) {
+    return nullptr;
+  }
+  return float_literal(r);
+}
+
+const node* optimizer::compute(const char* op, const node* left,
+                               const node* right) {
+  long long a, b;
+  float x, y;
+  bool int_a = is_int_literal(left, a);
+  bool int_b = is_int_literal(right, b);
+  if (int_a && int_b) {
+    return compute(op, a, b);
+  }
+  if ((!int_a && !is_float_literal(left, x)) ||
+      (!int_b && !is_float_literal(right, y))) {
+    return nullptr;
+  }
+  if (int_a) {
+    x = static_cast<float>(a);
+  }
+  if (int_b) {
+    y = static_cast<float>(b);
+  }
+  return compute(op, x, y);
+}
+
+const node* optimizer::fold(
+    const node* n, rewrite_map& folded,
+    const std::map<string_class, const node*>& constants) {
+  if (n == nullptr) {
+    return n;
+  }
+  auto it = folded.find(n);
+  if (it != folded.end()) {
+    return it->second;
+  }
+
+  auto result = n;
+  if (n->kind == kind_t::text) {
+    if (is_identifier(n)) {
+      auto c = constants.find(text_of(n));
+      if (c != constants.end()) {
+        result = c->second;
+      }
+    }
+  } else {
+    auto left = fold(n->left, folded, constants);
+    auto right = fold(n->right, folded, constants);
+    long long i;
+    float f;
+    if (n->kind == kind_t::binary) {
+      result = compute(n->str, left, right);
+    } else if (n->kind == kind_t::prefix && std::strcmp(n->str, "!") == 0) {
+      if (is_int_literal(left, i)) {
+        result = int_literal(i == 0);
+      } else if (is_float_literal(left, f)) {
+        result = int_literal(f == 0);
+      } else {
+        result = nullptr;
+      }
+    } else {
+      result = nullptr;
+    }
+    if (result == nullptr) {
+      result = rebuild(n, left, right);
+    }
+  }
+  folded[n] = result;
+  return result;
+}
+
+void optimizer::fold_constants() {
+  rewrite_map folded;
+  // Scalars initialized with a literal and never changed
+  std::map<string_class, const node*> constants;
+  for (auto& s : statements) {
+    s.value = fold(s.value, folded, constants);
+    if (s.kind == statement_kind::assign) {
+      s.target = fold(s.target, folded, constants);
+    }
+
+    if (s.kind != statement_kind::declare || !is_identifier(s.target) ||
+        s.value == nullptr) {
+      continue;
+    }
+    auto name = text_of(s.target);
+    auto type = variables[name];
+    long long i;
+    float f;
+    if (changed.count(name) != 0 || type.width != 1) {
+      continue;
+    }
+    if (type.base == base_t::int_t && is_int_literal(s.value, i)) {
+      constants[name] = s.value;
+    } else if (type.base == base_t::float_t) {
+      if (is_float_literal(s.value, f)) {
+        constants[name] = s.value;
+      } else if (is_int_literal(s.value, i)) {
+        constants[name] = float_literal(static_cast<float>(i));
+      }
+    }
+  }
+}
+
+const node* optimizer::declare_temporary(
+    const char* prefix, const node* value, unsigned depth,
+    vector_class<statement>& declarations) {
+  auto type = type_of(value);
+  auto name = prefix + get_string<unsigned>::get(++temporaries);
+  variables[name] = type;
+  auto target = text(name);
+  declarations.push_back({statement_kind::declare, depth, nullptr,
+                          text(type.name()), target, value});
+  return target;
+}
+
+const node* optimizer::hoist(const node* n, const effects& loop,
+                             unsigned depth,
+                             std::map<int, const node*>& hoisted,
+                             vector_class<statement>& declarations,
+                             rewrite_map& memo) {
+  if (n == nullptr || n->kind == kind_t::text) {
+    return n;
+  }
+  auto it = memo.find(n);
+  if (it != memo.end()) {
+    return it->second;
+  }
+
+  const node* result;
+  if ((n->kind == kind_t::binary || n->kind == kind_t::call) &&
+      (n->flags & (node::side_effects | node::memory)) == 0 &&
+      type_of(n).known() && !may_trap(n) &&
+      !loop.changes(names_in(n), false)) {
+    auto& name = hoisted[id(n)];
+    if (name == nullptr) {
+      name = declare_temporary("_sycl_inv", n, depth, declarations);
+    }
+    result = name;
+  } else {
+    result = rebuild(
+        n, hoist(n->left, loop, depth, hoisted, declarations, memo),
+        hoist(n->right, loop, depth, hoisted, declarations, memo));
+  }
+  memo[n] = result;
+  return result;
+}
+
+void optimizer::hoist_invariants() {
+  for (::size_t head = 0; head + 1 < statements.size(); ++head) {
+    auto& loop = statements[head];
+    if (loop.kind != statement_kind::control || loop.op == nullptr ||
+        !is_one_of(loop.op, {"for", "while"}) ||
+        statements[head + 1].kind != statement_kind::open_block) {
+      continue;
+    }
+    auto depth = statements[head + 1].depth;
+    auto end = head + 2;
+    while (end < statements.size() &&
+           (statements[end].kind != statement_kind::close_block ||
+            statements[end].depth != depth)) {
+      ++end;
+    }
+
+    effects changes;
+    for (auto i = head; i < end; ++i) {
+      changes.add(statements[i]);
+    }
+    if (changes.unknown) {
+      continue;
+    }
+
+    std::map<int, const node*> hoisted;
+    vector_class<statement> declarations;
+    rewrite_map memo;
+    for (auto i = head; i < end; ++i) {
+      rewrite_reads(statements[i], [&](const node* n) {
+        return hoist(n, changes, depth, hoisted, declarations, memo);
+      });
+    }
+    statements.insert(statements.begin() + head, declarations.begin(),
+                      declarations.end());
+    head += declarations.size();
+  }
+}
+
+bool optimizer::is_common(const node* n) {
+  return (n->kind == kind_t::binary || n->kind == kind_t::call ||
+          n->kind == kind_t::subscript) &&
+         (n->flags & node::side_effects) == 0 && type_of(n).known();
+}
+
+void optimizer::count(const node* n, ::size_t i, bool guarded,
+                      vector_class<common>& found,
+                      std::map<int, ::size_t>& available) {
+  if (n == nullptr || n->kind == kind_t::text) {
+    return;
+  }
+  if (is_common(n)) {
+    auto k = id(n);
+    auto it = available.find(k);
+    if (it != available.end()) {
+      auto& c = found[it->second];
+      ++c.uses;
+      c.last = i;
+      return;
+    }
+    // Only computed if the left side of && or || allows it
+    if (!guarded || ((n->flags & node::memory) == 0 && !may_trap(n))) {
+      found.push_back({k, n, names_in(n), (n->flags & node::memory) != 0, i,
+                       i, 1, nullptr, false});
+      available[k] = found.size() - 1;
+    }
+  }
+  auto conditional =
+      n->kind == kind_t::binary && is_one_of(n->str, {"&&", "||"});
+  count(n->left, i, guarded, found, available);
+  count(n->right, i, guarded || conditional, found, available);
+}
+
+const node* optimizer::replace(const node* n,
+                               const std::map<int, const node*>& names,
+                               rewrite_map& memo) {
+  if (n == nullptr || n->kind == kind_t::text) {
+    return n;
+  }
+  auto it = memo.find(n);
+  if (it != memo.end()) {
+    return it->second;
+  }
+  auto name = names.find(id(n));
+  auto result = name != names.end()
+                    ? name->second
+                    : rebuild(n, replace(n->left, names, memo),
+                              replace(n->right, names, memo));
+  memo[n] = result;
+  return result;
+}
+
+::size_t optimizer::eliminate_common_subexpressions(::size_t begin,
+                                                    ::size_t end) {
+  vector_class<common> found;
+  std::map<int, ::size_t> available;
+
+  for (auto i = begin; i < end; ++i) {
+    auto& s = statements[i];
+    effects e;
+    e.add(s);
+    if (e.unknown || has_side_effects(s)) {
+      available.clear();
+      continue;
+    }
+
+    count(s.value, i, false, found, available);
+    if (s.kind == statement_kind::assign) {
+      auto target = s.target;
+      while (target->kind == kind_t::member) {
+        target = target->left;
+      }
+      if (target->kind == kind_t::subscript) {
+        count(target->right, i, false, found, available);
+      }
+    }
+
+    for (auto it = available.begin(); it != available.end();) {
+      auto& c = found[it->second];
+      if (e.changes(c.reads, c.memory)) {
+        it = available.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    // A variable that never changes can stand for its initial value
+    if (s.kind == statement_kind::declare && s.value != nullptr &&
+        is_identifier(s.target) && changed.count(text_of(s.target)) == 0) {
+      auto it = available.find(id(s.value));
+      if (it != available.end()) {
+        auto& c = found[it->second];
+        if (c.first == i && c.uses == 1 &&
+            variables[text_of(s.target)] == type_of(s.value)) {
+          c.name = s.target;
+          c.declared = true;
+        }
+      }
+    }
+  }
+
+  vector_class<common*> named;
+  for (auto& c : found) {
+    if (c.uses > 1) {
+      named.push_back(&c);
+    }
+  }
+  if (named.empty()) {
+    return 0;
+  }
+  // Smaller values first, so that larger ones can use them
+  std::stable_sort(named.begin(), named.end(), [this](common* a, common* b) {
+    return size(a->value) < size(b->value);
+  });
+
+  vector_class<statement> block;
+  for (auto i = begin; i < end; ++i) {
+    auto& s = statements[i];
+    std::map<int, const node*> names;
+    for (auto c : named) {
+      if (c->name != nullptr && c->first <= i && i <= c->last &&
+          (c->first < i || !c->declared)) {
+        names[c->id] = c->name;
+      }
+    }
+    for (auto c : named) {
+      if (c->first != i || c->declared) {
+        continue;
+      }
+      rewrite_map memo;
+      auto value = rebuild(c->value, replace(c->value->left, names, memo),
+                           replace(c->value->right, names, memo));
+      c->name = declare_temporary("_sycl_cse", value, s.depth, block);
+      names[c->id] = c->name;
+    }
+    rewrite_map memo;
+    rewrite_reads(s, [&](const node* n) { return replace(n, names, memo); });
+    block.push_back(s);
+  }
+
+  auto inserted = block.size() - (end - begin);
+  statements.erase(statements.begin() + begin, statements.begin() + end);
+  statements.insert(statements.begin() + begin, block.begin(), block.end());
+  return inserted;
+}
+
+void optimizer::eliminate_common_subexpressions() {
+  ::size_t begin = 0;
+  while (begin < statements.size()) {
+    if (!is_straight(statements[begin])) {
+      ++begin;
+      continue;
+    }
+    auto end = begin;
+    while (end < statements.size() && is_straight(statements[end])) {
+      ++end;
+    }
+    begin = end + eliminate_common_subexpressions(begin, end);
+  }
+}
+
+void optimizer::collect_reads(const statement& s, name_set& names) {
+  std::unordered_set<const node*> visited;
+  collect_names(s.value, names, visited);
+  if (s.kind != statement_kind::assign) {
+    return;
+  }
+  auto root = root_of(s.target);
+  if (root == nullptr || std::strcmp(s.op, "=") != 0) {
+    collect_names(s.target, names, visited);
+  }
+}
+
+void optimizer::propagate_copies() {
+  // Copies of variables that never change, e.g. vector temporaries
+  std::map<string_class, const node*> copies;
+  for (auto& s : statements) {
+    if (s.kind != statement_kind::declare || !is_identifier(s.target) ||
+        !is_identifier(s.value)) {
+      continue;
+    }
+    auto copy = text_of(s.target);
+    auto source = s.value;
+    auto known = copies.find(text_of(source));
+    if (known != copies.end()) {
+      source = known->second;
+    }
+    auto original = text_of(source);
+    auto type = variables[copy];
+    if (changed.count(copy) == 0 && changed.count(original) == 0 &&
+        type.known() && variables.count(original) != 0 &&
+        variables[original] == type) {
+      copies[copy] = source;
+    }
+  }
+  if (copies.empty()) {
+    return;
+  }
+
+  rewrite_map memo;
+  std::function<const node*(const node*)> substitute = [&](const node* n) {
+    if (n == nullptr) {
+      return n;
+    }
+    auto it = memo.find(n);
+    if (it != memo.end()) {
+      return it->second;
+    }
+    auto result = n;
+    if (n->kind != kind_t::text) {
+      result = rebuild(n, substitute(n->left), substitute(n->right));
+    } else if (is_identifier(n)) {
+      auto c = copies.find(text_of(n));
+      if (c != copies.end()) {
+        result = c->second;
+      }
+    }
+    memo[n] = result;
+    return result;
+  };
+  for (auto& s : statements) {
+    rewrite_reads(s, substitute);
+  }
+}
+
+void optimizer::remove_dead_stores() {
+  // Values overwritten within the same block before being read
+  vector_class<bool> dead(statements.size(), false);
+  for (::size_t i = 0; i < statements.size(); ++i) {
+    auto& s = statements[i];
+    bool store = s.kind == statement_kind::assign &&
+                 std::strcmp(s.op, "=") == 0 && is_identifier(s.target);
+    bool initial = s.kind == statement_kind::declare && s.value != nullptr &&
+                   is_identifier(s.target);
+    if ((!store && !initial) || has_side_effects(s)) {
+      continue;
+    }
+    auto name = text_of(s.target);
+    if (escaped.count(name) != 0) {
+      continue;
+    }
+    for (auto j = i + 1; j < statements.size(); ++j) {
+      auto& next = statements[j];
+      if (!is_straight(next) || next.kind == statement_kind::plain) {
+        break;
+      }
+      name_set reads;
+      collect_reads(next, reads);
+      if (reads.count(name) != 0) {
+        break;
+      }
+      if (next.kind == statement_kind::assign &&
+          std::strcmp(next.op, "=") == 0 && is_identifier(next.target) &&
+          text_of(next.target) == name) {
+        if (store) {
+          dead[i] = true;
+        } else {
+          s.value = nullptr;
+        }
+        break;
+      }
+    }
+  }
+
+  ::size_t kept = 0;
+  for (::size_t i = 0; i < statements.size(); ++i) {
+    if (!dead[i]) {
+      statements[kept++] = statements[i];
+    }
+  }
+  statements.resize(kept);
+}
+
+void optimizer::remove_unused_variables() {
+  bool removed = true;
+  while (removed) {
+    removed = false;
+    name_set reads;
+    for (auto& s : statements) {
+      collect_reads(s, reads);
+    }
+
+    name_set unused;
+    for (auto& s : statements) {
+      if (s.kind == statement_kind::declare && is_identifier(s.target) &&
+          reads.count(text_of(s.target)) == 0) {
+        unused.insert(text_of(s.target));
+      }
+    }
+    // Values with side effects have to be computed anyway
+    for (auto& s : statements) {
+      auto root = root_of(s.target);
+      if (root != nullptr && has_side_effects(s)) {
+        unused.erase(text_of(root));
+      }
+    }
+    if (unused.empty()) {
+      break;
+    }
+
+    ::size_t kept = 0;
+    for (auto& s : statements) {
+      auto root = root_of(s.target);
+      if ((s.kind == statement_kind::declare ||
+           s.kind == statement_kind::assign) &&
+          root != nullptr && unused.count(text_of(root)) != 0) {
+        removed = true;
+        continue;
+      }
+      statements[kept++] = s;
+    }
+    statements.resize(kept);
+  }
+}
+
+void optimizer::eliminate_dead_code() {
+  propagate_copies();
+  remove_dead_stores();
+  remove_unused_variables();
+}
+
+bool enabled(unsigned passes, kernel_pass pass) {
+  return (passes & (1u << static_cast<unsigned>(pass))) != 0;
+}
+
+}  // namespace
+
+void detail::ir::optimize(vector_class<statement>& statements, arena& nodes,
+                          const std::map<string_class, string_class>& names,
+                          unsigned passes) {
+  if (passes == 0 || statements.empty()) {
+    return;
+  }
+  optimizer o(statements, nodes, names);
+  if (enabled(passes, kernel_pass::constant_folding)) {
+    o.fold_constants();
+  }
+  if (enabled(passes, kernel_pass::loop_invariants)) {
+    o.hoist_invariants();
+  }
+  if (enabled(passes, kernel_pass::common_subexpressions)) {
+    o.eliminate_common_subexpressions();
+  }
+  if (enabled(passes, kernel_pass::dead_code)) {
+    o.eliminate_dead_code();
+  }
+}
@@ -3,11 +3,14 @@
 #include "SYCL/accessors/buffer.h"
 #include "SYCL/buffer.h"
 #include "SYCL/kernel.h"
+#include <cstdint>
 
 using namespace cl::sycl;
 using detail::issue_command;
 using namespace detail::kernel_ns;
 
+mutex_class issue_command::enqueue_locks[issue_command::num_enqueue_locks];
+
 // TODO(progtx):
 void issue_command::compile_command(queue* q,
                                     const vector_class<cl_event>& wait_events,
@@ -15,7 +18,7 @@ void issue_command::compile_command(queue* q,
 }
 
 void issue_command::prepare_kernel(shared_ptr_class<kernel> kern) {
-  DSELF() << kern->src.kernel_name;
+  SYCL_LOG(trace, runtime) << __func__ << kern->src.kernel_name;
   auto k = kern->get();
   ::cl_int error_code;
   int i = 0;
@@ -23,12 +26,22 @@ void issue_command::prepare_kernel(shared_ptr_class<kernel> kern) {
     if (acc.second.acc.target == access::target::local) {
       error_code = clSetKernelArg(k, i, acc.second.size, nullptr);
     } else {
-      auto mem = acc.second.acc.data->device_data.get();
+      auto mem = acc.second.acc.data->get_device_data();
       error_code = clSetKernelArg(k, i, acc.second.size, &mem);
     }
     detail::error::report(error_code);
     ++i;
   }
+  for (auto& arg : kern->src.captured_args) {
+    error_code = clSetKernelArg(k, i, arg.value.size(), arg.value.data());
+    detail::error::report(error_code);
+    ++i;
+  }
+  for (auto& arg : kern->src.indexed_args) {
+    error_code = clSetKernelArg(k, static_cast<::cl_uint>(arg.first),
+                                arg.second.size(), arg.second.data());
+    detail::error::report(error_code);
+  }
 }
 
 void issue_command::write_buffers_to_device(shared_ptr_class<kernel> kern) {
@@ -41,34 +54,73 @@ void issue_command::write_buffers_to_device(shared_ptr_class<kernel> kern) {
       continue;
     }
     command::group_detail::add_buffer_copy(
-        acc.second.acc, access::mode::write, buffer_base::enqueue_command,
-        __func__, acc.second.acc.data, &clEnqueueWriteBuffer);
+        acc.second.acc, access::mode::write,
+        buffer_base::update_device_command, __func__, acc.second.acc.data,
+        acc.second.region);
   }
 }
 
 void issue_command::enqueue_task_command(
-    queue* q, const vector_class<cl_event>& wait_events,
-    shared_ptr_class<kernel> kern, event* evnt) {
+    queue* q, const vector_class<cl_event>& wait_events, event* evnt,
+    shared_ptr_class<kernel> kern) {
   prepare_kernel(kern);
   kern->enqueue_task(q, wait_events, evnt);
 }
 
-void issue_command::enqueue_task(shared_ptr_class<kernel> kern, event* evnt) {
+void issue_command::enqueue_task(shared_ptr_class<kernel> kern) {
   command::group_detail::add_kernel_enqueue_task(enqueue_task_command, __func__,
-                                                 kern, evnt);
+                                                 kern);
+}
+
+void issue_command::set_indexed_args(shared_ptr_class<kernel> kern,
+                                     std::map<int, vector_class<char>> args) {
+  kern->src.indexed_args = std::move(args);
+}
+
+detail::kernel_args issue_command::get_args(shared_ptr_class<kernel> kern) {
+  detail::kernel_args args;
+  args.scalars.reserve(kern->src.captured_args.size());
+  for (auto& arg : kern->src.captured_args) {
+    args.scalars.push_back(arg.value);
+  }
+  args.buffers.reserve(kern->src.resources.size());
+  for (auto& acc : kern->src.resources) {
+    args.buffers.push_back(acc.second.acc.data);
+  }
+  return args;
+}
+
+void issue_command::set_args(shared_ptr_class<kernel> kern,
+                             const detail::kernel_args& args) {
+  auto scalar = args.scalars.begin();
+  for (auto& arg : kern->src.captured_args) {
+    arg.value = *scalar;
+    ++scalar;
+  }
+  auto buf = args.buffers.begin();
+  for (auto& acc : kern->src.resources) {
+    acc.second.acc.data = *buf;
+    ++buf;
+  }
+}
+
+mutex_class& issue_command::get_enqueue_lock(
+    const shared_ptr_class<kernel>& kern) {
+  auto address = reinterpret_cast<std::uintptr_t>(kern->get());  // NOLINT
+  return enqueue_locks[(address >> 4) % num_enqueue_locks];
 }
 
-void issue_command::read_buffers_from_device(shared_ptr_class<kernel> kern) {
+void issue_command::invalidate_host_buffers(shared_ptr_class<kernel> kern) {
   for (auto& acc : kern->src.resources) {
     if (acc.second.acc.mode == access::mode::read ||
         acc.second.acc.target == access::target::local) {
-      // Don't need to read back read-only buffers
+      // Read-only buffers stay valid on the host
       continue;
     }
+    // The data itself is only read back once the host needs it
     command::group_detail::add_buffer_copy(
-        acc.second.acc, access::mode::read, buffer_base::enqueue_command,
-        __func__, acc.second.acc.data,
-        reinterpret_cast<buffer_base::clEnqueueBuffer_f>(  // NOLINT
-            &clEnqueueReadBuffer));
+        acc.second.acc, access::mode::read,
+        buffer_base::device_written_command, __func__, acc.second.acc.data,
+        acc.second.region);
   }
 }
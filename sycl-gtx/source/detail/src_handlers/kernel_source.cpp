@@ -2,14 +2,19 @@
 
 #include "SYCL/access.h"
 #include "SYCL/command_group.h"
+#include "SYCL/detail/kernel_passes.h"
+#include "SYCL/detail/work_group_scope.h"
 #include "SYCL/error_handler.h"
 #include "SYCL/kernel.h"
 #include "SYCL/program.h"
+#include "SYCL/ranges/point.h"
+#include "SYCL/runtime_stats.h"
 
 using namespace cl::sycl;
 using namespace detail::kernel_ns;
 
 const string_class source::resource_name_root = "_sycl_buf";
+const string_class source::argument_name_root = "_sycl_arg";
 SYCL_THREAD_LOCAL int source::num_resources = 0;
 SYCL_THREAD_LOCAL source* source::scope = nullptr;
 
@@ -17,32 +22,155 @@ bool source::in_scope() {
   return scope != nullptr;
 }
 
-void source::enter(source& src) {
+void source::enter(source& src, const void* functor, ::size_t functor_size) {
   scope = &src;
   num_resources = 0;
+  if (!src.nodes) {
+    src.nodes = std::make_shared<ir::arena>();
+    src.statements.reserve(64);
+  }
+  ir::arena::current = src.nodes.get();
+  src.functor_begin = static_cast<const char*>(functor);
+  src.functor_end = src.functor_begin + functor_size;
 }
 
 source source::exit(source& src) {
   scope = nullptr;
+  ir::arena::current = nullptr;
+  src.functor_begin = nullptr;
+  src.functor_end = nullptr;
   return src;
 }
 
-/** Creates kernel source */
-string_class source::get_code() const {
-  // TODO(progtx): Caching?
+void source::enter_work_group() {
+  scope->work_group_scope = true;
+  scope->work_group_begin = scope->statements.size();
+  scope->work_item_sections.clear();
+}
+
+void source::exit_work_group(int dimensions) {
+  scope->work_group_scope = false;
+
+  ir::expr leader;
+  for (int i = 0; i < dimensions; ++i) {
+    if (i > 0) {
+      leader += " && ";
+    }
+    leader += point_names::id_local + get_string<int>::get(i) + " == 0";
+  }
+
+  ir::distribute_work_group(scope->statements, *scope->nodes,
+                            scope->work_group_begin, scope->work_item_sections,
+                            leader.get());
+  scope->work_item_sections.clear();
+}
+
+bool source::enter_work_item() {
+  if (!scope->work_group_scope) {
+    return false;
+  }
+  scope->work_group_scope = false;
+  scope->work_item_sections.emplace_back(scope->statements.size(), 0);
+  return true;
+}
+
+void source::exit_work_item(bool section) {
+  if (section) {
+    scope->work_group_scope = true;
+    scope->work_item_sections.back().second = scope->statements.size();
+  }
+}
+
+string_class source::register_argument(const void* address, ::size_t size,
+                                       const char* type_name) {
+  auto begin = static_cast<const char*>(address);
+  if (scope == nullptr || type_name == nullptr ||
+      begin < scope->functor_begin || begin + size > scope->functor_end) {
+    return "";
+  }
+
+  ::size_t offset = static_cast<::size_t>(begin - scope->functor_begin);
+  auto& args = scope->captured_args;
+  for (auto& arg : args) {
+    if (arg.offset == offset && arg.type_name == type_name) {
+      return arg.name;
+    }
+  }
 
+  auto name = argument_name_root + get_string<::size_t>::get(args.size() + 1);
+  args.push_back(
+      {offset, name, type_name, vector_class<char>(begin, begin + size)});
+  return name;
+}
+
+void source::enable_extension(const char* name) {
+  if (scope != nullptr) {
+    scope->extensions.insert(name);
+  }
+}
+
+void source::add_statement(ir::statement::kind_t kind, const char* op,
+                           const ir::expr& type, const ir::expr& target,
+                           const ir::expr& value) {
+  scope->statements.push_back(
+      {kind, scope->depth, op, type.empty() ? nullptr : type.get(),
+       target.empty() ? nullptr : target.get(),
+       value.empty() ? nullptr : value.get()});
+}
+
+string_class source::generate_code() const {
   static const char newline = '\n';
 
-  string_class final_code = string_class("__kernel void ") + kernel_name + "(" +
-                            generate_accessor_list() + ") {" + newline;
+  string_class result;
+  for (auto& extension : extensions) {
+    result += "#pragma OPENCL EXTENSION " + extension + " : enable" + newline;
+  }
+  result += string_class("__kernel void ") + kernel_name + "(" +
+            generate_accessor_list() + ") {" + newline;
+  ir::write(statements, result);
+  result += '}';
+  result += newline;
+  return result;
+}
+
+/** Creates kernel source */
+string_class source::get_code() {
+  if (code.empty()) {
+    detail::runtime_recorder::timer timing(runtime_phase::codegen);
+    code = generate_code();
+  }
+  return code;
+}
 
-  for (auto& line : lines) {
-    final_code += line + newline;
+string_class source::get_optimized_code(unsigned passes) {
+  if (!optimized_code.empty()) {
+    return optimized_code;
+  }
+  if (passes == 0 || !nodes) {
+    optimized_code = get_code();
+    release_ir();
+    return optimized_code;
   }
 
-  final_code = final_code + "}" + newline;
+  get_code();
+  detail::runtime_recorder::timer timing(runtime_phase::codegen);
+  std::map<string_class, string_class> names;
+  for (auto& acc : resources) {
+    names[acc.second.resource_name] = acc.second.type_name;
+  }
+  for (auto& arg : captured_args) {
+    names[arg.name] = arg.type_name;
+  }
+  ir::optimize(statements, *nodes, names, passes);
+  optimized_code = generate_code();
+  release_ir();
+  return optimized_code;
+}
 
-  return final_code;
+void source::release_ir() {
+  statements.clear();
+  statements.shrink_to_fit();
+  nodes.reset();
 }
 
 string_class source::get_kernel_name() const {
@@ -51,7 +179,7 @@ string_class source::get_kernel_name() const {
 
 string_class source::generate_accessor_list() const {
   string_class list;
-  if (resources.empty()) {
+  if (resources.empty() && captured_args.empty()) {
     return list;
   }
 
@@ -64,6 +192,10 @@ string_class source::generate_accessor_list() const {
     list += acc.second.resource_name + ", ";
   }
 
+  for (auto& arg : captured_args) {
+    list += "const " + arg.type_name + " " + arg.name + ", ";
+  }
+
   // 2 to get rid of the last comma and space
   return list.substr(0, list.length() - 2);
 }
@@ -2,69 +2,101 @@
 
 #include "SYCL/accessor.h"
 #include "SYCL/buffer_base.h"
-#include "SYCL/queue.h"
+#include "SYCL/detail/task_graph.h"
+#include <cstdint>
 
 using namespace cl::sycl;
 using namespace detail;
 
-std::set<queue*> synchronizer::queues;
-std::map<accessor_base*, buffer_base*> synchronizer::host_accessors;
+synchronizer::shard synchronizer::shards[synchronizer::num_shards];
 
-void synchronizer::wait_on_queues(buffer_base* buf) {
-  for (auto&& q : queues) {
-    if (q->buffers_in_use.count(buf) > 0) {
-      q->wait();
-    }
-  }
+synchronizer::shard& synchronizer::get_shard(const void* identity) {
+  // Buffers are heap objects, the lowest bits carry little information
+  auto address = reinterpret_cast<std::uintptr_t>(identity);  // NOLINT
+  return shards[(address >> 4) % num_shards];
 }
 
-void synchronizer::flush_queues(buffer_base* buf) {
-  for (auto&& q : queues) {
-    if (q->buffers_in_use.count(buf) > 0) {
-      q->flush();
-    }
+void synchronizer::add(accessor_base* acc, buffer_base* buf,
+                       access::mode mode, const buffer_region& accessed) {
+  SYCL_LOG(trace, sync) << __func__ << acc << buf;
+  // Command groups submitted earlier still get to use the buffer
+  task_graph::dispatch();
+  // Held on the root buffer, which also blocks all of its sub-buffers
+  auto identity = buf->root->identity();
+  {
+    auto& s = get_shard(identity);
+    std::lock_guard<mutex_class> guard(s.lock);
+    s.host_accessors[identity][acc] = {nullptr, std::this_thread::get_id()};
+  }
+  task_graph::wait(buf);
+  auto mapped = buf->acquire_host(mode, accessed);
+  if (mapped != nullptr) {
+    auto& s = get_shard(identity);
+    std::lock_guard<mutex_class> guard(s.lock);
+    s.host_accessors[identity][acc].mapped = mapped;
   }
-}
-
-void synchronizer::add(queue* q) {
-  queues.insert(q);
-}
-
-void synchronizer::remove(queue* q) {
-  queues.erase(q);
-}
-
-void synchronizer::add(accessor_base* acc, buffer_base* buf) {
-  DSELF() << acc << buf;
-  host_accessors.emplace(acc, buf);
-  wait_on_queues(buf);
 }
 
 void synchronizer::remove(accessor_base* acc, buffer_base* buf) {
-  host_accessors.erase(acc);
-  flush_queues(buf);
+  void* mapped = nullptr;
+  {
+    auto identity = buf->root->identity();
+    auto& s = get_shard(identity);
+    std::lock_guard<mutex_class> guard(s.lock);
+    auto it = s.host_accessors.find(identity);
+    if (it != s.host_accessors.end()) {
+      auto acc_it = it->second.find(acc);
+      if (acc_it != it->second.end()) {
+        mapped = acc_it->second.mapped;
+        it->second.erase(acc_it);
+      }
+      if (it->second.empty()) {
+        s.host_accessors.erase(it);
+      }
+    }
+  }
+  if (mapped != nullptr) {
+    buf->release_host(mapped);
+  }
+  task_graph::dispatch();
 }
 
 bool synchronizer::can_flush(
     const std::set<detail::buffer_base*>& buffers_in_use) {
-  {
-    auto d = DSELF();
-    d << "buffers_in_use";
+  if (logging::enabled(logging::level::trace, logging::category::sync)) {
+    debug d(logging::level::trace, logging::category::sync, false);
+    d << __func__ << "buffers_in_use";
     for (auto& buf : buffers_in_use) {
       d << buf;
     }
   }
-  {
-    auto d = DSELF();
-    d << "host_accessors";
-    for (auto&& acc : host_accessors) {
-      d << "{" << acc.first << acc.second << "}";
-    }
-  }
-  for (auto&& acc : host_accessors) {
-    if (buffers_in_use.count(acc.second) > 0) {
+  for (auto buf : buffers_in_use) {
+    auto identity = buf->root->identity();
+    auto& s = get_shard(identity);
+    std::lock_guard<mutex_class> guard(s.lock);
+    if (s.host_accessors.count(identity) > 0) {
       return false;
     }
   }
   return true;
 }
+
+bool synchronizer::held_by_this_thread(
+    const std::set<detail::buffer_base*>& buffers_in_use) {
+  auto self = std::this_thread::get_id();
+  for (auto buf : buffers_in_use) {
+    auto identity = buf->root->identity();
+    auto& s = get_shard(identity);
+    std::lock_guard<mutex_class> guard(s.lock);
+    auto it = s.host_accessors.find(identity);
+    if (it == s.host_accessors.end()) {
+      continue;
+    }
+    for (auto& acc : it->second) {
+      if (acc.second.owner == self) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
@@ -0,0 +1,441 @@
+#include "SYCL/detail/task_graph.h"
+
+#include "SYCL/buffer_base.h"
+#include "SYCL/detail/debug.h"
+#include "SYCL/detail/synchronizer.h"
+#include "SYCL/queue.h"
+#include <algorithm>
+#include <cstdint>
+
+using namespace cl::sycl;
+using namespace detail;
+
+task_graph::shard task_graph::shards[task_graph::num_shards];
+std::map<queue*, std::set<task_graph::node_ptr>> task_graph::deferred;
+std::set<task_graph::node_ptr> task_graph::blocked;
+mutex_class task_graph::deferred_lock;
+std::condition_variable task_graph::progress;
+
+static bool is_complete(const task_graph::node_ptr& n) {
+  return n->dispatched &&
+         (n->completion.get() == nullptr ||
+          n->completion.get_info<info::event::command_execution_status>() ==
+              CL_COMPLETE);
+}
+
+::size_t task_graph::get_shard(buffer_base* buf) {
+  // Buffers are heap objects, the lowest bits carry little information
+  auto address =
+      reinterpret_cast<std::uintptr_t>(buf->root->identity());  // NOLINT
+  return (address >> 4) % num_shards;
+}
+
+vector_class<std::unique_lock<mutex_class>> task_graph::lock_shards(
+    const vector_class<::size_t>& indices) {
+  vector_class<std::unique_lock<mutex_class>> locks;
+  locks.reserve(indices.size());
+  for (auto i : indices) {
+    locks.emplace_back(shards[i].lock);
+  }
+  return locks;
+}
+
+vector_class<const void*> task_graph::get_overlapping(buffer_base* buf) {
+  vector_class<const void*> result = {buf->identity()};
+  auto root = buf->root;
+  if (root != buf) {
+    // The root buffer covers all of its sub-buffers
+    result.push_back(root->identity());
+  }
+
+  auto& sub_buffers = shards[get_shard(buf)].sub_buffers;
+  auto it = sub_buffers.find(root->identity());
+  if (it == sub_buffers.end()) {
+    return result;
+  }
+  for (auto sub : it->second) {
+    if (sub != buf && (root == buf || sub->region.overlaps(buf->region))) {
+      result.push_back(sub);
+    }
+  }
+  return result;
+}
+
+void task_graph::add_edges(const node_ptr& n) {
+  auto& preds = n->predecessors;
+  auto& group = n->group;
+
+  // Read after write
+  for (auto buf : group.read_buffers) {
+    auto& buffers = shards[get_shard(buf)].buffers;
+    for (auto other : get_overlapping(buf)) {
+      auto it = buffers.find(other);
+      if (it != buffers.end() && it->second.last_write) {
+        preds.push_back(it->second.last_write);
+      }
+    }
+  }
+
+  // Write after write and write after read
+  for (auto buf : group.write_buffers) {
+    auto& buffers = shards[get_shard(buf)].buffers;
+    for (auto other : get_overlapping(buf)) {
+      auto it = buffers.find(other);
+      if (it == buffers.end()) {
+        continue;
+      }
+      auto& state = it->second;
+      if (state.last_write) {
+        preds.push_back(state.last_write);
+      }
+      preds.insert(preds.end(), state.reads.begin(), state.reads.end());
+    }
+  }
+
+  std::sort(preds.begin(), preds.end());
+  preds.erase(std::unique(preds.begin(), preds.end()), preds.end());
+  preds.erase(std::remove_if(preds.begin(), preds.end(), is_complete),
+              preds.end());
+
+  // Register the node as the newest user of its buffers
+  for (auto buf : group.read_buffers) {
+    if (group.write_buffers.count(buf) == 0) {
+      auto& reads = shards[get_shard(buf)].buffers[buf->identity()].reads;
+      reads.erase(std::remove_if(reads.begin(), reads.end(), is_complete),
+                  reads.end());
+      reads.push_back(n);
+    }
+  }
+  for (auto buf : group.write_buffers) {
+    auto& state = shards[get_shard(buf)].buffers[buf->identity()];
+    state.last_write = n;
+    state.reads.clear();
+  }
+}
+
+vector_class<cl_event> task_graph::get_events(
+    const vector_class<node_ptr>& nodes) {
+  vector_class<cl_event> events;
+  events.reserve(nodes.size());
+  for (auto& n : nodes) {
+    auto ev = n->completion.get();
+    if (ev != nullptr) {
+      events.push_back(ev);
+    }
+  }
+  return events;
+}
+
+void task_graph::dispatch(node& n) {
+  runtime_recorder::scope timing;
+  n.group.optimize();
+  n.completion = n.group.flush(get_events(n.predecessors));
+  timing.commit(n.group.q->recorder.get(), n.group.kernel_name);
+}
+
+vector_class<task_graph::node_ptr> task_graph::finish(node& n) {
+  vector_class<node_ptr> successors;
+  std::lock_guard<mutex_class> guard(n.lock);
+  n.dispatched = true;
+  // Successors only need the completion event
+  n.predecessors.clear();
+  successors.swap(n.successors);
+  return successors;
+}
+
+void task_graph::defer(const node_ptr& n) {
+  std::lock_guard<mutex_class> guard(deferred_lock);
+  deferred[n->group.q].insert(n);
+  n->deferred = true;
+}
+
+void task_graph::block(const node_ptr& n) {
+  {
+    std::lock_guard<mutex_class> guard(deferred_lock);
+    if (n->claimed) {
+      // Dropped together with its queue
+      return;
+    }
+    blocked.insert(n);
+    if (!n->deferred) {
+      deferred[n->group.q].insert(n);
+      n->deferred = true;
+    }
+  }
+  // The host accessor could have been released before the node was blocked
+  auto& group = n->group;
+  if (synchronizer::can_flush(group.read_buffers) &&
+      synchronizer::can_flush(group.write_buffers)) {
+    std::unique_lock<mutex_class> guard(deferred_lock);
+    if (blocked.erase(n) > 0) {
+      guard.unlock();
+      run(n);
+    }
+  }
+}
+
+void task_graph::run(node_ptr n) {
+  vector_class<node_ptr> ready = {std::move(n)};
+  while (!ready.empty()) {
+    n = std::move(ready.back());
+    ready.pop_back();
+    auto& group = n->group;
+
+    vector_class<node_ptr> successors;
+    {
+      auto locks = lock_shards(n->shards);
+      if (!synchronizer::can_flush(group.read_buffers) ||
+          !synchronizer::can_flush(group.write_buffers)) {
+        locks.clear();
+        block(n);
+        continue;
+      }
+      if (n->claimed.exchange(true)) {
+        // Dropped together with its queue
+        continue;
+      }
+      dispatch(*n);
+      successors = finish(*n);
+      if (n->deferred) {
+        // Only now can its queue be destroyed
+        std::lock_guard<mutex_class> guard(deferred_lock);
+        deferred[group.q].erase(n);
+      }
+    }
+    if (n->deferred) {
+      progress.notify_all();
+    }
+
+    for (auto& succ : successors) {
+      if (--succ->waiting == 0) {
+        ready.push_back(std::move(succ));
+      }
+    }
+  }
+}
+
+handler_event task_graph::submit(node_ptr n) {
+  auto& group = n->group;
+  auto& indices = n->shards;
+  for (auto buf : group.read_buffers) {
+    indices.push_back(get_shard(buf));
+  }
+  for (auto buf : group.write_buffers) {
+    indices.push_back(get_shard(buf));
+  }
+  std::sort(indices.begin(), indices.end());
+  indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+  {
+    auto locks = lock_shards(indices);
+    add_edges(n);
+    for (auto& pred : n->predecessors) {
+      std::lock_guard<mutex_class> guard(pred->lock);
+      if (!pred->dispatched) {
+        pred->successors.push_back(n);
+        ++n->waiting;
+      }
+    }
+  }
+
+  if (n->waiting > 1) {
+    // Kept with its queue until the last predecessor dispatches it
+    defer(n);
+  }
+  if (--n->waiting == 0) {
+    run(n);
+  }
+
+  handler_event events;
+  std::lock_guard<mutex_class> guard(n->lock);
+  if (n->dispatched) {
+    events.kernelEvent = group.kernel_event;
+    events.completeEvent = n->completion;
+  }
+  return events;
+}
+
+handler_event task_graph::submit(const command_group& recorded) {
+  return submit(node_ptr(new node(recorded)));
+}
+
+void task_graph::dispatch() {
+  vector_class<node_ptr> retry;
+  {
+    std::lock_guard<mutex_class> guard(deferred_lock);
+    retry.assign(blocked.begin(), blocked.end());
+    blocked.clear();
+  }
+  // Nodes still waiting for a host accessor are blocked again
+  for (auto& n : retry) {
+    run(n);
+  }
+}
+
+vector_class<event> task_graph::get_pending_events(buffer_base* buf) {
+  auto& buffers = shards[get_shard(buf)].buffers;
+  vector_class<event> events;
+  for (auto other : get_overlapping(buf)) {
+    auto it = buffers.find(other);
+    if (it == buffers.end()) {
+      continue;
+    }
+
+    auto nodes = it->second.reads;
+    if (it->second.last_write) {
+      nodes.push_back(it->second.last_write);
+    }
+    for (auto& n : nodes) {
+      if (n->dispatched && n->completion.get() != nullptr) {
+        events.push_back(n->completion);
+      }
+    }
+  }
+  return events;
+}
+
+void task_graph::wait(vector_class<event> events) {
+  if (events.empty()) {
+    return;
+  }
+  vector_class<cl_event> cl_events;
+  cl_events.reserve(events.size());
+  for (auto& ev : events) {
+    cl_events.push_back(ev.get());
+  }
+  auto error_code = clWaitForEvents(static_cast<::cl_uint>(cl_events.size()),
+                                    cl_events.data());
+  detail::error::report(error_code);
+}
+
+void task_graph::wait(buffer_base* buf) {
+  vector_class<event> events;
+  {
+    std::lock_guard<mutex_class> guard(shards[get_shard(buf)].lock);
+    events = get_pending_events(buf);
+  }
+  // Other threads can keep submitting while this one is blocked
+  wait(std::move(events));
+}
+
+void task_graph::remove(buffer_base* buf) {
+  if (!buf->is_last_copy()) {
+    // The other copies keep using the buffer
+    return;
+  }
+  dispatch();
+  auto& s = shards[get_shard(buf)];
+  vector_class<event> events;
+  {
+    std::lock_guard<mutex_class> guard(s.lock);
+    events = get_pending_events(buf);
+  }
+  wait(std::move(events));
+
+  std::lock_guard<mutex_class> guard(s.lock);
+  s.buffers.erase(buf->identity());
+  if (buf->root == buf) {
+    s.sub_buffers.erase(buf->identity());
+  } else {
+    auto it = s.sub_buffers.find(buf->root->identity());
+    if (it != s.sub_buffers.end()) {
+      it->second.erase(buf);
+    }
+  }
+}
+
+void task_graph::add_sub_buffer(buffer_base* sub) {
+  auto& s = shards[get_shard(sub)];
+  std::lock_guard<mutex_class> guard(s.lock);
+  s.sub_buffers[sub->root->identity()].insert(sub);
+}
+
+void task_graph::replace_queue(queue* from, queue* to) {
+  std::lock_guard<mutex_class> guard(deferred_lock);
+  auto it = deferred.find(from);
+  if (it == deferred.end()) {
+    return;
+  }
+  auto nodes = std::move(it->second);
+  deferred.erase(it);
+  for (auto& n : nodes) {
+    if (n->claimed) {
+      // Being dispatched, which removes it from the original queue
+      deferred[from].insert(n);
+    } else {
+      n->group.q = to;
+      deferred[to].insert(n);
+    }
+  }
+}
+
+bool task_graph::blocked_by_this_thread(const vector_class<node_ptr>& nodes) {
+  std::set<node*> visited;
+  std::set<buffer_base*> buffers_in_use;
+  auto stack = nodes;
+  while (!stack.empty()) {
+    auto n = stack.back();
+    stack.pop_back();
+    if (!visited.insert(n.get()).second) {
+      continue;
+    }
+    std::lock_guard<mutex_class> guard(n->lock);
+    if (n->dispatched) {
+      continue;
+    }
+    auto& group = n->group;
+    buffers_in_use.insert(group.read_buffers.begin(), group.read_buffers.end());
+    buffers_in_use.insert(group.write_buffers.begin(),
+                          group.write_buffers.end());
+    stack.insert(stack.end(), n->predecessors.begin(), n->predecessors.end());
+  }
+  return synchronizer::held_by_this_thread(buffers_in_use);
+}
+
+void task_graph::remove_queue(queue* q) {
+  std::unique_lock<mutex_class> guard(deferred_lock);
+  while (true) {
+    guard.unlock();
+    dispatch();
+    guard.lock();
+
+    auto it = deferred.find(q);
+    if (it == deferred.end() || it->second.empty()) {
+      if (it != deferred.end()) {
+        deferred.erase(it);
+      }
+      return;
+    }
+    vector_class<node_ptr> nodes(it->second.begin(), it->second.end());
+    if (!blocked_by_this_thread(nodes)) {
+      // Host accessors of other threads are released eventually
+      progress.wait(guard);
+      continue;
+    }
+
+    SYCL_LOG(error, runtime)
+        << "Queue destroyed while its command groups wait for a host accessor"
+           " of the same thread, dropping"
+        << nodes.size() << "command groups";
+    vector_class<node_ptr> dropped;
+    for (auto& n : nodes) {
+      if (!n->claimed.exchange(true)) {
+        blocked.erase(n);
+        dropped.push_back(n);
+      }
+    }
+    deferred.erase(it);
+    guard.unlock();
+
+    // Successors don't have to wait for a node that will never run
+    for (auto& n : dropped) {
+      for (auto& succ : finish(*n)) {
+        if (--succ->waiting == 0) {
+          run(std::move(succ));
+        }
+      }
+    }
+    progress.notify_all();
+    return;
+  }
+}
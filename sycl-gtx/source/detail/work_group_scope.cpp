@@ -0,0 +1,320 @@
+#include "SYCL/detail/work_group_scope.h"
+
+#include <set>
+
+using namespace cl::sycl;
+using namespace detail::ir;
+
+namespace {
+
+using kind_t = node::kind_t;
+using statement_kind = statement::kind_t;
+using name_set = std::set<string_class>;
+
+const char fence[] = "CLK_LOCAL_MEM_FENCE|CLK_GLOBAL_MEM_FENCE";
+
+bool is_identifier_char(char c) {
+  return c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9');
+}
+
+/** The variable written through a target, e.g. v for v.s0 */
+const node* root_of(const node* target) {
+  while (target != nullptr && target->kind == kind_t::member) {
+    target = target->left;
+  }
+  if (target == nullptr || target->kind != kind_t::text ||
+      target->length == 0) {
+    return nullptr;
+  }
+  for (unsigned i = 0; i < target->length; ++i) {
+    if (!is_identifier_char(target->str[i])) {
+      return nullptr;
+    }
+  }
+  return target;
+}
+
+string_class name_of(const node* target) {
+  auto root = root_of(target);
+  if (root == nullptr) {
+    return string_class();
+  }
+  return string_class(root->str, root->length);
+}
+
+/** Adds the names in verbatim code, including fields and literals */
+void collect_names(const node* n, name_set& names) {
+  for (unsigned i = 0; i < n->length;) {
+    if (!is_identifier_char(n->str[i])) {
+      ++i;
+      continue;
+    }
+    auto begin = i;
+    while (i < n->length && is_identifier_char(n->str[i])) {
+      ++i;
+    }
+    names.emplace(n->str + begin, i - begin);
+  }
+}
+
+/** Adds the variables the code can change, e.g. through ++ or &(x) */
+void collect_written(const node* n, name_set& written) {
+  if (n == nullptr || (n->flags & node::side_effects) == 0) {
+    return;
+  }
+  if (n->kind == kind_t::text) {
+    // Verbatim code could change any variable it names
+    collect_names(n, written);
+    return;
+  }
+  if ((n->kind == kind_t::prefix || n->kind == kind_t::postfix) &&
+      (n->str[0] == '+' || n->str[0] == '-')) {
+    written.insert(name_of(n->left));
+  }
+  collect_written(n->left, written);
+  collect_written(n->right, written);
+}
+
+name_set written_by(const statement& s) {
+  name_set written;
+  if (s.kind == statement_kind::assign || s.kind == statement_kind::declare) {
+    written.insert(name_of(s.target));
+  }
+  collect_written(s.target, written);
+  collect_written(s.value, written);
+  return written;
+}
+
+/** Reads memory or one of the variables */
+bool reads(const node* n, const name_set& variables) {
+  if (n == nullptr) {
+    return false;
+  }
+  if ((n->flags & node::memory) != 0) {
+    return true;
+  }
+  if (n->kind == kind_t::text) {
+    name_set names;
+    collect_names(n, names);
+    for (auto& name : names) {
+      if (variables.count(name) != 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+  return reads(n->left, variables) || reads(n->right, variables);
+}
+
+/** Statements within a block, executed one after the other */
+bool is_straight(const statement& s) {
+  return s.kind == statement_kind::plain || s.kind == statement_kind::assign ||
+         s.kind == statement_kind::declare;
+}
+
+/** Writes memory or changes something besides the assigned variable */
+bool has_effects(const statement& s) {
+  for (auto n : {s.target, s.value}) {
+    if (n != nullptr && (n->flags & node::side_effects) != 0) {
+      return true;
+    }
+  }
+  return s.kind == statement_kind::assign && root_of(s.target) == nullptr;
+}
+
+class distributor {
+ private:
+  arena& nodes;
+  const name_set& shared;
+  vector_class<statement> result;
+  const node* barrier;
+  const node* guard;
+  /** Depth of the open block of the leader, zero if there is none */
+  unsigned guard_depth = 0;
+  /**
+   * Set while no work item can still be reading
+   * what the leader or the work items write next
+   */
+  bool synchronized = true;
+
+ public:
+  distributor(arena& nodes, const name_set& shared, const node* leader)
+      : nodes(nodes), shared(shared) {
+    auto argument = nodes.make(kind_t::argument, nullptr,
+                               nodes.literal(fence, sizeof(fence) - 1));
+    barrier = nodes.make(kind_t::call, "barrier", argument, nullptr,
+                         node::side_effects);
+    guard = nodes.make(
+        kind_t::concat, nullptr, nodes.literal("if(", 3),
+        nodes.make(kind_t::concat, nullptr, leader, nodes.literal(")", 1)));
+  }
+
+  vector_class<statement>& get() {
+    return result;
+  }
+
+  void add(const statement& s) {
+    close_guard();
+    result.push_back(s);
+    // Control flow can lead back to reads before the last barrier
+    if (!is_straight(s) || reads(s.target, shared) || reads(s.value, shared)) {
+      synchronized = false;
+    }
+  }
+
+  void add_barrier(unsigned depth) {
+    result.push_back({statement_kind::plain, depth, nullptr, nullptr, nullptr,
+                      barrier});
+    synchronized = true;
+  }
+
+  /** The work items wait until the leader has run the statement */
+  void add_by_leader(statement s) {
+    if (guard_depth == 0) {
+      if (!synchronized) {
+        add_barrier(s.depth);
+      }
+      result.push_back(
+          {statement_kind::control, s.depth, "if", nullptr, nullptr, guard});
+      result.push_back({statement_kind::open_block, s.depth, nullptr, nullptr,
+                        nullptr, nullptr});
+      guard_depth = s.depth;
+    }
+    ++s.depth;
+    result.push_back(s);
+  }
+
+  /** The statements are run by every work item and followed by a barrier */
+  void add_work_item(vector_class<statement>::const_iterator begin,
+                     vector_class<statement>::const_iterator end) {
+    close_guard();
+    if (!synchronized) {
+      add_barrier(begin->depth);
+    }
+    result.insert(result.end(), begin, end);
+    add_barrier(begin->depth);
+  }
+
+  void close_guard(bool last = false) {
+    if (guard_depth == 0) {
+      return;
+    }
+    result.push_back({statement_kind::close_block, guard_depth, nullptr,
+                      nullptr, nullptr, nullptr});
+    if (!last) {
+      add_barrier(guard_depth);
+    }
+    guard_depth = 0;
+  }
+
+  void finish() {
+    close_guard(true);
+    // Nothing follows the barriers at the end of the kernel
+    while (!result.empty() && result.back().value == barrier) {
+      result.pop_back();
+    }
+  }
+};
+
+}  // namespace
+
+void detail::ir::distribute_work_group(
+    vector_class<statement>& statements, arena& nodes, ::size_t begin,
+    const vector_class<std::pair<::size_t, ::size_t>>& work_item_sections,
+    const node* leader) {
+  auto size = statements.size();
+  vector_class<bool> by_work_item(size, false);
+  for (auto& section : work_item_sections) {
+    for (auto i = section.first; i < section.second; ++i) {
+      by_work_item[i] = true;
+    }
+  }
+
+  name_set group_variables;
+  for (auto i = begin; i < size; ++i) {
+    auto& s = statements[i];
+    if (!by_work_item[i] && s.kind == statement_kind::declare &&
+        root_of(s.target) != nullptr) {
+      group_variables.insert(name_of(s.target));
+    }
+  }
+
+  // Variables written by work items have to be visible to the whole group
+  name_set shared;
+  auto share = [&](const name_set& written) {
+    for (auto& name : written) {
+      if (group_variables.count(name) != 0) {
+        shared.insert(name);
+      }
+    }
+  };
+  for (auto i = begin; i < size; ++i) {
+    if (by_work_item[i]) {
+      share(written_by(statements[i]));
+    }
+  }
+
+  // Only the leader runs statements with effects or writing shared variables,
+  // which makes the variables it writes shared as well
+  vector_class<bool> by_leader(size, false);
+  for (bool grown = true; grown;) {
+    grown = false;
+    for (auto i = begin; i < size; ++i) {
+      auto& s = statements[i];
+      if (by_work_item[i] || by_leader[i] || !is_straight(s)) {
+        continue;
+      }
+      auto written = written_by(s);
+      auto writes_shared = false;
+      for (auto& name : written) {
+        writes_shared = writes_shared || shared.count(name) != 0;
+      }
+      if (has_effects(s) || writes_shared) {
+        by_leader[i] = true;
+        share(written);
+        grown = true;
+      }
+    }
+  }
+
+  distributor lowered(nodes, shared, leader);
+  auto& result = lowered.get();
+  result.assign(statements.begin(), statements.begin() + begin);
+  vector_class<statement> locals;
+  auto section = work_item_sections.begin();
+
+  for (auto i = begin; i < size; ++i) {
+    if (section != work_item_sections.end() && section->first == i) {
+      lowered.add_work_item(statements.begin() + section->first,
+                            statements.begin() + section->second);
+      i = section->second - 1;
+      ++section;
+      continue;
+    }
+
+    auto s = statements[i];
+    if (s.kind == statement_kind::declare &&
+        shared.count(name_of(s.target)) != 0) {
+      auto type = nodes.make(kind_t::concat, nullptr,
+                             nodes.literal("__local ", 8), s.type);
+      locals.push_back(
+          {statement_kind::declare, 1, nullptr, type, s.target, nullptr});
+      if (s.value == nullptr) {
+        continue;
+      }
+      s = {statement_kind::assign, s.depth, "=", nullptr, s.target, s.value};
+    }
+
+    if (by_leader[i]) {
+      lowered.add_by_leader(s);
+    } else {
+      lowered.add(s);
+    }
+  }
+  lowered.finish();
+
+  // Local memory can only be declared in the outermost scope of the kernel
+  result.insert(result.begin() + begin, locals.begin(), locals.end());
+  statements.swap(result);
+}
@@ -1,6 +1,7 @@
 #include "SYCL/handler.h"
 
 #include "SYCL/context.h"
+#include "SYCL/error_handler.h"
 #include "SYCL/queue.h"
 
 using namespace cl::sycl;
@@ -9,3 +10,12 @@ using namespace detail;
 context handler::get_context(queue* q) {
   return q->get_context();
 }
+
+::size_t handler::get_work_group_size(queue* q, cl_kernel kern) {
+  ::size_t size = 1;
+  auto error_code = clGetKernelWorkGroupInfo(
+      kern, q->get_device().get(), CL_KERNEL_WORK_GROUP_SIZE, sizeof(size),
+      &size, nullptr);
+  detail::error::report(error_code);
+  return size;
+}
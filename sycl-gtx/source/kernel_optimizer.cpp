@@ -0,0 +1,77 @@
+#include "SYCL/kernel_optimizer.h"
+
+#include "SYCL/detail/debug.h"
+#include <cstdlib>
+
+using namespace cl::sycl;
+
+namespace {
+
+const int num_passes = 4;
+const unsigned all_passes = (1u << num_passes) - 1;
+
+unsigned bit(kernel_pass pass) {
+  return 1u << static_cast<unsigned>(pass);
+}
+
+bool parse_pass(const string_class& name, unsigned& passes) {
+  static const char* const names[] = {"constant_folding", "loop_invariants",
+                                      "common_subexpressions", "dead_code"};
+  for (int i = 0; i < num_passes; ++i) {
+    if (name == names[i]) {
+      passes |= 1u << i;
+      return true;
+    }
+  }
+  if (name == "all") {
+    passes = all_passes;
+    return true;
+  }
+  return name == "none";
+}
+
+struct environment {
+  environment() {
+    auto config = std::getenv("SYCL_GTX_KERNEL_PASSES");
+    if (config != nullptr) {
+      kernel_optimizer::configure(config);
+    }
+  }
+} from_environment;
+
+}  // namespace
+
+std::atomic<unsigned> kernel_optimizer::passes{all_passes};
+
+unsigned kernel_optimizer::get_passes() {
+  return passes.load(std::memory_order_relaxed);
+}
+
+void kernel_optimizer::enable(kernel_pass pass) {
+  passes.fetch_or(bit(pass));
+}
+
+void kernel_optimizer::disable(kernel_pass pass) {
+  passes.fetch_and(~bit(pass));
+}
+
+bool kernel_optimizer::is_enabled(kernel_pass pass) {
+  return (get_passes() & bit(pass)) != 0;
+}
+
+void kernel_optimizer::configure(const string_class& list) {
+  unsigned enabled = 0;
+  ::size_t begin = 0;
+  while (begin <= list.size()) {
+    auto end = list.find(',', begin);
+    if (end == string_class::npos) {
+      end = list.size();
+    }
+    auto name = list.substr(begin, end - begin);
+    begin = end + 1;
+    if (!name.empty() && !parse_pass(name, enabled)) {
+      debug::warning("Unknown kernel pass") << name;
+    }
+  }
+  passes.store(enabled);
+}
@@ -0,0 +1,130 @@
+#include "SYCL/memory_pool.h"
+
+#include "SYCL/error_handler.h"
+#include "SYCL/queue.h"
+
+using namespace cl::sycl;
+
+struct memory_pool::state {
+  std::map<key_t, vector_class<cl_mem>> idle;
+  memory_pool_stats stats;
+  ::size_t capacity = 256 * 1024 * 1024;
+  mutex_class lock;
+};
+
+memory_pool::state& memory_pool::get_state() {
+  static auto pool = new state();
+  return *pool;
+}
+
+::size_t memory_pool::size_class(::size_t size) {
+  static const ::size_t min_size = 256;
+  if (size <= min_size) {
+    return min_size;
+  }
+  ::size_t power = min_size;
+  while (power * 2 <= size) {
+    power *= 2;
+  }
+  auto step = power / 4;
+  return (size + step - 1) / step * step;
+}
+
+void memory_pool::release_until(::size_t keep_bytes) {
+  auto& idle = get_state().idle;
+  auto& stats = get_state().stats;
+  for (auto it = idle.begin();
+       it != idle.end() && stats.cached_bytes > keep_bytes;) {
+    auto& list = it->second;
+    while (!list.empty() && stats.cached_bytes > keep_bytes) {
+      clReleaseMemObject(list.back());
+      list.pop_back();
+      stats.cached_bytes -= std::get<2>(it->first);
+      --stats.cached_objects;
+      ++stats.released;
+    }
+    if (list.empty()) {
+      it = idle.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+cl_mem memory_pool::allocate(queue* q, cl_mem_flags flags, ::size_t size,
+                             ::cl_int& error_code) {
+  auto context = q->get_context().get();
+  size = size_class(size);
+  auto& pool = get_state();
+  {
+    std::lock_guard<mutex_class> guard(pool.lock);
+    auto it = pool.idle.find(key_t(context, flags, size));
+    if (it != pool.idle.end()) {
+      auto mem = it->second.back();
+      it->second.pop_back();
+      if (it->second.empty()) {
+        pool.idle.erase(it);
+      }
+      pool.stats.cached_bytes -= size;
+      --pool.stats.cached_objects;
+      ++pool.stats.hits;
+      error_code = CL_SUCCESS;
+      return mem;
+    }
+    ++pool.stats.misses;
+  }
+  return clCreateBuffer(context, flags, size, nullptr, &error_code);
+}
+
+void memory_pool::recycle(cl_mem mem) {
+  cl_context context;
+  cl_mem_flags flags;
+  ::size_t size;
+  auto error_code = clGetMemObjectInfo(mem, CL_MEM_CONTEXT, sizeof(context),
+                                       &context, nullptr);
+  detail::error::report(error_code);
+  error_code =
+      clGetMemObjectInfo(mem, CL_MEM_FLAGS, sizeof(flags), &flags, nullptr);
+  detail::error::report(error_code);
+  error_code =
+      clGetMemObjectInfo(mem, CL_MEM_SIZE, sizeof(size), &size, nullptr);
+  detail::error::report(error_code);
+
+  auto& pool = get_state();
+  std::lock_guard<mutex_class> guard(pool.lock);
+  if (size > pool.capacity) {
+    return;
+  }
+  // The pool holds its own reference
+  clRetainMemObject(mem);
+  pool.idle[key_t(context, flags, size)].push_back(mem);
+  pool.stats.cached_bytes += size;
+  ++pool.stats.cached_objects;
+  ++pool.stats.recycled;
+  release_until(pool.capacity);
+}
+
+void memory_pool::set_capacity(::size_t bytes) {
+  auto& pool = get_state();
+  std::lock_guard<mutex_class> guard(pool.lock);
+  pool.capacity = bytes;
+  release_until(pool.capacity);
+}
+
+::size_t memory_pool::get_capacity() {
+  auto& pool = get_state();
+  std::lock_guard<mutex_class> guard(pool.lock);
+  return pool.capacity;
+}
+
+void memory_pool::trim(::size_t keep_bytes) {
+  auto& pool = get_state();
+  std::lock_guard<mutex_class> guard(pool.lock);
+  release_until(keep_bytes);
+}
+
+memory_pool_stats memory_pool::get_stats() {
+  auto& pool = get_state();
+  std::lock_guard<mutex_class> guard(pool.lock);
+  return pool.stats;
+}
@@ -0,0 +1,25 @@
+#include "SYCL/out_of_core.h"
+
+using namespace cl::sycl;
+
+out_of_core::out_of_core(queue& first, queue& second)
+    : queues{&first, &second} {}
+
+::size_t out_of_core::get_chunk_items(::size_t bytes_per_item) const {
+  if (chunk_items != 0) {
+    return chunk_items;
+  }
+  if (bytes_per_item == 0) {
+    bytes_per_item = 1;
+  }
+
+  auto dev = queues[0]->get_device();
+  auto max_alloc = static_cast<::size_t>(
+      dev.get_info<info::device::max_mem_alloc_size>());
+  auto global = static_cast<::size_t>(
+      dev.get_info<info::device::global_mem_size>());
+
+  // Each buffer of a chunk is a single allocation,
+  // and two chunks in flight should leave half of the memory to others
+  return std::min(max_alloc, global / 4) / bytes_per_item;
+}
@@ -3,11 +3,13 @@
 #include "SYCL/info.h"
 
 #include "SYCL/detail/debug.h"
+#include <mutex>
 #include <utility>
 
 using namespace cl::sycl;
 
 vector_class<platform> platform::platforms;
+static std::once_flag platforms_flag;
 
 platform::platform(cl_platform_id platform_id, device_selector& dev_selector)
     : platform_id(platform_id) {}
@@ -23,8 +25,8 @@ cl_platform_id platform::get() const {
 }
 
 vector_class<platform> platform::get_platforms() {
-  if (platforms.empty()) {
-    // TODO(progtx): Thread safe
+  // Retried on the next call if an exception is thrown
+  std::call_once(platforms_flag, [] {
     static const int MAX_PLATFORMS = 1024;
     cl_platform_id platform_ids[MAX_PLATFORMS];
     cl_uint num_platforms;
@@ -33,7 +35,7 @@ vector_class<platform> platform::get_platforms() {
     detail::error::report(error_code);
     platforms =
         vector_class<platform>(platform_ids, platform_ids + num_platforms);
-  }
+  });
   return platforms;
 }
 
@@ -0,0 +1,286 @@
+#include "SYCL/profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <ostream>
+
+using namespace cl::sycl;
+
+std::atomic<bool> profiler::enabled(false);
+vector_class<profiler::pending> profiler::in_flight;
+vector_class<profiler_record> profiler::records;
+std::map<profiler::queue_ref, ::size_t> profiler::queues;
+mutex_class profiler::lock;
+
+static const char* command_name(profiler_command command) {
+  switch (command) {
+    case profiler_command::kernel:
+      return "kernel";
+    case profiler_command::write:
+      return "write";
+    case profiler_command::read:
+      return "read";
+    case profiler_command::copy:
+      return "copy";
+    case profiler_command::map:
+      return "map";
+    case profiler_command::unmap:
+      return "unmap";
+  }
+  return "";
+}
+
+// Quoted JSON string, control characters are written as \u escapes
+static void write_json_string(std::ostream& os, const string_class& text) {
+  static const char hex[] = "0123456789abcdef";
+  os << '"';
+  for (auto c : text) {
+    auto u = static_cast<unsigned char>(c);
+    if (c == '"' || c == '\\') {
+      os << '\\' << c;
+    } else if (u < 0x20) {
+      os << "\\u00" << hex[u >> 4] << hex[u & 0xf];
+    } else {
+      os << c;
+    }
+  }
+  os << '"';
+}
+
+void profiler::record(cl_command_queue q, cl_event evnt,
+                      profiler_command command, string_class name,
+                      ::size_t bytes) {
+  if (!enabled || evnt == nullptr) {
+    return;
+  }
+
+  pending p;
+  p.record.command = command;
+  p.record.name = name.empty() ? command_name(command) : std::move(name);
+  p.record.bytes = bytes;
+  p.evnt = event(evnt);
+
+  queue_ref key(q);
+  std::lock_guard<mutex_class> guard(lock);
+  auto it = queues.find(key);
+  if (it == queues.end()) {
+    it = queues.emplace(std::move(key), queues.size()).first;
+  }
+  p.record.queue = it->second;
+  in_flight.push_back(std::move(p));
+  if (in_flight.size() >= drain_threshold) {
+    drain_completed();
+  }
+}
+
+void profiler::read_timestamps(pending& p) {
+  static const cl_profiling_info params[] = {
+      CL_PROFILING_COMMAND_QUEUED, CL_PROFILING_COMMAND_SUBMIT,
+      CL_PROFILING_COMMAND_START, CL_PROFILING_COMMAND_END};
+
+  cl_ulong times[4] = {0, 0, 0, 0};
+  for (int i = 0; i < 4; ++i) {
+    auto error_code = clGetEventProfilingInfo(
+        p.evnt.get(), params[i], sizeof(cl_ulong), &times[i], nullptr);
+    if (error_code != CL_SUCCESS) {
+      // Queue without profiling
+      std::fill(times, times + 4, 0);
+      break;
+    }
+  }
+  p.record.queued = times[0];
+  p.record.submit = times[1];
+  p.record.start = times[2];
+  p.record.end = times[3];
+}
+
+void profiler::drain_completed() {
+  // Only a prefix keeps the records in the order they were enqueued
+  auto it = in_flight.begin();
+  for (; it != in_flight.end(); ++it) {
+    auto status =
+        it->evnt.get_info<info::event::command_execution_status>();
+    if (status != CL_COMPLETE) {
+      break;
+    }
+    read_timestamps(*it);
+    records.push_back(std::move(it->record));
+  }
+  in_flight.erase(in_flight.begin(), it);
+}
+
+void profiler::resolve() {
+  vector_class<pending> done;
+  ::size_t position;
+  {
+    std::lock_guard<mutex_class> guard(lock);
+    done.swap(in_flight);
+    position = records.size();
+  }
+  if (done.empty()) {
+    return;
+  }
+
+  for (auto& p : done) {
+    p.evnt.wait();
+    read_timestamps(p);
+  }
+
+  std::lock_guard<mutex_class> guard(lock);
+  // Commands drained in the meantime are newer than the resolved ones
+  vector_class<profiler_record> resolved;
+  resolved.reserve(done.size());
+  for (auto& p : done) {
+    resolved.push_back(std::move(p.record));
+  }
+  position = std::min(position, records.size());
+  records.insert(records.begin() + position,
+                 std::make_move_iterator(resolved.begin()),
+                 std::make_move_iterator(resolved.end()));
+}
+
+void profiler::enable() {
+  enabled = true;
+}
+
+void profiler::disable() {
+  enabled = false;
+}
+
+bool profiler::is_enabled() {
+  return enabled;
+}
+
+void profiler::clear() {
+  std::lock_guard<mutex_class> guard(lock);
+  in_flight.clear();
+  records.clear();
+  queues.clear();
+}
+
+vector_class<profiler_record> profiler::get_records() {
+  resolve();
+  std::lock_guard<mutex_class> guard(lock);
+  return records;
+}
+
+vector_class<profiler_summary> profiler::get_summary() {
+  std::map<std::pair<profiler_command, string_class>, profiler_summary> groups;
+  for (auto& r : get_records()) {
+    if (r.end == 0) {
+      continue;
+    }
+    auto duration = r.end - r.start;
+    auto& s = groups[std::make_pair(r.command, r.name)];
+    if (s.count == 0) {
+      s.command = r.command;
+      s.name = r.name;
+      s.min = duration;
+    }
+    ++s.count;
+    s.bytes += r.bytes;
+    s.total += duration;
+    s.min = std::min(s.min, duration);
+    s.max = std::max(s.max, duration);
+  }
+
+  vector_class<profiler_summary> summary;
+  for (auto& g : groups) {
+    summary.push_back(g.second);
+  }
+  std::stable_sort(summary.begin(), summary.end(),
+                   [](const profiler_summary& a, const profiler_summary& b) {
+                     return a.total > b.total;
+                   });
+  return summary;
+}
+
+void profiler::export_chrome_trace(std::ostream& os) {
+  auto all = get_records();
+
+  // Timestamps relative to the first command keep the numbers readable
+  cl_ulong first = 0;
+  for (auto& r : all) {
+    if (r.end != 0 && (first == 0 || r.queued < first)) {
+      first = r.queued;
+    }
+  }
+  auto to_us = [first](cl_ulong ns) {
+    return static_cast<double>(ns - first) / 1000.0;
+  };
+
+  auto old_flags = os.flags();
+  auto old_precision = os.precision();
+  os << std::fixed << std::setprecision(3);
+
+  os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool comma = false;
+  ::size_t num_queues = 0;
+  for (auto& r : all) {
+    num_queues = std::max(num_queues, r.queue + 1);
+    if (r.end == 0) {
+      continue;
+    }
+    os << (comma ? ",\n" : "\n");
+    comma = true;
+    os << "{\"name\":";
+    write_json_string(os, r.name);
+    os << ",\"cat\":\""
+       << (r.command == profiler_command::kernel ? "kernel" : "memory")
+       << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << r.queue
+       << ",\"ts\":" << to_us(r.start)
+       << ",\"dur\":" << static_cast<double>(r.end - r.start) / 1000.0
+       << ",\"args\":{\"command\":\"" << command_name(r.command)
+       << "\",\"bytes\":" << r.bytes << ",\"queued\":" << to_us(r.queued)
+       << ",\"submit\":" << to_us(r.submit) << "}}";
+  }
+  for (::size_t q = 0; q < num_queues; ++q) {
+    os << (comma ? ",\n" : "\n");
+    comma = true;
+    os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << q
+       << ",\"args\":{\"name\":\"queue " << q << "\"}}";
+  }
+  os << "\n]}\n";
+
+  os.flags(old_flags);
+  os.precision(old_precision);
+}
+
+bool profiler::export_chrome_trace(const string_class& path) {
+  std::ofstream file(path);
+  if (!file) {
+    return false;
+  }
+  export_chrome_trace(file);
+  return static_cast<bool>(file);
+}
+
+void profiler::print_summary(std::ostream& os) {
+  auto summary = get_summary();
+
+  ::size_t name_width = 4;
+  for (auto& s : summary) {
+    name_width = std::max(name_width, s.name.size());
+  }
+
+  auto old_flags = os.flags();
+  auto old_precision = os.precision();
+
+  os << std::left << std::setw(name_width) << "name" << std::right
+     << std::setw(8) << "calls" << std::setw(14) << "total [us]"
+     << std::setw(12) << "avg [us]" << std::setw(12) << "min [us]"
+     << std::setw(12) << "max [us]" << std::setw(14) << "bytes" << '\n';
+  os << std::fixed << std::setprecision(3);
+  for (auto& s : summary) {
+    os << std::left << std::setw(name_width) << s.name << std::right
+       << std::setw(8) << s.count << std::setw(14) << s.total / 1000.0
+       << std::setw(12) << s.total / 1000.0 / s.count << std::setw(12)
+       << s.min / 1000.0 << std::setw(12) << s.max / 1000.0 << std::setw(14)
+       << s.bytes << '\n';
+  }
+
+  os.flags(old_flags);
+  os.precision(old_precision);
+}
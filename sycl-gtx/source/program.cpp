@@ -1,7 +1,10 @@
 #include "SYCL/program.h"
 
+#include "SYCL/detail/binary_cache.h"
 #include "SYCL/detail/debug.h"
+#include "SYCL/detail/kernel_cache.h"
 #include "SYCL/kernel.h"
+#include "SYCL/kernel_optimizer.h"
 #include "SYCL/queue.h"
 
 using namespace cl::sycl;
@@ -20,13 +23,13 @@ program::program(const context& context, cl_program clProgram)
     : program(clProgram, context, context.get_devices()) {}
 
 void program::compile(string_class compile_options, ::size_t kernel_name_id,
-                      shared_ptr_class<kernel> kern) {
+                      shared_ptr_class<kernel> kern, unsigned passes) {
   kernels.emplace(kernel_name_id, kern);
   auto& src = kern->src;
-  auto code = src.get_code();
+  auto code = src.get_optimized_code(passes);
 
-  debug() << "Compiled kernel:";
-  debug() << code;
+  SYCL_LOG(debug, codegen) << "Compiled kernel:";
+  SYCL_LOG(debug, codegen) << code;
 
   const char* code_p = code.c_str();
   ::size_t length = code.size();
@@ -40,16 +43,19 @@ void program::compile(string_class compile_options, ::size_t kernel_name_id,
 
   auto device_pointers = detail::get_cl_array(devices);
 
+  detail::runtime_recorder::timer timing(runtime_phase::compile);
   error_code = clCompileProgram(kern->prog.get()->get(),
                                 static_cast<::cl_uint>(devices.size()),
                                 device_pointers.data(), compile_options.c_str(),
                                 0, nullptr, nullptr, nullptr, nullptr);
+  timing.stop();
 
   try {
     detail::error::report(error_code);
   } catch (::cl::sycl::exception& e) {
-    debug() << "Error while compiling kernel" << kern->src.get_kernel_name()
-            << "->";
+    SYCL_LOG(error, codegen)
+        << "Error while compiling kernel" << kern->src.get_kernel_name()
+        << "->";
     for (auto& d : devices) {
       report_compile_error(kern, d);
     }
@@ -57,6 +63,106 @@ void program::compile(string_class compile_options, ::size_t kernel_name_id,
   }
 }
 
+bool program::build_from_binaries(
+    const vector_class<vector_class<unsigned char>>& binaries,
+    const string_class& kernel_name, const string_class& build_options,
+    shared_ptr_class<kernel> kern) {
+  if (binaries.size() != devices.size()) {
+    return false;
+  }
+
+  vector_class<::size_t> lengths;
+  vector_class<const unsigned char*> binary_pointers;
+  for (auto& binary : binaries) {
+    lengths.push_back(binary.size());
+    binary_pointers.push_back(binary.data());
+  }
+
+  auto device_pointers = detail::get_cl_array(devices);
+  auto num_devices = static_cast<::cl_uint>(devices.size());
+  ::cl_int error_code;
+
+  detail::refc<cl_program, clRetainProgram, clReleaseProgram> binary_prog =
+      clCreateProgramWithBinary(ctx.get(), num_devices, device_pointers.data(),
+                                lengths.data(), binary_pointers.data(), nullptr,
+                                &error_code);
+  if (error_code != CL_SUCCESS) {
+    return false;
+  }
+  binary_prog.release_one();
+
+  // Binaries might be rejected by a driver update
+  detail::runtime_recorder::timer timing(runtime_phase::compile);
+  error_code =
+      clBuildProgram(binary_prog.get(), num_devices, device_pointers.data(),
+                     build_options.c_str(), nullptr, nullptr);
+  timing.stop();
+  if (error_code != CL_SUCCESS) {
+    return false;
+  }
+
+  cl_kernel k =
+      clCreateKernel(binary_prog.get(), kernel_name.c_str(), &error_code);
+  if (error_code != CL_SUCCESS) {
+    return false;
+  }
+
+  kern->set(ctx, binary_prog.get());
+  kern->set(k);
+  kern->kern.release_one();
+  prog = binary_prog;
+  return true;
+}
+
+void program::build(string_class build_options, ::size_t kernel_name_id,
+                    shared_ptr_class<kernel> kern) {
+  using detail::binary_cache;
+  using detail::kernel_cache;
+
+  // Keyed on the traced code, the passes only run when the kernel is compiled
+  auto code = kern->src.get_code();
+  // Read once, the passes could change while the kernel is compiled
+  auto passes = kernel_optimizer::get_passes();
+  auto options =
+      build_options + '\n' + detail::get_string<unsigned>::get(passes);
+  auto key = kernel_cache::get_key(ctx, devices, options, code);
+  kernel_cache::entry cached;
+
+  if (kernel_cache::find(key, cached)) {
+    kern->src.release_ir();
+    SYCL_LOG(debug, codegen)
+        << "Reusing cached kernel" << kern->src.get_kernel_name();
+    kernels.emplace(kernel_name_id, kern);
+    kern->set(ctx, cached.prog.get());
+    kern->set(cached.kern.get());
+    prog = cached.prog;
+    linked = true;
+    return;
+  }
+
+  auto binary_key = binary_cache::get_key(devices, options, code);
+  binary_cache::entry binary;
+
+  if (binary_cache::load(binary_key, binary) &&
+      build_from_binaries(binary.binaries, binary.kernel_name, build_options,
+                          kern)) {
+    SYCL_LOG(debug, codegen)
+        << "Loaded cached binary for kernel" << kern->src.get_kernel_name();
+    kern->src.release_ir();
+    kernels.emplace(kernel_name_id, kern);
+    linked = true;
+  } else {
+    compile(build_options, kernel_name_id, kern, passes);
+    link();
+    if (binary_cache::is_enabled()) {
+      binary_cache::store(binary_key,
+                          {kern->src.get_kernel_name(), get_binaries()});
+    }
+  }
+
+  kernel_cache::insert(key, {prog, kern->kern});
+}
+
 void program::report_compile_error(shared_ptr_class<kernel> kern,
                                    device& dev) const {
   // http://stackoverflow.com/a/9467325/793006
@@ -73,9 +179,9 @@ void program::report_compile_error(shared_ptr_class<kernel> kern,
   clGetProgramBuildInfo(kern->prog.get()->get(), dev.get(),
                         CL_PROGRAM_BUILD_LOG, log_size, log, nullptr);
 
-  debug() << "\tWhile compiling for device"
-          << dev.get_info<info::device::name>() << "->\n"
-          << log;
+  SYCL_LOG(error, codegen) << "\tWhile compiling for device"
+                           << dev.get_info<info::device::name>() << "->\n"
+                           << log;
 
   delete[] log;
 }
@@ -107,6 +213,7 @@ void program::link(string_class linking_options) {
   auto device_pointers = detail::get_cl_array(devices);
   auto program_pointers = get_program_pointers();
   ::cl_int error_code;
+  detail::runtime_recorder::timer timing(runtime_phase::link);
 
   prog =
       clLinkProgram(ctx.get(), static_cast<::cl_uint>(device_pointers.size()),
@@ -120,3 +227,27 @@ void program::link(string_class linking_options) {
 
   linked = true;
 }
+
+vector_class<vector_class<unsigned char>> program::get_binaries() const {
+  auto binary_sizes = get_binary_sizes();
+
+  vector_class<vector_class<unsigned char>> binaries;
+  vector_class<unsigned char*> binary_pointers;
+  binaries.reserve(binary_sizes.size());
+  for (auto bin_size : binary_sizes) {
+    binaries.emplace_back(bin_size);
+    binary_pointers.push_back(binaries.back().data());
+  }
+
+  auto error_code = clGetProgramInfo(
+      prog.get(), CL_PROGRAM_BINARIES,
+      binary_pointers.size() * sizeof(unsigned char*), binary_pointers.data(),
+      nullptr);
+  detail::error::report(error_code);
+
+  return binaries;
+}
+
+vector_class<::size_t> program::get_binary_sizes() const {
+  return get_info<info::program::binary_sizes>();
+}
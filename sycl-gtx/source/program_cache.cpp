@@ -0,0 +1,21 @@
+#include "SYCL/program_cache.h"
+
+#include "SYCL/detail/binary_cache.h"
+
+using namespace cl::sycl;
+
+void program_cache::set_directory(string_class dir) {
+  detail::binary_cache::set_directory(std::move(dir));
+}
+
+string_class program_cache::get_directory() {
+  return detail::binary_cache::get_directory();
+}
+
+void program_cache::export_bundle(const string_class& file_name) {
+  detail::binary_cache::export_bundle(file_name);
+}
+
+void program_cache::import_bundle(const string_class& file_name) {
+  detail::binary_cache::import_bundle(file_name);
+}
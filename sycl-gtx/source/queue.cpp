@@ -1,45 +1,63 @@
 #include "SYCL/queue.h"
 
 #include "SYCL/buffer_base.h"
+#include "SYCL/profiler.h"
 
 using namespace cl::sycl;
 
 void queue::display_device_info() const {
-  debug printLine;
-  debug() << "Queue device information:";
-  debug() << dev.get_info<info::device::name>();
-  debug() << dev.get_info<info::device::opencl_version>();
-  debug() << dev.get_info<info::device::profile>();
-  debug() << dev.get_info<info::device::device_version>();
-  debug() << dev.get_info<info::device::driver_version>();
-  debug();
-}
-
-cl_command_queue queue::create_queue(bool display_info,
-                                     bool register_with_synchronizer,
-                                     info::queue_profiling enable_profiling) {
+  using namespace detail::logging;
+  if (!enabled(level::info, category::runtime)) {
+    return;
+  }
+  debug(level::info, category::runtime);
+  debug(level::info, category::runtime) << "Queue device information:";
+  debug(level::info, category::runtime) << dev.get_info<info::device::name>();
+  debug(level::info, category::runtime)
+      << dev.get_info<info::device::opencl_version>();
+  debug(level::info, category::runtime)
+      << dev.get_info<info::device::profile>();
+  debug(level::info, category::runtime)
+      << dev.get_info<info::device::device_version>();
+  debug(level::info, category::runtime)
+      << dev.get_info<info::device::driver_version>();
+  debug(level::info, category::runtime);
+}
+
+cl_command_queue queue::create_queue(
+    bool display_info, info::queue_profiling enable_profiling,
+    info::queue_out_of_order enable_out_of_order) {
   if (display_info) {
     display_device_info();
   }
 
-  ::cl_int error_code;
-  auto q = clCreateCommandQueue(
-      ctx.get(), dev.get(), (enable_profiling ? CL_QUEUE_PROFILING_ENABLE : 0),
-      &error_code);
-  detail::error::report(error_code);
+  cl_command_queue_properties properties = 0;
+  // The profiler needs the timestamps of all commands
+  if (enable_profiling || profiler::is_enabled()) {
+    properties |= CL_QUEUE_PROFILING_ENABLE;
+  }
 
-  if (register_with_synchronizer) {
-    detail::synchronizer::add(this);
+  if (enable_out_of_order) {
+    auto supported = dev.get_info<info::device::queue_properties>();
+    out_of_order = (supported & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) != 0;
+    if (out_of_order) {
+      properties |= CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
+    } else {
+      debug::warning("Out-of-order execution not supported by the device");
+    }
   }
 
+  ::cl_int error_code;
+  auto q = clCreateCommandQueue(ctx.get(), dev.get(), properties, &error_code);
+  detail::error::report(error_code);
+
   return q;
 }
 
 queue::queue(const async_handler& asyncHandler)
     : ctx(asyncHandler),
       dev(ctx.get_devices()[0]),
-      command_q(create_queue()),
-      command_group(this) {
+      command_q(create_queue()) {
   command_q.release_one();
 }
 
@@ -47,8 +65,7 @@ queue::queue(const device_selector& deviceSelector,
              const async_handler& asyncHandler)
     : ctx(deviceSelector, false, asyncHandler),
       dev(ctx.get_devices()[0]),
-      command_q(create_queue()),
-      command_group(this) {
+      command_q(create_queue()) {
   command_q.release_one();
 }
 
@@ -59,8 +76,7 @@ queue::queue(const context& syclContext, const device_selector& deviceSelector,
     // device
     : ctx(syclContext.get(), asyncHandler),
       dev(deviceSelector.select_device(ctx.get_devices())),
-      command_q(create_queue()),
-      command_group(this) {
+      command_q(create_queue()) {
   command_q.release_one();
 }
 
@@ -73,10 +89,15 @@ queue::queue(const context& syclContext, const device& syclDevice,
 queue::queue(const context& syclContext, const device& syclDevice,
              info::queue_profiling profilingFlag,
              const async_handler& asyncHandler)
+    : queue(syclContext, syclDevice, profilingFlag, false, asyncHandler) {}
+
+queue::queue(const context& syclContext, const device& syclDevice,
+             info::queue_profiling profilingFlag,
+             info::queue_out_of_order outOfOrderFlag,
+             const async_handler& asyncHandler)
     : ctx(syclContext.get(), asyncHandler),
       dev(syclDevice),
-      command_q(create_queue(profilingFlag)),
-      command_group(this) {
+      command_q(create_queue(true, profilingFlag, outOfOrderFlag)) {
   command_q.release_one();
 }
 
@@ -84,8 +105,7 @@ queue::queue(const context& syclContext, const device& syclDevice,
 queue::queue(const device& syclDevice, const async_handler& asyncHandler)
     : ctx(syclDevice, false, asyncHandler),
       dev(syclDevice),
-      command_q(create_queue()),
-      command_group(this) {
+      command_q(create_queue()) {
   command_q.release_one();
 }
 
@@ -94,17 +114,18 @@ queue::queue(const device& syclDevice, const async_handler& asyncHandler)
  * At construction it does a retain on the queue memory object.
  */
 queue::queue(cl_command_queue clQueue, const async_handler& asyncHandler)
-    : command_q(clQueue), command_group(this) {
+    : command_q(clQueue) {
   display_device_info();
 
   ctx = context(get_info<info::queue::context>(), asyncHandler);
   dev = device(get_info<info::queue::device>());
-
-  detail::synchronizer::add(this);
+  out_of_order = (get_info<info::queue::properties>() &
+                  CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) != 0;
 }
 
 queue::~queue() {
-  detail::synchronizer::remove(this);
+  detail::task_graph::dispatch();
+  detail::task_graph::remove_queue(this);
   wait_and_throw();
 }
 
@@ -120,6 +141,10 @@ context queue::get_context() const {
   return ctx;
 }
 
+runtime_stats queue::get_runtime_stats() const {
+  return recorder ? recorder->get() : runtime_stats();
+}
+
 device queue::get_device() const {
   return dev;
 }
@@ -138,77 +163,16 @@ void queue::throw_asynchronous() {
 
 void queue::wait() {
   finish();
-  wait_subqueues(false);
 }
 
 void queue::wait_and_throw() {
   finish();
-  wait_subqueues(true);
   throw_asynchronous();
 }
 
-void queue::flush() {
-  for (auto& q : subqueues) {
-    q.process(buffers_in_use);
-  }
-}
-
 void queue::finish() {
   if (command_q.get() != nullptr) {
     auto error_code = clFinish(command_q.get());
     detail::error::report(error_code);
   }
 }
-
-void queue::wait_subqueues(bool and_throw) {
-  for (auto& q : subqueues) {
-    if (and_throw) {
-      q.wait_and_throw();
-    } else {
-      q.wait();
-    }
-  }
-}
-
-handler_event queue::process(buffer_set& buffers_in_use_master) {
-  if (is_flushed ||
-      !detail::synchronizer::can_flush(command_group.read_buffers) ||
-      !detail::synchronizer::can_flush(command_group.write_buffers)) {
-    // TODO(progtx):
-    return handler_event();
-  }
-  command_group.optimize();
-  command_group.flush(
-      get_wait_events(command_group.read_buffers, buffers_in_use_master));
-  buffers_in_use_master.insert(command_group.write_buffers.begin(),
-                               command_group.write_buffers.end());
-  is_flushed = true;
-  return handler_event();
-}
-
-vector_class<cl_event> queue::get_wait_events(const buffer_set& dependencies,
-                                              buffer_set& buffers_in_use) {
-  vector_class<cl_event> wait_events;
-  vector_class<decltype(buffers_in_use.begin())> remove_dependencies;
-
-  for (auto&& buf : dependencies) {
-    auto buf_it = buffers_in_use.find(buf);
-    if (buf_it != buffers_in_use.end()) {
-      auto size = buf->events.size();
-      if (size == 0) {
-        remove_dependencies.push_back(buf_it);
-      } else {
-        wait_events.reserve(wait_events.size() + size);
-        for (auto& ev : buf->events) {
-          wait_events.push_back(ev.get());
-        }
-      }
-    }
-  }
-
-  for (auto& buf_it : remove_dependencies) {
-    buffers_in_use.erase(buf_it);
-  }
-
-  return wait_events;
-}
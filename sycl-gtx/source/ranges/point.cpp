@@ -7,3 +7,5 @@ const string_class point_names::id_global = "_sycl_gid";
 const string_class point_names::range_global = "_sycl_grange";
 const string_class point_names::id_local = "_sycl_lid";
 const string_class point_names::range_local = "_sycl_lrange";
+const string_class point_names::id_group = "_sycl_group";
+const string_class point_names::range_group = "_sycl_ngroups";
@@ -0,0 +1,116 @@
+#include "SYCL/runtime_stats.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+using namespace cl::sycl;
+using namespace detail;
+
+static const char* const phase_names[runtime_phase_count] = {
+    "trace", "codegen", "compile", "link", "optimize", "enqueue", "flush"};
+
+runtime_phase_stats runtime_stats::total(runtime_phase phase) const {
+  runtime_phase_stats sum;
+  for (auto& k : kernels) {
+    auto& p = k.second[static_cast<::size_t>(phase)];
+    sum.count += p.count;
+    sum.total += p.total;
+    sum.max = std::max(sum.max, p.max);
+  }
+  return sum;
+}
+
+void runtime_stats::print(std::ostream& os) const {
+  ::size_t name_width = 6;
+  for (auto& k : kernels) {
+    name_width = std::max(name_width, k.first.size());
+  }
+
+  auto old_flags = os.flags();
+  auto old_precision = os.precision();
+
+  os << std::left << std::setw(name_width) << "kernel" << std::right;
+  for (auto name : phase_names) {
+    os << std::setw(12) << name;
+  }
+  os << "   [us]\n" << std::fixed << std::setprecision(1);
+
+  auto print_row = [&](const string_class& name, const phases& row) {
+    os << std::left << std::setw(name_width) << name << std::right;
+    for (auto& p : row) {
+      os << std::setw(12) << p.total.count() / 1000.0;
+    }
+    os << '\n';
+  };
+
+  phases sum;
+  for (auto& k : kernels) {
+    print_row(k.first.empty() ? "-" : k.first, k.second);
+  }
+  for (::size_t i = 0; i < runtime_phase_count; ++i) {
+    sum[i] = total(static_cast<runtime_phase>(i));
+  }
+  print_row("total", sum);
+
+  os.flags(old_flags);
+  os.precision(old_precision);
+}
+
+const char* const runtime_recorder::environment_variable =
+    "SYCL_GTX_RUNTIME_STATS";
+
+runtime_recorder::~runtime_recorder() {
+  if (std::getenv(environment_variable) != nullptr && !stats.kernels.empty()) {
+    stats.print(std::cerr);
+  }
+}
+
+void runtime_recorder::add(const string_class& kernel, runtime_phase phase,
+                           clock::duration elapsed) {
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+  std::lock_guard<mutex_class> guard(lock);
+  auto& p = stats.kernels[kernel][static_cast<::size_t>(phase)];
+  ++p.count;
+  p.total += ns;
+  p.max = std::max(p.max, ns);
+}
+
+runtime_stats runtime_recorder::get() {
+  std::lock_guard<mutex_class> guard(lock);
+  return stats;
+}
+
+SYCL_THREAD_LOCAL runtime_recorder::scope* runtime_recorder::scope::current =
+    nullptr;
+
+runtime_recorder::scope::scope() : previous(current) {
+  elapsed.fill(clock::duration::zero());
+  measured.fill(false);
+  current = this;
+}
+
+runtime_recorder::scope::~scope() {
+  current = previous;
+}
+
+void runtime_recorder::scope::add(runtime_phase phase, clock::duration time) {
+  if (current != nullptr) {
+    auto i = static_cast<::size_t>(phase);
+    current->elapsed[i] += time;
+    current->measured[i] = true;
+  }
+}
+
+void runtime_recorder::scope::commit(runtime_recorder* recorder,
+                                     const string_class& kernel) {
+  if (recorder == nullptr) {
+    return;
+  }
+  for (::size_t i = 0; i < runtime_phase_count; ++i) {
+    if (measured[i]) {
+      recorder->add(kernel, static_cast<runtime_phase>(i), elapsed[i]);
+    }
+  }
+}
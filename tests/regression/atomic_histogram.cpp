@@ -0,0 +1,97 @@
+#include "../common.h"
+
+// Histogram counted with local atomics, merged into global memory atomically
+
+using namespace cl::sycl;
+
+int main() {
+  static const int bins = 16;
+
+  {
+    queue myQueue;
+
+    const auto group_size = std::min<size_t>(
+        myQueue.get_device().get_info<info::device::max_work_group_size>(),
+        64);
+    const size_t groups = 32;
+    const size_t N = groups * group_size;
+
+    buffer<int> input(N);
+    buffer<int> histogram(bins);
+    buffer<int> maximum(1);
+    {
+      auto ih = input.get_access<access::mode::discard_write,
+                                 access::target::host_buffer>();
+      for (size_t i = 0; i < N; ++i) {
+        ih[i] = static_cast<int>((i * 7) % 1000);
+      }
+      auto hh = histogram.get_access<access::mode::discard_write,
+                                     access::target::host_buffer>();
+      for (int i = 0; i < bins; ++i) {
+        hh[i] = 0;
+      }
+      auto mh = maximum.get_access<access::mode::discard_write,
+                                   access::target::host_buffer>();
+      mh[0] = 0;
+    }
+
+    myQueue.submit([&](handler& cgh) {
+      auto in = input.get_access<access::mode::read>(cgh);
+      auto hist = histogram.get_access<access::mode::atomic>(cgh);
+      auto max_value = maximum.get_access<access::mode::atomic>(cgh);
+      auto counts =
+          accessor<int, 1, access::mode::atomic, access::target::local>(bins,
+                                                                        cgh);
+
+      cgh.parallel_for<class atomic_histogram>(
+          nd_range<1>(N, group_size), [=](nd_item<1> index) {
+            auto gid = index.get_global(0);
+            auto lid = index.get_local(0);
+
+            SYCL_IF(lid < bins) {
+              counts[lid].store(0);
+            }
+            SYCL_END;
+            index.barrier(access::fence_space::local_space);
+
+            int1 value = in[gid];
+            counts[value % bins].fetch_add(1);
+            max_value[0].fetch_max(value);
+            index.barrier(access::fence_space::local_space);
+
+            SYCL_IF(lid < bins) {
+              hist[lid].fetch_add(counts[lid].load());
+            }
+            SYCL_END;
+          });
+    });
+
+    auto ih =
+        input.get_access<access::mode::read, access::target::host_buffer>();
+    int expected[bins] = {};
+    int expected_max = 0;
+    for (size_t i = 0; i < N; ++i) {
+      ++expected[ih[i] % bins];
+      expected_max = std::max(expected_max, static_cast<int>(ih[i]));
+    }
+
+    auto hh =
+        histogram.get_access<access::mode::read, access::target::host_buffer>();
+    for (int i = 0; i < bins; ++i) {
+      if (hh[i] != expected[i]) {
+        debug() << "bin" << i << "expected" << expected[i] << "actual"
+                << hh[i];
+        return 1;
+      }
+    }
+
+    auto mh =
+        maximum.get_access<access::mode::read, access::target::host_buffer>();
+    if (mh[0] != expected_max) {
+      debug() << "expected maximum" << expected_max << "actual" << mh[0];
+      return 1;
+    }
+  }
+
+  return 0;
+}
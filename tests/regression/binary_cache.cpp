@@ -0,0 +1,171 @@
+#include "../common.h"
+#include <SYCL/detail/binary_cache.h>
+#include <SYCL/detail/kernel_cache.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+// Kernels built again from the binaries on disk,
+// changing the source of a kernel invalidates its binary
+// and a damaged binary is a cache miss
+
+using namespace cl::sycl;
+
+// Not captured by the kernel, so it is written into the source as a literal
+static int salt = 1;
+
+static int run(queue& q) {
+  buffer<int> out(1);
+  q.submit([&](handler& cgh) {
+    auto o = out.get_access<access::mode::discard_write>(cgh);
+    cgh.single_task<class salted>([=]() { o[0] = salt; });
+  });
+  auto h = out.get_access<access::mode::read, access::target::host_buffer>();
+  return h[0];
+}
+
+// A fresh cache directory, removed together with its files at the end
+class temp_directory {
+ public:
+  std::string path;
+
+  temp_directory() {
+#ifdef _WIN32
+    char base[MAX_PATH];
+    GetTempPathA(MAX_PATH, base);
+    path = std::string(base) + "sycl_gtx_binary_cache_" +
+           std::to_string(GetCurrentProcessId());
+    if (_mkdir(path.c_str()) != 0) {
+      path.clear();
+    }
+#else
+    auto base = std::getenv("TMPDIR");
+    std::string pattern =
+        std::string(base != nullptr ? base : "/tmp") + "/sycl_gtx_cache_XXXXXX";
+    std::vector<char> name(pattern.begin(), pattern.end());
+    name.push_back('\0');
+    if (mkdtemp(name.data()) != nullptr) {
+      path = name.data();
+    }
+#endif
+  }
+
+  std::vector<std::string> files() const {
+    std::vector<std::string> result;
+#ifdef _WIN32
+    WIN32_FIND_DATAA found;
+    auto handle = FindFirstFileA((path + "\\*").c_str(), &found);
+    if (handle == INVALID_HANDLE_VALUE) {
+      return result;
+    }
+    do {
+      if ((found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+        result.push_back(path + '/' + found.cFileName);
+      }
+    } while (FindNextFileA(handle, &found));
+    FindClose(handle);
+#else
+    auto dir = opendir(path.c_str());
+    if (dir == nullptr) {
+      return result;
+    }
+    while (auto file = readdir(dir)) {
+      std::string name = file->d_name;
+      if (name != "." && name != "..") {
+        result.push_back(path + '/' + name);
+      }
+    }
+    closedir(dir);
+#endif
+    return result;
+  }
+
+  ~temp_directory() {
+    if (path.empty()) {
+      return;
+    }
+    for (auto& file : files()) {
+      std::remove(file.c_str());
+    }
+#ifdef _WIN32
+    _rmdir(path.c_str());
+#else
+    rmdir(path.c_str());
+#endif
+  }
+};
+
+// Keeps the header, but claims the key is larger than any file
+static void corrupt(const std::string& file_name) {
+  char header[12];
+  {
+    std::ifstream in(file_name, std::ios::binary);
+    in.read(header, sizeof(header));
+  }
+  std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+  out.write(header, sizeof(header));
+  std::uint64_t size = 1ULL << 62;
+  out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+}
+
+int main() {
+  using detail::binary_cache;
+  using detail::kernel_cache;
+
+  temp_directory cache_dir;
+  if (cache_dir.path.empty()) {
+    debug() << "unable to create a temporary cache directory";
+    return 1;
+  }
+  binary_cache::set_directory(cache_dir.path);
+
+  {
+    queue myQueue;
+
+    auto loads = binary_cache::get_disk_loads();
+    if (run(myQueue) != salt || binary_cache::get_disk_loads() != loads) {
+      debug() << "first build was not compiled from source";
+      return 1;
+    }
+
+    // Without the in-memory cache the binary comes from disk
+    kernel_cache::clear();
+    if (run(myQueue) != salt || binary_cache::get_disk_loads() != loads + 1) {
+      debug() << "binary was not loaded from disk";
+      return 1;
+    }
+
+    salt += 1;
+    kernel_cache::clear();
+    auto result = run(myQueue);
+    if (result != salt || binary_cache::get_disk_loads() != loads + 1) {
+      debug() << "changed source expected" << salt << "actual" << result;
+      return 1;
+    }
+
+    for (auto& file : cache_dir.files()) {
+      corrupt(file);
+    }
+    kernel_cache::clear();
+    result = run(myQueue);
+    if (result != salt || binary_cache::get_disk_loads() != loads + 1) {
+      debug() << "damaged binary expected" << salt << "actual" << result;
+      return 1;
+    }
+  }
+
+  binary_cache::set_directory("");
+  return 0;
+}
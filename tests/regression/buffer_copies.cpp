@@ -0,0 +1,68 @@
+#include "../common.h"
+
+#include <vector>
+
+// Copies of a buffer refer to the same data,
+// writes through one copy are seen through the other
+
+using namespace cl::sycl;
+
+int main() {
+  static const size_t N = 1024;
+
+  std::vector<int> data(N);
+  for (size_t i = 0; i < N; ++i) {
+    data[i] = static_cast<int>(i);
+  }
+
+  {
+    queue myQueue;
+
+    buffer<int> original(data.data(), range<1>(N));
+    buffer<int> copy = original;
+
+    myQueue.submit([&](handler& cgh) {
+      auto d = original.get_access<access::mode::read_write>(cgh);
+      cgh.parallel_for<class double_original>(range<1>(N),
+                                              [=](id<1> i) { d[i] *= 2; });
+    });
+    // Has to wait for the kernel on the original
+    myQueue.submit([&](handler& cgh) {
+      auto d = copy.get_access<access::mode::read_write>(cgh);
+      cgh.parallel_for<class increment_copy>(range<1>(N),
+                                             [=](id<1> i) { d[i] += 1; });
+    });
+
+    {
+      auto d = copy.get_access<access::mode::read_write,
+                               access::target::host_buffer>();
+      for (size_t i = 0; i < N; ++i) {
+        int expected = 2 * static_cast<int>(i) + 1;
+        if (d[i] != expected) {
+          debug() << "copy: wrong value at" << i << "should be" << expected
+                  << "- is" << d[i];
+          return 1;
+        }
+        d[i] += 1;
+      }
+    }
+
+    myQueue.submit([&](handler& cgh) {
+      auto d = original.get_access<access::mode::read_write>(cgh);
+      cgh.parallel_for<class triple_original>(range<1>(N),
+                                              [=](id<1> i) { d[i] *= 3; });
+    });
+  }
+
+  // Written back once both copies are gone
+  for (size_t i = 0; i < N; ++i) {
+    int expected = 6 * static_cast<int>(i) + 6;
+    if (data[i] != expected) {
+      debug() << "host: wrong value at" << i << "should be" << expected
+              << "- is" << data[i];
+      return 1;
+    }
+  }
+
+  return 0;
+}
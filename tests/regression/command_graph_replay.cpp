@@ -0,0 +1,160 @@
+#include "../common.h"
+
+#include <chrono>
+#include <vector>
+
+// A time step recorded once and replayed many times
+
+int main() {
+  static const size_t N = 1024;
+  static const int steps = 1000;
+
+  using namespace cl::sycl;
+
+  {
+    queue myQueue;
+
+    buffer<float> position(N);
+    buffer<float> velocity(N);
+    {
+      auto p = position.get_access<access::mode::discard_write,
+                                   access::target::host_buffer>();
+      auto v = velocity.get_access<access::mode::discard_write,
+                                   access::target::host_buffer>();
+      for (size_t i = 0; i < N; ++i) {
+        p[i] = 0;
+        v[i] = static_cast<float>(i);
+      }
+    }
+
+    float dt = 0.5f;
+
+    command_graph step(myQueue);
+    step.submit([&](handler& cgh) {
+      auto v = velocity.get_access<access::mode::read_write>(cgh);
+      cgh.parallel_for<class accelerate>(range<1>(N),
+                                         [=](id<1> i) { v[i] += 1; });
+    });
+    step.submit([&](handler& cgh) {
+      auto p = position.get_access<access::mode::read_write>(cgh);
+      auto v = velocity.get_access<access::mode::read>(cgh);
+      cgh.parallel_for<class integrate>(range<1>(N),
+                                        [=](id<1> i) { p[i] += v[i] * dt; });
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; ++s) {
+      step.replay();
+    }
+    myQueue.wait();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    debug() << "Replayed" << steps << "steps in" << elapsed.count() << "s";
+
+    auto p =
+        position.get_access<access::mode::read, access::target::host_buffer>();
+    for (size_t i = 0; i < N; ++i) {
+      // Sum of v + k for k = 1..steps
+      float expected = dt * (steps * static_cast<float>(i) +
+                             steps * (steps + 1) / 2.0f);
+      float diff = p[i] - expected;
+      if (diff * diff > 1e-6f * expected * expected) {
+        debug() << "wrong position at" << i << "should be" << expected
+                << "- is" << p[i];
+        return 1;
+      }
+    }
+  }
+
+  {
+    // A regular submission between recording and the first replay
+    queue myQueue;
+
+    std::vector<int> data(N);
+    for (size_t i = 0; i < N; ++i) {
+      data[i] = static_cast<int>(i);
+    }
+
+    {
+      buffer<int> values(data.data(), range<1>(N));
+
+      command_graph increment(myQueue);
+      increment.submit([&](handler& cgh) {
+        auto v = values.get_access<access::mode::read_write>(cgh);
+        cgh.parallel_for<class graph_increment>(range<1>(N),
+                                                [=](id<1> i) { v[i] += 1; });
+      });
+
+      myQueue.submit([&](handler& cgh) {
+        auto v = values.get_access<access::mode::read_write>(cgh);
+        cgh.parallel_for<class submitted_double>(range<1>(N),
+                                                 [=](id<1> i) { v[i] *= 2; });
+      });
+
+      increment.replay();
+    }
+
+    for (size_t i = 0; i < N; ++i) {
+      int expected = 2 * static_cast<int>(i) + 1;
+      if (data[i] != expected) {
+        debug() << "wrong value at" << i << "should be" << expected << "- is"
+                << data[i];
+        return 1;
+      }
+    }
+  }
+
+  {
+    // Replays with another scalar and with the buffers swapped
+    queue myQueue;
+
+    buffer<float> a(N);
+    buffer<float> b(N);
+    {
+      auto h = a.get_access<access::mode::discard_write,
+                            access::target::host_buffer>();
+      for (size_t i = 0; i < N; ++i) {
+        h[i] = static_cast<float>(i);
+      }
+    }
+
+    float scale = 2;
+
+    command_graph step(myQueue);
+    step.submit([&](handler& cgh) {
+      auto in = a.get_access<access::mode::read>(cgh);
+      auto out = b.get_access<access::mode::discard_write>(cgh);
+      cgh.parallel_for<class ping_pong>(
+          range<1>(N), [=](id<1> i) { out[i] = in[i] * scale; });
+    });
+
+    // b = 2i
+    step.replay();
+
+    // a = 3b = 6i
+    step.rebind(a, b);
+    step.rebind(b, a);
+    step.set_arg(0, 0, 3.0f);
+    step.replay();
+
+    // b = a/2 = 3i
+    step.rebind(a, a);
+    step.rebind(b, b);
+    step.set_arg(0, 0, 0.5f);
+    step.replay();
+
+    auto ha = a.get_access<access::mode::read, access::target::host_buffer>();
+    auto hb = b.get_access<access::mode::read, access::target::host_buffer>();
+    for (size_t i = 0; i < N; ++i) {
+      float expected_a = 6.0f * static_cast<float>(i);
+      float expected_b = 3.0f * static_cast<float>(i);
+      if (ha[i] != expected_a || hb[i] != expected_b) {
+        debug() << "wrong ping-pong values at" << i << "should be"
+                << expected_a << expected_b << "- are" << ha[i] << hb[i];
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
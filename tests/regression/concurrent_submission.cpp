@@ -0,0 +1,110 @@
+#include "../common.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Multiple threads submitting vector additions,
+// both to a shared queue and to their own queues.
+// Submissions to different buffers don't share any lock,
+// so the throughput with their own queues has to scale
+// at least to half of the available cores.
+
+#define LENGTH (1024)
+#define SUBMITS_PER_THREAD (64)
+#define RUNS (3)
+
+using namespace cl::sycl;
+
+// Adds b to a SUBMITS_PER_THREAD times
+static void submit_additions(queue& q, std::vector<int>& h_a,
+                             const std::vector<int>& h_b) {
+  buffer<int> d_a(h_a.data(), range<1>(LENGTH));
+  buffer<int> d_b(h_b.data(), range<1>(LENGTH));
+
+  for (int i = 0; i < SUBMITS_PER_THREAD; ++i) {
+    q.submit([&](handler& cgh) {
+      auto a = d_a.get_access<access::mode::read_write>(cgh);
+      auto b = d_b.get_access<access::mode::read>(cgh);
+
+      cgh.parallel_for<class concurrent_addition>(
+          range<1>(LENGTH), [=](id<> i) { a[i] += b[i]; });
+    });
+  }
+}
+
+// Returns the best throughput of a few runs in submits per second,
+// or 0 if the results are wrong
+static double test(queue& shared, int num_threads, bool use_shared) {
+  std::vector<int> b(LENGTH);
+  for (int i = 0; i < LENGTH; ++i) {
+    b[i] = i;
+  }
+
+  double best = 0;
+  for (int run = 0; run < RUNS; ++run) {
+    std::vector<std::vector<int>> a(num_threads, std::vector<int>(LENGTH));
+
+    auto start = std::chrono::steady_clock::now();
+    {
+      std::vector<std::thread> threads;
+      for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t] {
+          if (use_shared) {
+            submit_additions(shared, a[t], b);
+          } else {
+            queue own;
+            submit_additions(own, a[t], b);
+          }
+        });
+      }
+      for (auto& th : threads) {
+        th.join();
+      }
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = std::max(best,
+                    num_threads * SUBMITS_PER_THREAD / elapsed.count());
+
+    for (int t = 0; t < num_threads; ++t) {
+      for (int i = 0; i < LENGTH; ++i) {
+        if (a[t][i] != i * SUBMITS_PER_THREAD) {
+          debug() << "thread" << t << "index" << i << "expected"
+                  << i * SUBMITS_PER_THREAD << "got" << a[t][i];
+          return 0;
+        }
+      }
+    }
+  }
+
+  std::cout << num_threads << " threads, " << (use_shared ? "shared" : "own")
+            << " queue: " << best << " submits per second" << std::endl;
+  return best;
+}
+
+int main() {
+  queue shared;
+  bool success = true;
+  int cores = std::max(1u, std::thread::hardware_concurrency());
+  double single = 0;
+
+  for (int num_threads = 1; num_threads <= 8; num_threads *= 2) {
+    success = test(shared, num_threads, true) > 0 && success;
+
+    auto own = test(shared, num_threads, false);
+    if (num_threads == 1) {
+      single = own;
+    }
+    auto expected = single * std::min(num_threads, cores) / 2;
+    if (own < expected) {
+      debug() << num_threads << "threads with their own queues reached" << own
+              << "submits per second, expected at least" << expected;
+      success = false;
+    }
+  }
+
+  return static_cast<int>(!success);
+}
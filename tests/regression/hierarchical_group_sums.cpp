@@ -0,0 +1,114 @@
+#include "../common.h"
+
+// Sums of tiles computed with hierarchical parallelism,
+// and work-groups sized by the runtime
+
+using namespace cl::sycl;
+
+int main() {
+  static const size_t groups = 64;
+  static const int tile = 32;
+  static const size_t N = groups * tile;
+
+  {
+    queue myQueue;
+
+    buffer<int> input(N);
+    buffer<int> sums(groups);
+    {
+      auto ih = input.get_access<access::mode::discard_write,
+                                 access::target::host_buffer>();
+      for (size_t i = 0; i < N; ++i) {
+        ih[i] = static_cast<int>(i % 100);
+      }
+    }
+
+    myQueue.submit([&](handler& cgh) {
+      auto in = input.get_access<access::mode::read>(cgh);
+      auto out = sums.get_access<access::mode::discard_write>(cgh);
+      auto scratch =
+          accessor<int, 1, access::mode::read_write, access::target::local>(
+              tile, cgh);
+
+      cgh.parallel_for_work_group<class tile_sums>(
+          range<1>(groups), range<1>(tile), [=](group<1> g) {
+            // Run once per work-group
+            int1 offset = g.get(0) * tile;
+
+            parallel_for_work_item(g, [&](nd_item<1> it) {
+              scratch[it.get_local(0)] = in[offset + it.get_local(0)];
+            });
+
+            int1 sum = 0;
+            SYCL_FOR(int1 i = 0, i < tile, ++i) {
+              sum += scratch[i];
+            }
+            SYCL_END
+            out[g.get(0)] = sum;
+          });
+    });
+
+    auto ih =
+        input.get_access<access::mode::read, access::target::host_buffer>();
+    auto sh =
+        sums.get_access<access::mode::read, access::target::host_buffer>();
+    for (size_t g = 0; g < groups; ++g) {
+      int expected = 0;
+      for (size_t i = 0; i < tile; ++i) {
+        expected += ih[g * tile + i];
+      }
+      if (sh[g] != expected) {
+        debug() << g << "expected" << expected << "actual" << sh[g];
+        return 1;
+      }
+    }
+  }
+
+  {
+    // Without a work-group size, the largest one the kernel allows is used
+    queue myQueue;
+    auto max_size =
+        myQueue.get_device().get_info<info::device::max_work_group_size>();
+
+    buffer<int> sizes(groups);
+    buffer<int> items(groups);
+    {
+      auto ih = items.get_access<access::mode::discard_write,
+                                 access::target::host_buffer>();
+      for (size_t g = 0; g < groups; ++g) {
+        ih[g] = 0;
+      }
+    }
+
+    myQueue.submit([&](handler& cgh) {
+      auto s = sizes.get_access<access::mode::discard_write>(cgh);
+      auto counted = items.get_access<access::mode::atomic>(cgh);
+
+      cgh.parallel_for_work_group<class default_group_size>(
+          range<1>(groups), [=](group<1> g) {
+            s[g.get(0)] = g.get_local_range(0);
+            parallel_for_work_item(
+                g, [&](nd_item<1> it) { counted[g.get(0)].fetch_add(1); });
+          });
+    });
+
+    auto sh =
+        sizes.get_access<access::mode::read, access::target::host_buffer>();
+    auto ih =
+        items.get_access<access::mode::read, access::target::host_buffer>();
+    for (size_t g = 0; g < groups; ++g) {
+      if (sh[g] <= 0 || static_cast<size_t>(sh[g]) > max_size ||
+          sh[g] != sh[0]) {
+        debug() << g << "work-group size" << sh[g] << "device maximum"
+                << max_size;
+        return 1;
+      }
+      if (ih[g] != sh[g]) {
+        debug() << g << "ran" << ih[g] << "work items, expected" << sh[g];
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,194 @@
+#include "../common.h"
+
+#include <SYCL/detail/binary_cache.h>
+#include <SYCL/detail/kernel_cache.h>
+#include <sstream>
+#include <string>
+
+// The same kernel compiled with and without the kernel optimization passes,
+// and the OpenCL C code each pass generates on its own
+
+using namespace cl::sycl;
+using detail::logging::category;
+using detail::logging::level;
+
+static const size_t N = 1024;
+
+static void run(queue& myQueue, buffer<float>& input, buffer<float>& output,
+                int steps) {
+  myQueue.submit([&](handler& cgh) {
+    auto in = input.get_access<access::mode::read>(cgh);
+    auto out = output.get_access<access::mode::discard_write>(cgh);
+
+    cgh.parallel_for<class optimized>(
+        range<1>(input.get_count()), [=](id<1> i) {
+          float1 x = in[i];
+          float1 sum = 0;
+          int1 unused = i[0] * 2;
+          SYCL_FOR(int1 k = 0, k < steps, ++k)
+            sum += (x * x + 1.0f) * k + sqrt(2.0f * 8.0f);
+          SYCL_END
+          int1 copy = steps;
+          out[i] = sum + (x * x + 1.0f) + copy;
+        });
+  });
+}
+
+/** Code of the kernels compiled by submit, taken from the codegen log */
+template <class Submit>
+static std::string compiled_code(const char* passes, Submit submit) {
+  kernel_optimizer::configure(passes);
+  detail::kernel_cache::clear();
+
+  auto& threshold =
+      detail::logging::thresholds[static_cast<int>(category::codegen)];
+  auto previous_level = threshold.load();
+  detail::logging::flush();
+  std::ostringstream log;
+  auto previous_buffer = std::cerr.rdbuf(log.rdbuf());
+  detail::logging::set_level(level::debug, category::codegen);
+
+  submit();
+
+  detail::logging::flush();
+  threshold.store(previous_level);
+  std::cerr.rdbuf(previous_buffer);
+  kernel_optimizer::configure("all");
+  return log.str();
+}
+
+static bool contains(const std::string& code, const char* part) {
+  return code.find(part) != std::string::npos;
+}
+
+/** Whether the pass generated the part, or removed it, unlike no passes */
+static bool check_pass(const char* pass, const char* part,
+                       const std::string& optimized, const std::string& plain,
+                       bool removes) {
+  if (!contains(optimized, "Compiled kernel") ||
+      !contains(plain, "Compiled kernel")) {
+    debug() << pass << "no kernel was compiled";
+    return false;
+  }
+  if (contains(optimized, part) == removes ||
+      contains(plain, part) != removes) {
+    debug() << pass << (removes ? "did not remove" : "did not generate")
+            << part;
+    debug() << optimized;
+    return false;
+  }
+  return true;
+}
+
+static bool check_passes(queue& myQueue, buffer<float>& input,
+                         buffer<float>& output) {
+  auto folding = [&]() {
+    myQueue.submit([&](handler& cgh) {
+      auto in = input.get_access<access::mode::read>(cgh);
+      auto out = output.get_access<access::mode::discard_write>(cgh);
+      cgh.parallel_for<class folding_kernel>(range<1>(N), [=](id<1> i) {
+        float1 three = 3.0f;
+        out[i] = in[i] * (three * 7.0f);
+      });
+    });
+  };
+  if (!check_pass("constant_folding", "21.f",
+                  compiled_code("constant_folding", folding),
+                  compiled_code("none", folding), false)) {
+    return false;
+  }
+
+  auto invariants = [&]() {
+    myQueue.submit([&](handler& cgh) {
+      auto in = input.get_access<access::mode::read>(cgh);
+      auto out = output.get_access<access::mode::discard_write>(cgh);
+      cgh.parallel_for<class invariants_kernel>(range<1>(N), [=](id<1> i) {
+        float1 x = in[i];
+        float1 sum = 0;
+        SYCL_FOR(int1 k = 0, k < 4, ++k)
+          sum += (x * x + 1.0f) * k;
+        SYCL_END
+        out[i] = sum;
+      });
+    });
+  };
+  if (!check_pass("loop_invariants", "_sycl_inv",
+                  compiled_code("loop_invariants", invariants),
+                  compiled_code("none", invariants), false)) {
+    return false;
+  }
+
+  auto subexpressions = [&]() {
+    myQueue.submit([&](handler& cgh) {
+      auto in = input.get_access<access::mode::read>(cgh);
+      auto out = output.get_access<access::mode::discard_write>(cgh);
+      cgh.parallel_for<class subexpressions_kernel>(range<1>(N), [=](id<1> i) {
+        float1 x = in[i];
+        out[i] = (x * x + 2.0f) * x + (x * x + 2.0f);
+      });
+    });
+  };
+  if (!check_pass("common_subexpressions", "_sycl_cse",
+                  compiled_code("common_subexpressions", subexpressions),
+                  compiled_code("none", subexpressions), false)) {
+    return false;
+  }
+
+  auto dead = [&]() {
+    myQueue.submit([&](handler& cgh) {
+      auto in = input.get_access<access::mode::read>(cgh);
+      auto out = output.get_access<access::mode::discard_write>(cgh);
+      cgh.parallel_for<class dead_kernel>(range<1>(N), [=](id<1> i) {
+        int1 unused = i[0] * 12345;
+        out[i] = in[i];
+      });
+    });
+  };
+  return check_pass("dead_code", "12345", compiled_code("dead_code", dead),
+                    compiled_code("none", dead), true);
+}
+
+int main() {
+  static const int steps = 5;
+
+  {
+    queue myQueue;
+
+    buffer<float> input(N);
+    buffer<float> optimized(N);
+    buffer<float> plain(N);
+    {
+      auto ih = input.get_access<access::mode::discard_write,
+                                 access::target::host_buffer>();
+      for (size_t i = 0; i < N; ++i) {
+        ih[i] = static_cast<float>(i % 32) / 8;
+      }
+    }
+
+    kernel_optimizer::configure("all");
+    run(myQueue, input, optimized, steps);
+    kernel_optimizer::configure("none");
+    run(myQueue, input, plain, steps);
+    kernel_optimizer::configure("all");
+
+    {
+      auto oh = optimized.get_access<access::mode::read,
+                                     access::target::host_buffer>();
+      auto ph =
+          plain.get_access<access::mode::read, access::target::host_buffer>();
+      for (size_t i = 0; i < N; ++i) {
+        if (std::abs(oh[i] - ph[i]) > 1e-3f * std::abs(ph[i])) {
+          debug() << i << "expected" << ph[i] << "actual" << oh[i];
+          return 1;
+        }
+      }
+    }
+
+    detail::binary_cache::set_directory("");
+    if (!check_passes(myQueue, input, plain)) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
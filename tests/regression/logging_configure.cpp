@@ -0,0 +1,68 @@
+#include "../common.h"
+
+#include <initializer_list>
+
+// Parsing of SYCL_GTX_LOG configurations
+
+using namespace cl::sycl::detail;
+using logging::category;
+using logging::level;
+
+struct expectation {
+  level l;
+  category c;
+  bool enabled;
+};
+
+static const char* failure = nullptr;
+
+static void check(const char* config, std::initializer_list<expectation> list) {
+  for (auto& e : list) {
+    if (failure == nullptr && logging::enabled(e.l, e.c) != e.enabled) {
+      failure = config;
+    }
+  }
+}
+
+int main() {
+  logging::configure("info");
+  check("info", {{level::info, category::runtime, true},
+                 {level::info, category::sync, true},
+                 {level::debug, category::codegen, false},
+                 {level::error, category::transfers, true}});
+
+  logging::configure("warning;trace:sync,transfers");
+  check("warning;trace:sync,transfers",
+        {{level::warning, category::runtime, true},
+         {level::info, category::runtime, false},
+         {level::info, category::codegen, false},
+         {level::trace, category::sync, true},
+         {level::trace, category::transfers, true}});
+
+  // Later entries override earlier ones, empty entries are skipped
+  logging::configure("trace;;off:codegen");
+  check("trace;;off:codegen", {{level::trace, category::runtime, true},
+                               {level::error, category::codegen, false}});
+
+  // Unknown names are reported and skipped, the rest still applies
+  logging::configure("error;verbose;debug:codegen,nothing");
+  check("error;verbose;debug:codegen,nothing",
+        {{level::warning, category::runtime, false},
+         {level::error, category::runtime, true},
+         {level::debug, category::codegen, true},
+         {level::trace, category::codegen, false}});
+
+  // Lines queued for the writer thread are written by flush
+  logging::configure("debug");
+  for (int i = 0; i < 100; ++i) {
+    debug() << "logging_configure line" << i;
+  }
+  logging::flush();
+
+  if (failure != nullptr) {
+    debug() << "wrong levels after configuring" << failure;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,72 @@
+#include "../common.h"
+
+// Device memory of a destroyed buffer is reused by the next buffer
+// of the same size
+
+using namespace cl::sycl;
+
+static const size_t W = 16;
+static const size_t H = 64;
+static const size_t block_width = 4;
+
+// Part of each row, so the sub-buffer always gets pooled memory of its own
+static void fill_block(queue& q, buffer<int, 2>& data, size_t x, int value) {
+  buffer<int, 2> block(data, id<2>(x, 0), range<2>(block_width, H));
+  q.submit([&](handler& cgh) {
+    auto b = block.get_access<access::mode::discard_write>(cgh);
+    cgh.parallel_for<class fill_pooled_block>(range<2>(block_width, H),
+                                              [=](id<2> i) { b[i] = value; });
+  });
+}
+
+int main() {
+  {
+    queue myQueue;
+
+    buffer<int, 2> data(range<2>(W, H));
+    {
+      auto d = data.get_access<access::mode::discard_write,
+                               access::target::host_buffer>();
+      for (size_t x = 0; x < W; ++x) {
+        for (size_t y = 0; y < H; ++y) {
+          d[x][y] = 0;
+        }
+      }
+    }
+
+    auto before = memory_pool::get_stats();
+    fill_block(myQueue, data, 0, 1);
+    auto freed = memory_pool::get_stats();
+    if (freed.recycled != before.recycled + 1) {
+      debug() << "destroyed block recycled" << freed.recycled - before.recycled
+              << "memory objects";
+      return 1;
+    }
+
+    fill_block(myQueue, data, 2 * block_width, 2);
+    auto reused = memory_pool::get_stats();
+    if (reused.hits != freed.hits + 1) {
+      debug() << "block of the same size reused" << reused.hits - freed.hits
+              << "memory objects";
+      return 1;
+    }
+
+    auto d = data.get_access<access::mode::read, access::target::host_buffer>();
+    for (size_t x = 0; x < W; ++x) {
+      for (size_t y = 0; y < H; ++y) {
+        int expected = 0;
+        if (x < block_width) {
+          expected = 1;
+        } else if (x >= 2 * block_width && x < 3 * block_width) {
+          expected = 2;
+        }
+        if (d[x][y] != expected) {
+          debug() << x << y << "expected" << expected << "actual" << d[x][y];
+          return 1;
+        }
+      }
+    }
+  }
+
+  return 0;
+}
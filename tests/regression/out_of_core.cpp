@@ -0,0 +1,80 @@
+#include "../common.h"
+
+// Vector addition processed in chunks, as if the device were small
+
+using namespace cl::sycl;
+
+int main() {
+  static const size_t N = 1 << 20;
+
+  {
+    queue first;
+    queue second;
+
+    buffer<float> a(N);
+    buffer<float> b(N);
+    buffer<float> c(N);
+    {
+      auto ah = a.get_access<access::mode::discard_write,
+                             access::target::host_buffer>();
+      auto bh = b.get_access<access::mode::discard_write,
+                             access::target::host_buffer>();
+      for (size_t i = 0; i < N; ++i) {
+        ah[i] = static_cast<float>(i);
+        bh[i] = static_cast<float>(2 * i);
+      }
+    }
+
+    out_of_core ooc(first, second);
+    ooc.set_chunk_size(N / 8);
+    ooc.submit(range<1>(N), 3 * sizeof(float),
+               [&](handler& cgh, out_of_core_chunk<1>& chunk) {
+                 auto ka = chunk.get_access<access::mode::read>(cgh, a);
+                 auto kb = chunk.get_access<access::mode::read>(cgh, b);
+                 auto kc = chunk.get_access<access::mode::write>(cgh, c);
+                 cgh.parallel_for<class chunked_add>(
+                     chunk.get_range(),
+                     [=](id<1> i) { kc[i] = ka[i] + kb[i]; });
+               });
+
+    {
+      auto ch =
+          c.get_access<access::mode::read, access::target::host_buffer>();
+      for (size_t i = 0; i < N; ++i) {
+        auto expected = static_cast<float>(3 * i);
+        if (ch[i] != expected) {
+          debug() << i << "expected" << expected << "actual" << ch[i];
+          return 1;
+        }
+      }
+    }
+
+    // A regular kernel between two passes with chunks sized for the device,
+    // the second pass has to see its result
+    first.submit([&](handler& cgh) {
+      auto kc = c.get_access<access::mode::read_write>(cgh);
+      cgh.parallel_for<class double_between_passes>(
+          range<1>(N), [=](id<1> i) { kc[i] *= 2; });
+    });
+
+    out_of_core sized(first, second);
+    sized.submit(range<1>(N), 2 * sizeof(float),
+                 [&](handler& cgh, out_of_core_chunk<1>& chunk) {
+                   auto ka = chunk.get_access<access::mode::read>(cgh, a);
+                   auto kc = chunk.get_access<access::mode::read_write>(cgh, c);
+                   cgh.parallel_for<class chunked_accumulate>(
+                       chunk.get_range(), [=](id<1> i) { kc[i] += ka[i]; });
+                 });
+
+    auto ch = c.get_access<access::mode::read, access::target::host_buffer>();
+    for (size_t i = 0; i < N; ++i) {
+      auto expected = static_cast<float>(7 * i);
+      if (ch[i] != expected) {
+        debug() << i << "expected" << expected << "actual" << ch[i];
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
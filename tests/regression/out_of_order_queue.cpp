@@ -0,0 +1,67 @@
+#include "../common.h"
+
+// Dependent kernels on an out-of-order queue run in submission order,
+// and each submission returns the event of its kernel
+
+using namespace cl::sycl;
+
+int main() {
+  static const size_t N = 4096;
+  static const int steps = 16;
+
+  {
+    queue inOrder;
+    queue myQueue(inOrder.get_context(), inOrder.get_device(), false, true);
+
+    buffer<int> a(N);
+    buffer<int> b(N);
+    myQueue.submit([&](handler& cgh) {
+      auto pa = a.get_access<access::mode::discard_write>(cgh);
+      cgh.parallel_for<class ooo_init>(range<1>(N),
+                                       [=](id<1> i) { pa[i] = i[0]; });
+    });
+
+    // Doubling and adding don't commute, a wrong order changes the result
+    for (int s = 0; s < steps; ++s) {
+      auto events = myQueue.submit([&](handler& cgh) {
+        auto pa = a.get_access<access::mode::read>(cgh);
+        auto pb = b.get_access<access::mode::discard_write>(cgh);
+        cgh.parallel_for<class ooo_double>(range<1>(N),
+                                           [=](id<1> i) { pb[i] = pa[i] * 2; });
+      });
+      if (s == 0) {
+        auto kernel_event = events.get_kernel();
+        if (kernel_event.get() == nullptr) {
+          debug() << "no kernel event";
+          return 1;
+        }
+        kernel_event.wait();
+        if (kernel_event.get_info<info::event::command_execution_status>() !=
+            CL_COMPLETE) {
+          debug() << "kernel event not complete after waiting";
+          return 1;
+        }
+      }
+      myQueue.submit([&](handler& cgh) {
+        auto pa = a.get_access<access::mode::discard_write>(cgh);
+        auto pb = b.get_access<access::mode::read>(cgh);
+        cgh.parallel_for<class ooo_add>(range<1>(N),
+                                        [=](id<1> i) { pa[i] = pb[i] + 1; });
+      });
+    }
+
+    auto h = a.get_access<access::mode::read, access::target::host_buffer>();
+    for (size_t i = 0; i < N; ++i) {
+      int expected = static_cast<int>(i);
+      for (int s = 0; s < steps; ++s) {
+        expected = expected * 2 + 1;
+      }
+      if (h[i] != expected) {
+        debug() << "index" << i << "expected" << expected << "actual" << h[i];
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,121 @@
+#include "../common.h"
+
+// Buffers passed back and forth between kernels stay on the device,
+// only the host accessor at the end transfers the result
+
+using namespace cl::sycl;
+
+static ::size_t count_transfers() {
+  ::size_t transfers = 0;
+  for (auto& r : profiler::get_records()) {
+    if (r.command == profiler_command::write ||
+        r.command == profiler_command::read ||
+        r.command == profiler_command::copy) {
+      ++transfers;
+    }
+  }
+  return transfers;
+}
+
+int main() {
+  using type_t = float;
+
+  profiler::clear();
+  profiler::enable();
+  {
+    // Has profiling because it is created while the profiler is enabled
+    queue myQueue;
+
+    const auto group_size =
+        myQueue.get_device().get_info<info::device::max_work_group_size>();
+    const auto size = group_size * 4;
+
+    buffer<type_t> ping(size);
+    buffer<type_t> pong(size);
+
+    auto P = &ping;
+    auto Q = &pong;
+
+    myQueue.submit([&](handler& cgh) {
+      auto p = P->get_access<access::mode::discard_write>(cgh);
+      cgh.parallel_for<class ping_pong_init>(
+          range<1>(size), [=](id<1> index) { p[index] = index; });
+    });
+
+    size_t local_size = std::min(group_size, size);
+    int iteration = 0;
+
+    for (size_t N = size; N > 1; N /= local_size) {
+      myQueue.submit([&](handler& cgh) {
+        auto input = P->get_access<access::mode::read>(cgh);
+        auto output = Q->get_access<access::mode::discard_write>(cgh);
+
+        local_size = std::min(local_size, N);
+        auto local =
+            accessor<float, 1, access::mode::read_write, access::target::local>(
+                local_size, cgh);
+
+        cgh.parallel_for<class ping_pong_sum>(
+            nd_range<1>(N / 2, local_size / 2), [=](nd_item<1> index) {
+              auto gid = index.get_global(0);
+              auto lid = index.get_local(0);
+              uint1 N = index.get_global_range().get(0);
+              uint1 second = gid + N;
+
+              SYCL_IF(second < 2 * N) {
+                local[lid] = input[gid] + input[second];
+              }
+              SYCL_END;
+
+              index.barrier(access::fence_space::local_space);
+
+              N = min(N, static_cast<uint1>(index.get_local_range().get(0)));
+
+              uint1 stride = N / 2;
+              SYCL_WHILE(stride > 0) {
+                SYCL_IF(lid < stride) {
+                  local[lid] += local[lid + stride];
+                }
+                SYCL_END;
+                index.barrier(access::fence_space::local_space);
+                stride /= 2;
+              }
+              SYCL_END;
+
+              SYCL_IF(lid == 0) {
+                output[gid / N] = local[0];
+              }
+              SYCL_END;
+            });
+      });
+
+      std::swap(P, Q);
+      ++iteration;
+
+      auto transfers = count_transfers();
+      if (transfers != 0) {
+        debug() << "iteration" << iteration << "caused" << transfers
+                << "transfers";
+        return 1;
+      }
+    }
+
+    auto p = P->get_access<access::mode::read, access::target::host_buffer>();
+    type_t sum =
+        (static_cast<type_t>(size) / 2) * static_cast<type_t>(size - 1);
+    if (p[0] != sum) {
+      debug() << "wrong sum, should be" << sum << "- is" << p[0];
+      return 1;
+    }
+  }
+  profiler::disable();
+
+  // Reading the result maps the buffer on devices sharing memory with the host
+  auto transfers = count_transfers();
+  if (transfers > 1) {
+    debug() << "reading the result caused" << transfers << "transfers";
+    return 1;
+  }
+
+  return 0;
+}
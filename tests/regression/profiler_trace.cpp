@@ -0,0 +1,91 @@
+#include "../common.h"
+
+#include <sstream>
+#include <string>
+
+// Kernels and transfers recorded by the profiler,
+// summarized and exported as a Chrome trace
+
+using namespace cl::sycl;
+
+static bool contains(const std::string& text, const std::string& part) {
+  return text.find(part) != std::string::npos;
+}
+
+int main() {
+  static const size_t N = 1024;
+
+  profiler::clear();
+  profiler::enable();
+  {
+    // Has profiling because it is created while the profiler is enabled
+    queue myQueue;
+
+    buffer<int> data(N);
+    myQueue.submit([&](handler& cgh) {
+      auto d = data.get_access<access::mode::discard_write>(cgh);
+      cgh.parallel_for<class profiled_fill>(range<1>(N),
+                                            [=](id<1> i) { d[i] = i; });
+    });
+    auto d = data.get_access<access::mode::read, access::target::host_buffer>();
+    if (d[N - 1] != static_cast<int>(N - 1)) {
+      debug() << "wrong result" << d[N - 1];
+      return 1;
+    }
+  }
+  profiler::disable();
+
+  ::size_t kernels = 0;
+  for (auto& r : profiler::get_records()) {
+    if (r.command != profiler_command::kernel) {
+      continue;
+    }
+    ++kernels;
+    if (r.end == 0 || r.start > r.end || r.queued > r.start) {
+      debug() << "kernel" << r.name << "has no valid timestamps";
+      return 1;
+    }
+  }
+  if (kernels != 1) {
+    debug() << "recorded" << kernels << "kernels";
+    return 1;
+  }
+
+  auto summary = profiler::get_summary();
+  bool summarized = false;
+  for (auto& s : summary) {
+    if (s.command == profiler_command::kernel) {
+      summarized = (s.count == 1 && s.total == s.min && s.total == s.max);
+    }
+  }
+  if (!summarized) {
+    debug() << "the kernel is missing from the summary";
+    return 1;
+  }
+
+  std::ostringstream trace;
+  profiler::export_chrome_trace(trace);
+  auto json = trace.str();
+  const char* expected[] = {
+      "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", "\"cat\":\"kernel\"",
+      "\"ph\":\"X\"", "\"args\":{\"command\":\"kernel\"",
+      "\"name\":\"thread_name\"", "\"args\":{\"name\":\"queue 0\"}"};
+  for (auto part : expected) {
+    if (!contains(json, part)) {
+      debug() << "the trace is missing" << part;
+      return 1;
+    }
+  }
+  if (json.substr(json.size() - 4) != "\n]}\n") {
+    debug() << "the trace is not terminated";
+    return 1;
+  }
+
+  profiler::clear();
+  if (!profiler::get_records().empty()) {
+    debug() << "clear kept records";
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,51 @@
+#include "../common.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// A queue destroyed while its command group waits for a host accessor
+// of another thread still runs the command group
+
+using namespace cl::sycl;
+
+int main() {
+  static const size_t N = 1024;
+
+  buffer<int> data(N);
+  std::atomic<bool> held(false);
+
+  std::thread holder([&] {
+    auto h = data.get_access<access::mode::discard_write,
+                             access::target::host_buffer>();
+    held = true;
+    // Gives the queue time to be destroyed first
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    for (size_t i = 0; i < N; ++i) {
+      h[i] = static_cast<int>(i);
+    }
+  });
+  while (!held) {
+    std::this_thread::yield();
+  }
+
+  {
+    queue myQueue;
+    myQueue.submit([&](handler& cgh) {
+      auto d = data.get_access<access::mode::read_write>(cgh);
+      cgh.parallel_for<class after_host>(range<1>(N),
+                                         [=](id<1> i) { d[i] += 1; });
+    });
+  }
+  holder.join();
+
+  auto h = data.get_access<access::mode::read, access::target::host_buffer>();
+  for (size_t i = 0; i < N; ++i) {
+    if (h[i] != static_cast<int>(i) + 1) {
+      debug() << "index" << i << "expected" << i + 1 << "actual" << h[i];
+      return 1;
+    }
+  }
+
+  return 0;
+}
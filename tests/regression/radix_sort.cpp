@@ -0,0 +1,141 @@
+#include "../common.h"
+#include <SYCL/algorithm/sort.h>
+
+// Radix sorts of 32-bit and 64-bit integer and floating point keys,
+// with and without values
+
+using namespace cl::sycl;
+
+template <typename T>
+bool check(buffer<T>& data, const std::vector<T>& expected,
+           const char* name) {
+  auto d = data.template get_access<access::mode::read,
+                                    access::target::host_buffer>();
+  for (size_t i = 0; i < expected.size(); ++i) {
+    if (d[i] != expected[i]) {
+      debug() << name << i << "expected" << expected[i] << "actual" << d[i];
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename T>
+bool sort_and_check(queue& q, const std::vector<T>& keys, const char* name) {
+  buffer<T> data(keys.size());
+  {
+    auto d = data.template get_access<access::mode::discard_write,
+                                      access::target::host_buffer>();
+    for (size_t i = 0; i < keys.size(); ++i) {
+      d[i] = keys[i];
+    }
+  }
+  auto expected = keys;
+  std::sort(expected.begin(), expected.end());
+  sort(q, data);
+  return check(data, expected, name);
+}
+
+/** Values are the original positions, equal keys have to keep their order */
+template <typename K, typename V>
+bool sort_by_key_and_check(queue& q, const std::vector<K>& keys,
+                           const char* name) {
+  using entry = std::pair<K, V>;
+  auto n = keys.size();
+  std::vector<entry> pairs(n);
+  buffer<K> key_data(n);
+  buffer<V> value_data(n);
+  {
+    auto kh = key_data.template get_access<access::mode::discard_write,
+                                           access::target::host_buffer>();
+    auto vh = value_data.template get_access<access::mode::discard_write,
+                                             access::target::host_buffer>();
+    for (size_t i = 0; i < n; ++i) {
+      pairs[i] = {keys[i], static_cast<V>(i)};
+      kh[i] = pairs[i].first;
+      vh[i] = pairs[i].second;
+    }
+  }
+  std::stable_sort(pairs.begin(), pairs.end(),
+                   [](const entry& a, const entry& b) {
+                     return a.first < b.first;
+                   });
+  std::vector<K> sorted_keys;
+  std::vector<V> sorted_values;
+  for (auto& p : pairs) {
+    sorted_keys.push_back(p.first);
+    sorted_values.push_back(p.second);
+  }
+
+  sort_by_key(q, key_data, value_data);
+  return check(key_data, sorted_keys, name) &&
+         check(value_data, sorted_values, name);
+}
+
+int main() {
+  // Not a multiple of any work-group size
+  static const size_t N = 100003;
+
+  {
+    queue myQueue;
+
+    std::vector<int> integers(N);
+    std::vector<unsigned int> unsigned_integers(N);
+    std::vector<::cl_long> longs(N);
+    std::vector<float> floats(N);
+    for (size_t i = 0; i < N; ++i) {
+      auto r = static_cast<unsigned int>(i * 2654435761u);
+      integers[i] = static_cast<int>(r);
+      unsigned_integers[i] = r;
+      longs[i] = static_cast<::cl_long>(integers[i]) * (1 << 24) - r % 1000;
+      floats[i] = static_cast<float>(integers[i] % 20000) / 16.0f;
+    }
+    floats[7] = -0.0f;
+    floats[8] = std::numeric_limits<float>::infinity();
+    floats[9] = -std::numeric_limits<float>::infinity();
+
+    if (!sort_and_check(myQueue, integers, "int")) {
+      return 1;
+    }
+    if (!sort_and_check(myQueue, unsigned_integers, "uint")) {
+      return 1;
+    }
+    if (!sort_and_check(myQueue, longs, "long")) {
+      return 1;
+    }
+    if (!sort_and_check(myQueue, floats, "float")) {
+      return 1;
+    }
+
+    if (myQueue.get_device().has_extension("cl_khr_fp64")) {
+      std::vector<double> doubles(N);
+      for (size_t i = 0; i < N; ++i) {
+        doubles[i] = static_cast<double>(longs[i]) / 3.0;
+      }
+      doubles[7] = -0.0;
+      doubles[8] = std::numeric_limits<double>::infinity();
+      doubles[9] = -std::numeric_limits<double>::infinity();
+      if (!sort_and_check(myQueue, doubles, "double")) {
+        return 1;
+      }
+    }
+
+    // Few distinct keys
+    std::vector<int> few(N);
+    std::vector<::cl_long> few_longs(N);
+    for (size_t i = 0; i < N; ++i) {
+      few[i] = integers[i] % 100;
+      // Only the upper 32 bits tell the keys apart
+      few_longs[i] = few[i] * (::cl_long(1) << 32);
+    }
+    if (!sort_by_key_and_check<int, unsigned int>(myQueue, few, "by key")) {
+      return 1;
+    }
+    if (!sort_by_key_and_check<::cl_long, ::cl_ulong>(myQueue, few_longs,
+                                                      "64-bit by key")) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,79 @@
+#include "../common.h"
+#include <SYCL/detail/kernel_cache.h>
+
+// Kernels working on a window of a large buffer
+
+using namespace cl::sycl;
+
+int main() {
+  static const size_t N = 1 << 20;
+  static const size_t offset = 4096;
+  static const size_t window = 1024;
+
+  {
+    queue myQueue;
+
+    buffer<int> data(N);
+    {
+      auto d = data.get_access<access::mode::discard_write,
+                               access::target::host_buffer>();
+      for (size_t i = 0; i < N; ++i) {
+        d[i] = -1;
+      }
+    }
+
+    // Only the window is transferred to the device and back
+    myQueue.submit([&](handler& cgh) {
+      auto w = data.get_access<access::mode::read_write>(cgh, range<1>(offset),
+                                                          range<1>(window));
+      cgh.parallel_for<class fill_window>(range<1>(window),
+                                          [=](id<1> i) { w[i] = i; });
+    });
+
+    auto d = data.get_access<access::mode::read, access::target::host_buffer>();
+    for (size_t i = 0; i < N; ++i) {
+      int expected = -1;
+      if (i >= offset && i < offset + window) {
+        expected = static_cast<int>(i - offset);
+      }
+      if (d[i] != expected) {
+        debug() << i << "expected" << expected << "actual" << d[i];
+        return 1;
+      }
+    }
+  }
+
+  {
+    // Moving the window reuses the kernel, the offset is an argument
+    queue myQueue;
+    static const size_t windows = 8;
+
+    buffer<int> data(window * (windows + 1));
+    detail::kernel_cache::clear();
+    for (size_t w = 1; w <= windows; ++w) {
+      myQueue.submit([&](handler& cgh) {
+        auto acc = data.get_access<access::mode::discard_write>(
+            cgh, range<1>(w * window), range<1>(window));
+        int value = static_cast<int>(w);
+        cgh.parallel_for<class moving_window>(
+            range<1>(window), [=](id<1> i) { acc[i] = value; });
+      });
+    }
+    auto compiled = detail::kernel_cache::size();
+    if (compiled != 1) {
+      debug() << "moving the window compiled" << compiled << "kernels";
+      return 1;
+    }
+
+    auto d = data.get_access<access::mode::read, access::target::host_buffer>();
+    for (size_t i = window; i < window * (windows + 1); ++i) {
+      int expected = static_cast<int>(i / window);
+      if (d[i] != expected) {
+        debug() << i << "expected" << expected << "actual" << d[i];
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,83 @@
+#include "../common.h"
+
+// Reductions through handler::reduce, each in a single command group
+
+using namespace cl::sycl;
+
+int main() {
+  static const size_t N = 100000;
+
+  {
+    queue myQueue;
+
+    buffer<float> values(N);
+    buffer<int> integers(N);
+    {
+      auto vh = values.get_access<access::mode::discard_write,
+                                  access::target::host_buffer>();
+      auto ih = integers.get_access<access::mode::discard_write,
+                                    access::target::host_buffer>();
+      for (size_t i = 0; i < N; ++i) {
+        vh[i] = static_cast<float>(i % 10);
+        ih[i] = static_cast<int>((i * 7919) % 100003) - 50000;
+      }
+    }
+
+    buffer<float> sum(1);
+    buffer<int> smallest(1);
+    buffer<int> largest(1);
+    buffer<int> parity(1);
+
+    myQueue.submit([&](handler& cgh) { cgh.reduce(values, sum, plus()); });
+    myQueue.submit(
+        [&](handler& cgh) { cgh.reduce(integers, smallest, minimum()); });
+    myQueue.submit(
+        [&](handler& cgh) { cgh.reduce(integers, largest, maximum()); });
+    myQueue.submit([&](handler& cgh) {
+      cgh.reduce(integers, parity, [](int1 x, int1 y) { return x ^ y; }, 0);
+    });
+
+    float expected_sum = 0;
+    int expected_min = std::numeric_limits<int>::max();
+    int expected_max = std::numeric_limits<int>::lowest();
+    int expected_parity = 0;
+    {
+      auto vh =
+          values.get_access<access::mode::read, access::target::host_buffer>();
+      auto ih = integers
+                    .get_access<access::mode::read, access::target::host_buffer>();
+      for (size_t i = 0; i < N; ++i) {
+        expected_sum += vh[i];
+        expected_min = std::min(expected_min, static_cast<int>(ih[i]));
+        expected_max = std::max(expected_max, static_cast<int>(ih[i]));
+        expected_parity ^= ih[i];
+      }
+    }
+
+    auto sh = sum.get_access<access::mode::read, access::target::host_buffer>();
+    if (sh[0] != expected_sum) {
+      debug() << "sum expected" << expected_sum << "actual" << sh[0];
+      return 1;
+    }
+    auto mh =
+        smallest.get_access<access::mode::read, access::target::host_buffer>();
+    if (mh[0] != expected_min) {
+      debug() << "minimum expected" << expected_min << "actual" << mh[0];
+      return 1;
+    }
+    auto xh =
+        largest.get_access<access::mode::read, access::target::host_buffer>();
+    if (xh[0] != expected_max) {
+      debug() << "maximum expected" << expected_max << "actual" << xh[0];
+      return 1;
+    }
+    auto ph =
+        parity.get_access<access::mode::read, access::target::host_buffer>();
+    if (ph[0] != expected_parity) {
+      debug() << "xor expected" << expected_parity << "actual" << ph[0];
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,49 @@
+#include "../common.h"
+
+#include <string>
+
+// Runtime statistics are kept under the names the user gives the kernels
+
+using namespace cl::sycl;
+
+int main() {
+  static const size_t N = 256;
+  static const int submits = 3;
+
+  queue myQueue;
+  buffer<int> data(N);
+
+  for (int s = 0; s < submits; ++s) {
+    myQueue.submit([&](handler& cgh) {
+      auto d = data.get_access<access::mode::discard_write>(cgh);
+      cgh.parallel_for<class named_for_stats>(range<1>(N),
+                                              [=](id<1> i) { d[i] = s; });
+    });
+  }
+  myQueue.wait();
+
+  auto stats = myQueue.get_runtime_stats();
+  bool found = false;
+  for (auto& k : stats.kernels) {
+    if (k.first.find("_sycl_kernel") != std::string::npos) {
+      debug() << "statistics kept under the generated name" << k.first;
+      return 1;
+    }
+    if (k.first.find("named_for_stats") == std::string::npos) {
+      continue;
+    }
+    found = true;
+    auto traced = k.second[static_cast<size_t>(runtime_phase::trace)].count;
+    if (traced != submits) {
+      debug() << k.first << "traced" << traced << "times, expected"
+              << submits;
+      return 1;
+    }
+  }
+  if (!found) {
+    debug() << "no statistics for the named kernel";
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,167 @@
+#include "../common.h"
+#include <SYCL/algorithm/scan.h>
+
+// Multi-level scans of 32-bit and 64-bit types,
+// stream compaction and partitioning
+
+using namespace cl::sycl;
+
+template <typename T>
+bool check(buffer<T>& data, const std::vector<T>& expected,
+           const char* name) {
+  auto d = data.template get_access<access::mode::read,
+                                    access::target::host_buffer>();
+  for (size_t i = 0; i < expected.size(); ++i) {
+    if (d[i] != expected[i]) {
+      debug() << name << i << "expected" << expected[i] << "actual" << d[i];
+      return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+  // Not a multiple of any work-group size, scanned in several levels
+  static const size_t N = 300007;
+
+  {
+    queue myQueue;
+
+    buffer<int> input(N);
+    buffer<::cl_int> heads(N);
+    std::vector<int> values(N);
+    std::vector<::cl_int> starts(N);
+    {
+      auto ih = input.get_access<access::mode::discard_write,
+                                 access::target::host_buffer>();
+      auto hh = heads.get_access<access::mode::discard_write,
+                                 access::target::host_buffer>();
+      for (size_t i = 0; i < N; ++i) {
+        values[i] = static_cast<int>((i * 31) % 17) - 8;
+        starts[i] = (i % 1000 == 0 || i % 777 == 5) ? 1 : 0;
+        ih[i] = values[i];
+        hh[i] = starts[i];
+      }
+    }
+
+    std::vector<int> inclusive(N);
+    std::vector<int> exclusive(N);
+    std::vector<int> segmented(N);
+    std::vector<int> segmented_exclusive(N);
+    std::vector<int> largest(N);
+    int sum = 0;
+    int segment_sum = 0;
+    for (size_t i = 0; i < N; ++i) {
+      exclusive[i] = sum;
+      sum += values[i];
+      inclusive[i] = sum;
+      segment_sum = (i == 0 || starts[i] != 0) ? values[i]
+                                               : segment_sum + values[i];
+      segmented_exclusive[i] =
+          (i == 0 || starts[i] != 0) ? 0 : segmented[i - 1];
+      segmented[i] = segment_sum;
+      largest[i] = (i == 0) ? values[i] : std::max(largest[i - 1], values[i]);
+    }
+
+    buffer<int> output(N);
+    inclusive_scan(myQueue, input, output);
+    if (!check(output, inclusive, "inclusive")) {
+      return 1;
+    }
+    exclusive_scan(myQueue, input, output);
+    if (!check(output, exclusive, "exclusive")) {
+      return 1;
+    }
+    inclusive_scan(myQueue, input, output, maximum());
+    if (!check(output, largest, "maximum")) {
+      return 1;
+    }
+    inclusive_segmented_scan(myQueue, input, heads, output);
+    if (!check(output, segmented, "segmented")) {
+      return 1;
+    }
+    exclusive_segmented_scan(myQueue, input, heads, output);
+    if (!check(output, segmented_exclusive, "exclusive segmented")) {
+      return 1;
+    }
+
+    {
+      // The sums stay below 2^24, so they are exact in single precision
+      buffer<float> float_input(N);
+      buffer<float> float_output(N);
+      {
+        auto fh = float_input.get_access<access::mode::discard_write,
+                                         access::target::host_buffer>();
+        for (size_t i = 0; i < N; ++i) {
+          fh[i] = static_cast<float>(values[i]);
+        }
+      }
+      std::vector<float> expected(inclusive.begin(), inclusive.end());
+      inclusive_scan(myQueue, float_input, float_output);
+      if (!check(float_output, expected, "float inclusive")) {
+        return 1;
+      }
+      expected.assign(segmented_exclusive.begin(), segmented_exclusive.end());
+      exclusive_segmented_scan(myQueue, float_input, heads, float_output);
+      if (!check(float_output, expected, "float exclusive segmented")) {
+        return 1;
+      }
+    }
+
+    {
+      // Values that only fit in 64 bits
+      buffer<::cl_long> long_input(N);
+      buffer<::cl_long> long_output(N);
+      std::vector<::cl_long> expected(N);
+      const ::cl_long scale = ::cl_long(1) << 36;
+      {
+        auto lh = long_input.get_access<access::mode::discard_write,
+                                        access::target::host_buffer>();
+        for (size_t i = 0; i < N; ++i) {
+          lh[i] = values[i] * scale;
+          expected[i] = exclusive[i] * scale;
+        }
+      }
+      exclusive_scan(myQueue, long_input, long_output);
+      if (!check(long_output, expected, "64-bit exclusive")) {
+        return 1;
+      }
+    }
+
+    std::vector<int> positives;
+    std::vector<int> partitioned;
+    for (auto v : values) {
+      if (v > 0) {
+        positives.push_back(v);
+      }
+    }
+    partitioned = positives;
+    for (auto v : values) {
+      if (v <= 0) {
+        partitioned.push_back(v);
+      }
+    }
+
+    auto count = copy_if(myQueue, input, output,
+                         [](int1 x) { return x > 0; });
+    if (count != positives.size()) {
+      debug() << "copy_if expected" << positives.size() << "actual" << count;
+      return 1;
+    }
+    if (!check(output, positives, "copy_if")) {
+      return 1;
+    }
+
+    count = partition(myQueue, input, output, [](int1 x) { return x > 0; });
+    if (count != positives.size()) {
+      debug() << "partition expected" << positives.size() << "actual"
+              << count;
+      return 1;
+    }
+    if (!check(output, partitioned, "partition")) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,59 @@
+#include "../common.h"
+
+// Kernels writing disjoint sub-buffers of the same 2D buffer
+
+using namespace cl::sycl;
+
+int main() {
+  static const size_t W = 16;
+  static const size_t H = 8;
+
+  {
+    queue myQueue;
+
+    buffer<int, 2> data(range<2>(W, H));
+    {
+      auto d = data.get_access<access::mode::discard_write,
+                               access::target::host_buffer>();
+      for (size_t x = 0; x < W; ++x) {
+        for (size_t y = 0; y < H; ++y) {
+          d[x][y] = 0;
+        }
+      }
+    }
+
+    // Whole rows alias the memory of the buffer
+    buffer<int, 2> top(data, id<2>(0, 0), range<2>(W, H / 2));
+    // Part of each row is copied in and out
+    buffer<int, 2> block(data, id<2>(2, H / 2), range<2>(4, H / 2));
+
+    myQueue.submit([&](handler& cgh) {
+      auto t = top.get_access<access::mode::write>(cgh);
+      cgh.parallel_for<class fill_top>(range<2>(W, H / 2),
+                                       [=](id<2> i) { t[i] = 1; });
+    });
+    myQueue.submit([&](handler& cgh) {
+      auto b = block.get_access<access::mode::write>(cgh);
+      cgh.parallel_for<class fill_block>(range<2>(4, H / 2),
+                                         [=](id<2> i) { b[i] = 2; });
+    });
+
+    auto d = data.get_access<access::mode::read, access::target::host_buffer>();
+    for (size_t x = 0; x < W; ++x) {
+      for (size_t y = 0; y < H; ++y) {
+        int expected = 0;
+        if (y < H / 2) {
+          expected = 1;
+        } else if (x >= 2 && x < 6) {
+          expected = 2;
+        }
+        if (d[x][y] != expected) {
+          debug() << x << y << "expected" << expected << "actual" << d[x][y];
+          return 1;
+        }
+      }
+    }
+  }
+
+  return 0;
+}
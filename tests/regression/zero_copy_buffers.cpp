@@ -0,0 +1,65 @@
+#include "../common.h"
+
+// A device sharing memory with the host maps buffers
+// instead of copying them between the host and the device
+
+using namespace cl::sycl;
+
+int main() {
+  static const size_t N = 1024;
+
+  {
+    queue myQueue;
+    if (!myQueue.get_device().get_info<info::device::host_unified_memory>()) {
+      debug() << "device doesn't share memory with the host, skipping";
+      return 0;
+    }
+
+    profiler::clear();
+    profiler::enable();
+
+    buffer<int> data(N);
+    {
+      auto h = data.get_access<access::mode::discard_write,
+                               access::target::host_buffer>();
+      for (size_t i = 0; i < N; ++i) {
+        h[i] = static_cast<int>(i);
+      }
+    }
+
+    myQueue.submit([&](handler& cgh) {
+      auto d = data.get_access<access::mode::read_write>(cgh);
+      cgh.parallel_for<class zero_copy_increment>(range<1>(N),
+                                                  [=](id<1> i) { d[i] += 1; });
+    });
+
+    auto h = data.get_access<access::mode::read, access::target::host_buffer>();
+    for (size_t i = 0; i < N; ++i) {
+      if (h[i] != static_cast<int>(i) + 1) {
+        debug() << "index" << i << "expected" << i + 1 << "actual" << h[i];
+        return 1;
+      }
+    }
+  }
+  profiler::disable();
+
+  ::size_t maps = 0;
+  for (auto& r : profiler::get_records()) {
+    if (r.command == profiler_command::write ||
+        r.command == profiler_command::read ||
+        r.command == profiler_command::copy) {
+      debug() << "buffer was copied by a" << r.name << "command of" << r.bytes
+              << "bytes";
+      return 1;
+    }
+    if (r.command == profiler_command::map) {
+      ++maps;
+    }
+  }
+  if (maps == 0) {
+    debug() << "host accessor didn't map the buffer";
+    return 1;
+  }
+
+  return 0;
+}